@@ -0,0 +1,110 @@
+#ifndef L1Trigger_L1TCaloLayer1LUTWriter_SyntheticLUTs_h
+#define L1Trigger_L1TCaloLayer1LUTWriter_SyntheticLUTs_h
+// -*- C++ -*-
+//
+// Package:    L1Trigger/L1TCaloLayer1LUTWriter
+//
+// Fixed CaloParams layer1 parameters and LUT arrays standing in for
+// L1TCaloLayer1FetchLUTs, shared by calol1LUTBenchmark and
+// calol1LUTRegression.  Changing anything here changes their output, and
+// the goldens of calol1LUTRegression in test/golden have to be rewritten.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTDocument.h"
+
+namespace calol1 {
+
+  namespace synthetic {
+
+    // 2015-2016 layout as L1TCaloLayer1FetchLUTs packs it:
+    // 0:9 calibrated ET, 10 FG bit, 11 zero flag, 12:14 log2(ET)
+    inline uint32_t caloWord(uint32_t input, uint32_t fb, double scale) {
+      uint32_t et = std::min<uint32_t>(0xff, std::lround(input*scale));
+      uint32_t log2Et = 0;
+      while ( log2Et < 7 && (et >> (log2Et+1)) != 0 ) ++log2Et;
+      return et | (fb << 10) | ((et == 0 ? 1u : 0u) << 11) | (log2Et << 12);
+    }
+
+    // Phi bin mappings the way CaloParams has them: 18 Minus then 18 Plus
+    // cards, 0 = use the phi independent table, or empty for no phi
+    // dependence at all.  Each detector gets 1 + its largest bin tables.
+    // Scale factors vary with eta and phi bin.
+    inline void synthesize(int firmwareVersion, const std::vector<unsigned int>& ecalPhiBins, const std::vector<unsigned int>& hcalPhiBins,
+                           const std::vector<unsigned int>& hfPhiBins, LUTParameters& parameters, LUTArrays& luts) {
+      auto nTables = [](const std::vector<unsigned int>& phiBins) -> size_t {
+        return 1 + (phiBins.empty() ? 0 : *std::max_element(phiBins.begin(), phiBins.end()));
+      };
+      parameters = LUTParameters();
+      parameters.firmwareVersion = firmwareVersion;
+      parameters.towerLsbSum = 0.5;
+      parameters.ecalScaleETBins = {6, 9, 12, 15, 20, 25, 30, 35, 40, 45, 55, 70, 256};
+      parameters.hcalScaleETBins = parameters.ecalScaleETBins;
+      parameters.hfScaleETBins = {6, 9, 12, 15, 20, 25, 30, 35, 40, 45, 55, 70, 256};
+      parameters.ecalScalePhiBins = ecalPhiBins;
+      parameters.hcalScalePhiBins = hcalPhiBins;
+      parameters.hfScalePhiBins = hfPhiBins;
+      for(size_t i=0; i<parameters.ecalScaleETBins.size()*28*nTables(ecalPhiBins); ++i) {
+        parameters.ecalScaleFactors.push_back(1. + 0.001*(i % 97));
+      }
+      for(size_t i=0; i<parameters.hcalScaleETBins.size()*28*nTables(hcalPhiBins); ++i) {
+        parameters.hcalScaleFactors.push_back(1.2 + 0.002*(i % 89));
+      }
+      for(size_t i=0; i<parameters.hfScaleETBins.size()*12*nTables(hfPhiBins); ++i) {
+        parameters.hfScaleFactors.push_back(1.5 + 0.003*(i % 83));
+      }
+      parameters.hcalFBLUTUpper = std::vector<unsigned long long int>(28, 0xBBBABBBABBBABBBAull);
+      parameters.hcalFBLUTLower = std::vector<unsigned long long int>(28, 0xBBBABBBABBBABBBAull);
+      for(uint32_t i=0; i<4096; ++i) {
+        parameters.secondStageLUT.push_back((i * 2654435761u) >> 8);
+      }
+
+      luts.ecalLUT.resize(nTables(ecalPhiBins));
+      luts.hcalLUT.resize(nTables(hcalPhiBins));
+      luts.hfLUT.resize(nTables(hfPhiBins));
+      for(size_t phi=0; phi<luts.ecalLUT.size(); ++phi) {
+        for(uint32_t iEta=0; iEta<28; ++iEta) {
+          for(uint32_t fb=0; fb<2; ++fb) {
+            for(uint32_t input=0; input<256; ++input) {
+              luts.ecalLUT[phi][iEta][fb][input] = caloWord(input, fb, 1. + 0.01*iEta + 0.003*phi);
+            }
+          }
+        }
+      }
+      for(size_t phi=0; phi<luts.hcalLUT.size(); ++phi) {
+        for(uint32_t iEta=0; iEta<28; ++iEta) {
+          for(uint32_t fb=0; fb<2; ++fb) {
+            for(uint32_t input=0; input<256; ++input) {
+              luts.hcalLUT[phi][iEta][fb][input] = caloWord(input, fb, 1.2 + 0.02*iEta + 0.005*phi);
+            }
+          }
+        }
+      }
+      for(size_t phi=0; phi<luts.hfLUT.size(); ++phi) {
+        for(uint32_t hfEta=0; hfEta<12; ++hfEta) {
+          for(uint32_t input=0; input<256; ++input) {
+            luts.hfLUT[phi][hfEta][input] = std::min<uint32_t>(0xff, std::lround(input*(1.5 + 0.05*hfEta + 0.004*phi)));
+          }
+        }
+      }
+      luts.hcalFBLUT = parameters.hcalFBLUTUpper;
+    }
+
+    // nPhiBins (0-36) distinct bins, card i using bin 1 + i % nPhiBins, the same for every detector
+    inline void synthesize(int firmwareVersion, uint32_t nPhiBins, LUTParameters& parameters, LUTArrays& luts) {
+      std::vector<unsigned int> phiBins;
+      if ( nPhiBins > 0 ) {
+        for(uint32_t i=0; i<36; ++i) phiBins.push_back(1 + i % nPhiBins);
+      }
+      synthesize(firmwareVersion, phiBins, phiBins, phiBins, parameters, luts);
+    }
+
+  }
+
+}
+
+#endif
@@ -0,0 +1,545 @@
+// -*- C++ -*-
+//
+// Package:    L1Trigger/L1TCaloLayer1LUTWriter
+// Program:    calol1LUTBenchmark
+//
+// Times luts.xml generation without conditions access: synthetic
+// CaloParams layer1 parameters and LUT arrays (up to 36 distinct phi
+// bins per detector) go through the same LUTDocument code as
+// L1TCaloLayer1LUTWriter, e.g.
+//   calol1LUTBenchmark -f 3 -p 36 -t 1 -n 5 -o bench.xml
+// Stages reported, best and mean over the iterations:
+//   fetch   build the synthetic LUT arrays, stands in for L1TCaloLayer1FetchLUTs
+//   repack  hardware word rearrangement alone over all tables
+//   format  render all tables to row text (repack included)
+//   hash    md5checksum of every context
+//   emit    xmlTextWriter calls for the whole document
+//   flush   closing the writer, i.e. the last buffer and the file
+// followed by the 16 bit row order packing of all tables (as written by
+// the binary format) with the per cell loop it replaced and with each
+// LUTPacking kernel the CPU supports, checked to agree with the loop,
+// the row text of all those tables through std::stringstream (as before
+// SWATCHFormatter) and through SWATCHFormatter, checked to be the same,
+// the comparison of every phi bin table with the phi independent one
+// (differingRows) with each kernel, and the cost of the processors and CTP7 context digests with each
+// LUTChecksum algorithm, tables already rendered.  Last the streamed
+// writeXML (-r rows per chunk, -d chunks in flight) against
+// prepare + writeXML, both from a fresh document to the closed file,
+// each through xmlTextWriter and through SWATCHXMLEmitter, after checking
+// that the emitter writes the same bytes as xmlTextWriter for every
+// firmware version, and the split output (one file per context, written
+// concurrently) next to them.  Then the size and write time of the
+// document with deltaContexts against the full one, read back with
+// LUTXMLLoader to the same tables and checksums.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <libxml/xmlwriter.h>
+
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/CompressedXMLOutput.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTDocument.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTPacking.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTSplitWriter.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTXMLLoader.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/SWATCHFormatter.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/SWATCHXMLEmitter.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/bin/SyntheticLUTs.h"
+
+using namespace calol1;
+using calol1::synthetic::synthesize;
+
+namespace {
+
+  void usage() {
+    std::cerr << "Usage: calol1LUTBenchmark [-f FIRMWAREVERSION] [-p NPHIBINS] [-t NTHREADS] [-n NITERATIONS]\n"
+              << "                          [-c none|gzip|zstd] [-o FILE.xml] [-r CHUNKROWS] [-d DEPTH]\n"
+              << "NPHIBINS distinct phi bins per detector (0-36, default 36),\n"
+              << "NTHREADS as numberOfThreads of L1TCaloLayer1LUTWriter (default 1)\n";
+  }
+
+  // Just the firmware word rearrangement, whole tables at a time
+  uint64_t repack(const LUTArrays& luts, int firmwareVersion, std::vector<CaloLUT>& caloWords, std::vector<HFLUTWords>& hfWords) {
+    caloWords.resize(luts.ecalLUT.size() + luts.hcalLUT.size());
+    hfWords.resize(luts.hfLUT.size());
+    size_t i{0};
+    for(const auto& lut : luts.ecalLUT) repackCaloLUT(lut, firmwareVersion, caloWords[i++]);
+    for(const auto& lut : luts.hcalLUT) repackCaloLUT(lut, firmwareVersion, caloWords[i++]);
+    for(size_t j=0; j<luts.hfLUT.size(); ++j) repackHFLUT(luts.hfLUT[j], firmwareVersion, hfWords[j]);
+    // Keeps the loops from being optimized away
+    uint64_t sum{0};
+    for(const auto& words : caloWords) sum += words[0][0][0] + words[27][1][255];
+    for(const auto& words : hfWords) sum += words[3][11][255];
+    return sum;
+  }
+
+  // Row order 16 bit words cell by cell, the way LUTBinaryWriter did it
+  // before LUTPacking.  Returns false on a word above 16 bits.
+  bool packLoop(const LUTArrays& luts, int firmwareVersion, std::vector<uint16_t>& packed) {
+    packed.clear();
+    std::vector<const CaloLUT *> caloLUTs;
+    for(const auto& lut : luts.ecalLUT) caloLUTs.push_back(&lut);
+    for(const auto& lut : luts.hcalLUT) caloLUTs.push_back(&lut);
+    for(const CaloLUT * lut : caloLUTs) {
+      for(uint32_t fb = 0; fb < 2; fb++) {
+        for(uint32_t input = 0; input <= 0xFF; input++) {
+          for(int iEta=1; iEta<=28; ++iEta) {
+            uint32_t value = caloLUTWord((*lut)[iEta-1][fb][input], firmwareVersion);
+            if ( value > 0xFFFF ) return false;
+            packed.push_back(value);
+          }
+        }
+      }
+    }
+    for(const auto& lut : luts.hfLUT) {
+      for(uint32_t fb = 0; fb < 4; fb++) {
+        for(uint32_t hfInput = 0; hfInput <= 0xFF; hfInput++) {
+          for(int hfEta=0; hfEta<12; ++hfEta) {
+            uint32_t value = hfLUTWord(lut[hfEta][hfInput], fb, firmwareVersion);
+            if ( value > 0xFFFF ) return false;
+            packed.push_back(value);
+          }
+        }
+      }
+    }
+    return true;
+  }
+
+  bool packKernel(const LUTArrays& luts, int firmwareVersion, PackKernel kernel, std::vector<uint16_t>& packed) {
+    const size_t nCalo = luts.ecalLUT.size() + luts.hcalLUT.size();
+    packed.resize(nCalo*caloPackedSize + luts.hfLUT.size()*hfPackedSize);
+    uint16_t * out = packed.data();
+    bool ok{true};
+    for(const auto& lut : luts.ecalLUT) { ok &= packCaloLUT(lut, firmwareVersion, out, kernel); out += caloPackedSize; }
+    for(const auto& lut : luts.hcalLUT) { ok &= packCaloLUT(lut, firmwareVersion, out, kernel); out += caloPackedSize; }
+    for(const auto& lut : luts.hfLUT) { ok &= packHFLUT(lut, firmwareVersion, out, kernel); out += hfPackedSize; }
+    return ok;
+  }
+
+  // Bytes going into the processors and context digests
+  size_t hashedBytes(const LUTDocument& document) {
+    auto payload = [](LUTKind kind) -> size_t {
+      switch ( kind ) {
+        case LUTKind::HF: return 4*256*12*sizeof(uint32_t);
+        case LUTKind::HCALFB: return 27*sizeof(uint64_t);
+        default: return 2*256*28*sizeof(uint32_t);
+      }
+    };
+    size_t bytes = 2*(payload(LUTKind::ECAL) + payload(LUTKind::HCAL) + payload(LUTKind::HF) + payload(LUTKind::HCALFB));
+    if ( document.parameters().firmwareVersion > 1 ) bytes += document.parameters().secondStageLUT.size()*sizeof(uint32_t);
+    for(const auto& context : document.cardContexts()) {
+      for(const auto& param : context.params) bytes += payload(param.second.kind);
+    }
+    return bytes;
+  }
+
+  // Every row of packed (as packKernel) as table text, through
+  // std::stringstream as before SWATCHFormatter or through SWATCHFormatter
+  void formatRows(const LUTArrays& luts, const std::vector<uint16_t>& packed, bool stream, std::string& text) {
+    text.clear();
+    SWATCHFormatter formatter;
+    const uint16_t * words = packed.data();
+    auto format = [&](size_t nTables, size_t nRows, size_t nWords) {
+      for(size_t row=0; row<nTables*nRows; ++row, words+=nWords) {
+        if ( stream ) {
+          std::stringstream output;
+          for(size_t i=0; i<nWords; ++i) {
+            if ( i > 0 ) output << ", ";
+            output << std::showbase << std::internal << std::setfill('0') << std::setw(6) << std::hex << words[i];
+          }
+          text += output.str();
+        }
+        else {
+          text += formatter.formatHex(words, nWords, 6);
+        }
+        text += '\n';
+      }
+    };
+    format(luts.ecalLUT.size() + luts.hcalLUT.size(), 2*256, 28);
+    format(luts.hfLUT.size(), 4*256, 12);
+  }
+
+  // A fresh document to the closed files, as L1TCaloLayer1LUTWriter does
+  // with splitOutput
+  bool writeSplit(const LUTParameters& parameters, const LUTArrays& luts, const std::string& fileName, const std::string& compression,
+                  bool direct, int numberOfThreads) {
+    LUTDocument document(parameters, luts);
+    document.prepare(numberOfThreads);
+    LUTSplitWriter split(fileName, compression, 0, direct);
+    return split.write(document, numberOfThreads);
+  }
+
+  // Rows of every phi bin table of packed (as packKernel) differing from
+  // the phi independent table of its detector, or from itself (every
+  // word compared, the case of cards on the phi independent table)
+  size_t differingRows(const LUTArrays& luts, const std::vector<uint16_t>& packed, PackKernel kernel, bool itself, std::vector<uint32_t>& rows) {
+    size_t nRows{0};
+    const uint16_t * table = packed.data();
+    for(size_t n : {luts.ecalLUT.size(), luts.hcalLUT.size()}) {
+      for(size_t phi=1; phi<n; ++phi) {
+        const uint16_t * words = table + phi*caloPackedSize;
+        differingRows(itself ? words : table, words, 2*256, 28, rows, kernel);
+        nRows += rows.size();
+      }
+      table += n*caloPackedSize;
+    }
+    for(size_t phi=1; phi<luts.hfLUT.size(); ++phi) {
+      const uint16_t * words = table + phi*hfPackedSize;
+      differingRows(itself ? words : table, words, 4*256, 12, rows, kernel);
+      nRows += rows.size();
+    }
+    return nRows;
+  }
+
+  // A fresh document to the closed file, as L1TCaloLayer1LUTWriter does
+  // for xmlWriter libxml2 or direct, pipelineChunkRows 0 or chunkRows and deltaContexts
+  bool writeFile(const LUTParameters& parameters, const LUTArrays& luts, const std::string& fileName, const std::string& compression,
+                 bool direct, bool pipeline, int numberOfThreads, unsigned int chunkRows, unsigned int depth, bool delta = false) {
+    LUTDocument document(parameters, luts);
+    document.setDeltaContexts(delta);
+    if ( !pipeline ) document.prepare(numberOfThreads);
+    if ( direct ) {
+      xmlOutputBufferPtr out = newXMLOutputBuffer(fileName, compression, 0);
+      if ( out == nullptr ) return false;
+      SWATCHXMLEmitter emitter(out);
+      bool written = pipeline ? document.writeXML(emitter, numberOfThreads, chunkRows, depth) : document.writeXML(emitter);
+      return emitter.close() >= 0 && written;
+    }
+    xmlTextWriterPtr writer = newXMLTextWriter(fileName, compression, 0);
+    if ( writer == nullptr ) return false;
+    xmlTextWriterSetIndent(writer, 1);
+    xmlTextWriterSetIndentString(writer, BAD_CAST "  ");
+    bool written = pipeline ? document.writeXML(writer, numberOfThreads, chunkRows, depth) : document.writeXML(writer);
+    xmlFreeTextWriter(writer);
+    return written;
+  }
+
+  std::string readFile(const std::string& fileName) {
+    std::ifstream in(fileName, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  }
+
+  const char * stages[] = {"fetch", "repack", "format", "hash", "emit", "flush"};
+  constexpr size_t nStages = sizeof(stages)/sizeof(stages[0]);
+
+}
+
+int main(int argc, char ** argv) {
+  int firmwareVersion = 3;
+  int nPhiBins = 36;
+  int numberOfThreads = 1;
+  int nIterations = 5;
+  std::string compression = "none";
+  std::string fileName = "calol1LUTBenchmark.xml";
+  unsigned int chunkRows = 64;
+  unsigned int depth = 16;
+
+  int opt;
+  while ( (opt = getopt(argc, argv, "f:p:t:n:c:o:r:d:h")) != -1 ) {
+    switch ( opt ) {
+      case 'f': firmwareVersion = std::atoi(optarg); break;
+      case 'p': nPhiBins = std::atoi(optarg); break;
+      case 't': numberOfThreads = std::atoi(optarg); break;
+      case 'n': nIterations = std::atoi(optarg); break;
+      case 'c': compression = optarg; break;
+      case 'o': fileName = optarg; break;
+      case 'r': chunkRows = std::atoi(optarg); break;
+      case 'd': depth = std::atoi(optarg); break;
+      default: usage(); return 1;
+    }
+  }
+  if ( nPhiBins < 0 || nPhiBins > 36 || nIterations < 1 ) {
+    usage();
+    return 1;
+  }
+
+  typedef std::chrono::steady_clock clock;
+  auto ms = [](clock::time_point a, clock::time_point b) { return std::chrono::duration<double, std::milli>(b-a).count(); };
+
+  std::vector< std::vector<double> > timings(nStages);
+  std::vector<CaloLUT> caloWords;
+  std::vector<HFLUTWords> hfWords;
+  uint64_t repackSum{0};
+  off_t bytesWritten{0};
+  size_t nContexts{0}, nTables{0};
+
+  for(int iteration=0; iteration<nIterations; ++iteration) {
+    LUTParameters parameters;
+    LUTArrays luts;
+    auto t0 = clock::now();
+    synthesize(firmwareVersion, nPhiBins, parameters, luts);
+    auto t1 = clock::now();
+    repackSum += repack(luts, firmwareVersion, caloWords, hfWords);
+    auto t2 = clock::now();
+
+    LUTDocument document(parameters, luts);
+    document.prefetch(numberOfThreads);
+    auto t3 = clock::now();
+    document.prepare(numberOfThreads);
+    auto t4 = clock::now();
+
+    xmlTextWriterPtr writer = newXMLTextWriter(fileName, compression, 0);
+    if ( writer == nullptr ) {
+      std::cerr << "Could not open " << fileName << " with compression " << compression << std::endl;
+      return 1;
+    }
+    // Same settings as L1TCaloLayer1LUTWriter
+    xmlTextWriterSetIndent(writer, 1);
+    xmlTextWriterSetIndentString(writer, BAD_CAST "  ");
+    if ( !document.writeXML(writer) ) {
+      std::cerr << "Failed to write " << fileName << std::endl;
+      xmlFreeTextWriter(writer);
+      return 1;
+    }
+    auto t5 = clock::now();
+    xmlFreeTextWriter(writer);
+    auto t6 = clock::now();
+
+    const clock::time_point marks[] = {t0, t1, t2, t3, t4, t5, t6};
+    for(size_t stage=0; stage<nStages; ++stage) {
+      timings[stage].push_back(ms(marks[stage], marks[stage+1]));
+    }
+
+    struct stat info;
+    if ( stat(fileName.c_str(), &info) == 0 ) bytesWritten = info.st_size;
+    nContexts = 1 + document.cardContexts().size();
+    nTables = document.cache().renders();
+  }
+
+  std::cout << "firmwareVersion " << firmwareVersion << ", " << nPhiBins << " phi bins, "
+            << numberOfThreads << " threads, " << nIterations << " iterations\n"
+            << nContexts << " contexts, " << nTables << " distinct tables, "
+            << caloWords.size()*caloLUTSize + hfWords.size()*4*hfLUTSize << " LUT words (checksum " << repackSum << ")\n";
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << std::setw(8) << "stage" << std::setw(12) << "best ms" << std::setw(12) << "mean ms" << "\n";
+  double bestTotal{0}, meanTotal{0};
+  for(size_t stage=0; stage<nStages; ++stage) {
+    const std::vector<double>& t = timings[stage];
+    double best = *std::min_element(t.begin(), t.end());
+    double mean{0};
+    for(double v : t) mean += v/t.size();
+    bestTotal += best;
+    meanTotal += mean;
+    std::cout << std::setw(8) << stages[stage] << std::setw(12) << best << std::setw(12) << mean << "\n";
+  }
+  std::cout << std::setw(8) << "total" << std::setw(12) << bestTotal << std::setw(12) << meanTotal << "\n";
+  std::cout << bytesWritten << " bytes written to " << fileName << " (" << compression << ")" << std::endl;
+
+  // 16 bit packing, per cell loop against the LUTPacking kernels
+  LUTParameters parameters;
+  LUTArrays luts;
+  synthesize(firmwareVersion, nPhiBins, parameters, luts);
+  std::vector<uint16_t> reference, packed;
+  std::vector<double> loopTimes;
+  for(int iteration=0; iteration<nIterations; ++iteration) {
+    auto t0 = clock::now();
+    bool ok = packLoop(luts, firmwareVersion, reference);
+    loopTimes.push_back(ms(t0, clock::now()));
+    if ( !ok ) {
+      std::cerr << "LUT word does not fit in 16 bits" << std::endl;
+      return 1;
+    }
+  }
+  double loopBest = *std::min_element(loopTimes.begin(), loopTimes.end());
+  std::cout << std::setw(8) << "pack" << std::setw(12) << "best ms" << std::setw(12) << "speedup" << "\n";
+  std::cout << std::setw(8) << "loop" << std::setw(12) << loopBest << std::setw(12) << 1. << "\n";
+  for(PackKernel kernel : {PackKernel::Scalar, PackKernel::SSE41, PackKernel::AVX2}) {
+    if ( !packKernelSupported(kernel) ) continue;
+    double best{0};
+    for(int iteration=0; iteration<nIterations; ++iteration) {
+      auto t0 = clock::now();
+      bool ok = packKernel(luts, firmwareVersion, kernel, packed);
+      double t = ms(t0, clock::now());
+      if ( iteration == 0 || t < best ) best = t;
+      if ( !ok || packed != reference ) {
+        std::cerr << packKernelName(kernel) << " packing differs from the per cell loop" << std::endl;
+        return 1;
+      }
+    }
+    std::cout << std::setw(8) << packKernelName(kernel) << std::setw(12) << best << std::setw(12) << loopBest/best << "\n";
+  }
+  std::cout << reference.size()*sizeof(uint16_t) << " packed bytes, default kernel " << packKernelName(bestPackKernel()) << std::endl;
+
+  // Row text, std::stringstream against SWATCHFormatter
+  std::string streamText, formatterText;
+  double formatBest[2] = {0, 0};
+  for(bool stream : {true, false}) {
+    for(int iteration=0; iteration<nIterations; ++iteration) {
+      auto t0 = clock::now();
+      formatRows(luts, reference, stream, stream ? streamText : formatterText);
+      double t = ms(t0, clock::now());
+      if ( iteration == 0 || t < formatBest[stream] ) formatBest[stream] = t;
+    }
+  }
+  if ( formatterText != streamText ) {
+    auto diff = std::mismatch(streamText.begin(), streamText.end(), formatterText.begin(), formatterText.end());
+    std::cerr << "SWATCHFormatter rows differ from std::stringstream at character " << (diff.first - streamText.begin()) << std::endl;
+    return 1;
+  }
+  std::cout << std::setw(8) << "rows" << std::setw(12) << "best ms" << std::setw(12) << "speedup" << "\n";
+  std::cout << std::setw(8) << "sstream" << std::setw(12) << formatBest[1] << std::setw(12) << 1. << "\n";
+  std::cout << std::setw(8) << "SWATCH" << std::setw(12) << formatBest[0] << std::setw(12) << formatBest[1]/formatBest[0] << "\n";
+  std::cout << streamText.size() << " characters of rows, same text from both" << std::endl;
+
+  // Phi bin tables against the phi independent ones, as deltaContexts does
+  std::vector<uint32_t> rows;
+  const size_t nDiffering = differingRows(luts, reference, PackKernel::Scalar, false, rows);
+  const size_t nCaloTables = luts.ecalLUT.size() - 1 + luts.hcalLUT.size() - 1;
+  const size_t nHFTables = luts.hfLUT.size() - 1;
+  const size_t nCompared = nCaloTables*2*256 + nHFTables*4*256;
+  // Both tables read whole
+  const size_t comparedBytes = 2*(nCaloTables*caloPackedSize + nHFTables*hfPackedSize)*sizeof(uint16_t);
+  std::cout << std::setw(8) << "compare" << std::setw(12) << "differ ms" << std::setw(12) << "equal ms" << std::setw(12) << "equal GB/s" << "\n";
+  for(PackKernel kernel : {PackKernel::Scalar, PackKernel::SSE41, PackKernel::AVX2}) {
+    if ( !packKernelSupported(kernel) ) continue;
+    double best[2] = {0, 0};
+    for(bool itself : {false, true}) {
+      for(int iteration=0; iteration<nIterations; ++iteration) {
+        auto t0 = clock::now();
+        const size_t n = differingRows(luts, reference, kernel, itself, rows);
+        double t = ms(t0, clock::now());
+        if ( iteration == 0 || t < best[itself] ) best[itself] = t;
+        if ( n != (itself ? 0 : nDiffering) ) {
+          std::cerr << packKernelName(kernel) << " finds " << n << " differing rows instead of " << (itself ? 0 : nDiffering) << std::endl;
+          return 1;
+        }
+      }
+    }
+    std::cout << std::setw(8) << packKernelName(kernel) << std::setw(12) << best[0] << std::setw(12) << best[1]
+              << std::setw(12) << comparedBytes/(best[1]*1e6) << "\n";
+  }
+  std::cout << nDiffering << " of " << nCompared << " phi bin table rows differ from the phi independent table" << std::endl;
+
+  // Context digests per algorithm, each on a fresh document so nothing is memoized
+  size_t nHashed{0};
+  std::cout << std::setw(8) << "digest" << std::setw(12) << "best ms" << std::setw(12) << "MB/s" << "\n";
+  for(ChecksumAlgorithm algorithm : checksumAlgorithms()) {
+    double best{0};
+    for(int iteration=0; iteration<nIterations; ++iteration) {
+      LUTDocument document(parameters, luts);
+      document.prefetch(numberOfThreads);
+      auto t0 = clock::now();
+      document.computeChecksums(algorithm);
+      double t = ms(t0, clock::now());
+      if ( iteration == 0 || t < best ) best = t;
+      nHashed = hashedBytes(document);
+    }
+    std::cout << std::setw(8) << checksumAlgorithmName(algorithm) << std::setw(12) << best << std::setw(12) << nHashed/(best*1e3) << "\n";
+  }
+  std::cout << nHashed << " bytes hashed per document" << std::endl;
+
+  // SWATCHXMLEmitter conformance: uncompressed bytes against xmlTextWriter
+  const std::string directName = fileName + ".direct";
+  for(int version=1; version<=3; ++version) {
+    LUTParameters versionParameters;
+    LUTArrays versionLUTs;
+    synthesize(version, nPhiBins, versionParameters, versionLUTs);
+    for(bool delta : {false, true}) {
+      for(bool pipeline : {false, true}) {
+        if ( !writeFile(versionParameters, versionLUTs, fileName, "none", false, pipeline, numberOfThreads, chunkRows, depth, delta)
+             || !writeFile(versionParameters, versionLUTs, directName, "none", true, pipeline, numberOfThreads, chunkRows, depth, delta) ) {
+          std::cerr << "Failed to write " << fileName << " or " << directName << std::endl;
+          return 1;
+        }
+        const std::string expected = readFile(fileName);
+        const std::string actual = readFile(directName);
+        if ( actual != expected ) {
+          auto diff = std::mismatch(expected.begin(), expected.end(), actual.begin(), actual.end());
+          std::cerr << "SWATCHXMLEmitter output differs from xmlTextWriter for firmwareVersion " << version
+                    << (pipeline ? " (stream" : " (whole") << (delta ? ", delta)" : ")") << " at byte " << (diff.first - expected.begin())
+                    << ", see " << fileName << " and " << directName << std::endl;
+          return 1;
+        }
+      }
+    }
+  }
+  std::remove(directName.c_str());
+  std::cout << "direct: same bytes as xmlTextWriter for firmwareVersion 1-3, whole and stream, full and delta" << std::endl;
+
+  // Whole XML output, all tables rendered first against the pipeline,
+  // each through xmlTextWriter and SWATCHXMLEmitter
+  std::cout << std::setw(14) << "write" << std::setw(12) << "best ms" << std::setw(12) << "mean ms" << "\n";
+  for(bool direct : {false, true}) {
+    for(int mode : {0, 1, 2}) {
+      const bool pipeline = ( mode == 1 );
+      std::vector<double> t;
+      for(int iteration=0; iteration<nIterations; ++iteration) {
+        auto t0 = clock::now();
+        bool written = ( mode == 2 )
+          ? writeSplit(parameters, luts, fileName, compression, direct, numberOfThreads)
+          : writeFile(parameters, luts, fileName, compression, direct, pipeline, numberOfThreads, chunkRows, depth);
+        t.push_back(ms(t0, clock::now()));
+        if ( !written ) {
+          std::cerr << "Failed to write " << fileName << std::endl;
+          return 1;
+        }
+      }
+      double mean{0};
+      for(double v : t) mean += v/t.size();
+      const char * modes[] = {"whole", "stream", "split"};
+      const std::string name = std::string(modes[mode]) + (direct ? " direct" : " libxml2");
+      std::cout << std::setw(14) << name << std::setw(12) << *std::min_element(t.begin(), t.end()) << std::setw(12) << mean << "\n";
+    }
+  }
+  std::cout << "stream: " << chunkRows << " rows per chunk, at most " << depth << " chunks in flight" << std::endl;
+
+  // deltaContexts against the full document, both direct and whole
+  const std::string deltaName = fileName + ".delta";
+  std::cout << std::setw(14) << "contexts" << std::setw(12) << "best ms" << std::setw(12) << "bytes" << "\n";
+  off_t fullBytes{0};
+  for(bool delta : {false, true}) {
+    const std::string name = delta ? deltaName : fileName;
+    double best{0};
+    for(int iteration=0; iteration<nIterations; ++iteration) {
+      auto t0 = clock::now();
+      bool written = writeFile(parameters, luts, name, compression, true, false, numberOfThreads, chunkRows, depth, delta);
+      double t = ms(t0, clock::now());
+      if ( iteration == 0 || t < best ) best = t;
+      if ( !written ) {
+        std::cerr << "Failed to write " << name << std::endl;
+        return 1;
+      }
+    }
+    struct stat info;
+    const off_t bytes = ( stat(name.c_str(), &info) == 0 ) ? info.st_size : 0;
+    if ( !delta ) fullBytes = bytes;
+    std::cout << std::setw(14) << (delta ? "delta" : "full") << std::setw(12) << best << std::setw(12) << bytes;
+    if ( delta && fullBytes > 0 ) std::cout << "  (" << 100.*bytes/fullBytes << "% of full)";
+    std::cout << "\n";
+  }
+  LUTXMLLoader full, delta;
+  if ( !full.load(fileName) || !delta.load(deltaName) ) {
+    std::cerr << "Failed to read back " << fileName << " or " << deltaName << ": " << full.error() << delta.error() << std::endl;
+    return 1;
+  }
+  bool same = full.contexts().size() == delta.contexts().size() && delta.verified();
+  for(size_t i=0; same && i<full.contexts().size(); ++i) {
+    const LUTXMLLoader::Context& a = full.contexts()[i];
+    const LUTXMLLoader::Context& b = delta.contexts()[i];
+    same = a.id == b.id && a.ecal == b.ecal && a.hcal == b.hcal && a.hf == b.hf && a.hcalFB == b.hcalFB
+      && a.secondStageLUT == b.secondStageLUT && a.md5checksum == b.md5checksum;
+  }
+  if ( !same ) {
+    std::cerr << deltaName << " does not read back to the tables and checksums of " << fileName << std::endl;
+    return 1;
+  }
+  std::remove(deltaName.c_str());
+  std::cout << "delta: same tables and checksums as the full document once read back with LUTXMLLoader" << std::endl;
+
+  return 0;
+}
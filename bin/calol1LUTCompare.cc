@@ -0,0 +1,43 @@
+// -*- C++ -*-
+//
+// Package:    L1Trigger/L1TCaloLayer1LUTWriter
+// Program:    calol1LUTCompare
+//
+// Checks that a luts.xml (possibly .gz) is exactly an expected one, e.g.
+// the output of a modified writer against that of a reference build:
+//   calol1LUTCompare golden/luts.xml luts.xml
+// Identical files are settled by a block compare; otherwise the first
+// differing node is reported with its context, param, row and column,
+// see LUTXMLComparison.h.  Use calol1LUTDiff for what changed in the
+// LUT cells.
+// Exits with 0 if the documents are the same, 1 if they differ, 2 on error.
+//
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTXMLComparison.h"
+
+using namespace calol1;
+
+int main(int argc, char ** argv) {
+  if ( argc != 3 ) {
+    std::cerr << "Usage: calol1LUTCompare EXPECTED ACTUAL\n"
+              << "EXPECTED and ACTUAL are luts.xml or luts.xml.gz files\n";
+    return 2;
+  }
+
+  typedef std::chrono::steady_clock clock;
+  auto t0 = clock::now();
+  LUTXMLComparison comparison(argv[1], argv[2]);
+  auto t1 = clock::now();
+
+  comparison.print(std::cout);
+  std::cerr << std::fixed << std::setprecision(1)
+            << "compared in " << std::chrono::duration<double, std::milli>(t1-t0).count() << " ms" << std::endl;
+
+  if ( comparison.result() == LUTXMLComparison::Result::Error ) return 2;
+  return comparison.passed() ? 0 : 1;
+}
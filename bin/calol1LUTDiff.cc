@@ -0,0 +1,89 @@
+// -*- C++ -*-
+//
+// Package:    L1Trigger/L1TCaloLayer1LUTWriter
+// Program:    calol1LUTDiff
+//
+// Reports which LUT cells differ between two LUT outputs, luts.xml
+// (possibly .gz) or luts.bin of L1TCaloLayer1LUTWriter, e.g.
+//   calol1LUTDiff -j diff.json luts_2023.xml luts_2024.xml
+// One line per changed (context, table): changed cells, per iEta, and
+// the first changed (fb, input, iEta) cells, see LUTDiff.h.  Both files
+// are loaded concurrently and the tables compared in parallel.
+// Exits with 0 if the LUTs are the same, 1 if they differ, 2 on error.
+//
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include <unistd.h>
+
+#include "tbb/parallel_invoke.h"
+#include "tbb/task_arena.h"
+
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTDiff.h"
+
+using namespace calol1;
+
+namespace {
+
+  void usage() {
+    std::cerr << "Usage: calol1LUTDiff [-t NTHREADS] [-n NCELLS] [-j FILE.json] BEFORE AFTER\n"
+              << "BEFORE and AFTER are luts.xml, luts.xml.gz or luts.bin files,\n"
+              << "NTHREADS 0 for all available (default), NCELLS changed cells listed per table (default 8)\n";
+  }
+
+}
+
+int main(int argc, char ** argv) {
+  int numberOfThreads = 0;
+  size_t maxCells = 8;
+  std::string jsonName;
+
+  int opt;
+  while ( (opt = getopt(argc, argv, "t:n:j:h")) != -1 ) {
+    switch ( opt ) {
+      case 't': numberOfThreads = std::atoi(optarg); break;
+      case 'n': maxCells = std::atoi(optarg); break;
+      case 'j': jsonName = optarg; break;
+      default: usage(); return 2;
+    }
+  }
+  if ( argc - optind != 2 ) {
+    usage();
+    return 2;
+  }
+  const std::string beforeName = argv[optind];
+  const std::string afterName = argv[optind+1];
+
+  typedef std::chrono::steady_clock clock;
+  auto ms = [](clock::time_point a, clock::time_point b) { return std::chrono::duration<double, std::milli>(b-a).count(); };
+
+  auto t0 = clock::now();
+  LUTTableSet before, after;
+  bool loadedBefore{false}, loadedAfter{false};
+  tbb::task_arena arena(numberOfThreads > 0 ? numberOfThreads : static_cast<int>(tbb::task_arena::automatic));
+  arena.execute([&]() {
+    tbb::parallel_invoke([&]() { loadedBefore = before.load(beforeName); },
+                         [&]() { loadedAfter = after.load(afterName); });
+  });
+  if ( !loadedBefore || !loadedAfter ) {
+    std::cerr << (loadedBefore ? after.error() : before.error()) << std::endl;
+    return 2;
+  }
+  auto t1 = clock::now();
+  LUTDiff diff(before, after, numberOfThreads, maxCells);
+  auto t2 = clock::now();
+
+  diff.print(std::cout);
+  if ( !jsonName.empty() && !diff.writeJSON(jsonName) ) {
+    std::cerr << "Failed to write " << jsonName << std::endl;
+    return 2;
+  }
+  std::cerr << std::fixed << std::setprecision(1)
+            << "loaded in " << ms(t0, t1) << " ms, compared in " << ms(t1, t2) << " ms" << std::endl;
+
+  return diff.identical() ? 0 : 1;
+}
@@ -0,0 +1,176 @@
+// -*- C++ -*-
+//
+// Package:    L1Trigger/L1TCaloLayer1LUTWriter
+// Program:    calol1LUTFromSnapshot
+//
+// Writes the LUT files of L1TCaloLayer1LUTWriter from the snapshot it
+// wrote with snapshotFileName (see LUTSnapshot.h), without cmsRun, a
+// Global Tag, geometry or the HCAL transcoder, e.g.
+//   calol1LUTFromSnapshot -o luts.xml -H hcalScale.txt luts.snapshot
+// The options mirror those of the module and give the same bytes:
+//   -o fileName, -c compression, -l compressionLevel, -w xmlWriter,
+//   -s splitOutput, -r pipelineChunkRows, -d pipelineDepth,
+//   -b binaryFileName, -H hcalScaleFileName, -B hcalScaleBinaryFileName,
+//   -t numberOfThreads, -D deltaContexts
+// The extra checksums are those the module wrote.  Each stage is timed.
+//
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include <unistd.h>
+
+#include <libxml/xmlwriter.h>
+
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/CompressedXMLOutput.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTDocument.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTSnapshot.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTSplitWriter.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/SWATCHXMLEmitter.h"
+
+using namespace calol1;
+
+namespace {
+
+  void usage() {
+    std::cerr << "Usage: calol1LUTFromSnapshot [-o FILE.xml] [-c none|gzip|zstd] [-l LEVEL] [-w libxml2|direct] [-s]\n"
+              << "                             [-r CHUNKROWS] [-d DEPTH] [-b FILE.bin] [-H HCALSCALE.txt]\n"
+              << "                             [-B HCALSCALE.bin] [-t NTHREADS] [-D] SNAPSHOT\n"
+              << "Options as the L1TCaloLayer1LUTWriter parameters, NTHREADS 0 for all available (default)\n";
+  }
+
+  // As L1TCaloLayer1LUTWriter::analyze writes fileName
+  bool writeXML(LUTDocument& document, const std::string& fileName, const std::string& compression, int level,
+                bool direct, int numberOfThreads, unsigned int chunkRows, unsigned int depth) {
+    if ( direct ) {
+      xmlOutputBufferPtr out = newXMLOutputBuffer(fileName, compression, level);
+      if ( out == nullptr ) return false;
+      SWATCHXMLEmitter emitter(out);
+      bool written;
+      if ( chunkRows > 0 ) {
+        written = document.writeXML(emitter, numberOfThreads, chunkRows, depth);
+      }
+      else {
+        document.prepare(numberOfThreads);
+        written = document.writeXML(emitter);
+      }
+      return emitter.close() >= 0 && written;
+    }
+    xmlTextWriterPtr writer = newXMLTextWriter(fileName, compression, level);
+    if ( writer == nullptr ) return false;
+    xmlTextWriterSetIndent(writer, 1);
+    xmlTextWriterSetIndentString(writer, BAD_CAST "  ");
+    bool written;
+    if ( chunkRows > 0 ) {
+      written = document.writeXML(writer, numberOfThreads, chunkRows, depth);
+    }
+    else {
+      document.prepare(numberOfThreads);
+      written = document.writeXML(writer);
+    }
+    xmlFreeTextWriter(writer);
+    return written;
+  }
+
+}
+
+int main(int argc, char ** argv) {
+  std::string fileName = "luts.xml";
+  std::string compression = "none";
+  int compressionLevel = 0;
+  std::string xmlWriter = "libxml2";
+  bool splitOutput = false;
+  unsigned int chunkRows = 0;
+  unsigned int depth = 16;
+  std::string binaryFileName;
+  std::string hcalScaleFileName;
+  std::string hcalScaleBinaryFileName;
+  int numberOfThreads = 0;
+  bool deltaContexts = false;
+
+  int opt;
+  while ( (opt = getopt(argc, argv, "o:c:l:w:sr:d:b:H:B:t:Dh")) != -1 ) {
+    switch ( opt ) {
+      case 'o': fileName = optarg; break;
+      case 'c': compression = optarg; break;
+      case 'l': compressionLevel = std::atoi(optarg); break;
+      case 'w': xmlWriter = optarg; break;
+      case 's': splitOutput = true; break;
+      case 'r': chunkRows = std::atoi(optarg); break;
+      case 'd': depth = std::atoi(optarg); break;
+      case 'b': binaryFileName = optarg; break;
+      case 'H': hcalScaleFileName = optarg; break;
+      case 'B': hcalScaleBinaryFileName = optarg; break;
+      case 't': numberOfThreads = std::atoi(optarg); break;
+      case 'D': deltaContexts = true; break;
+      default: usage(); return 1;
+    }
+  }
+  if ( argc - optind != 1 || (xmlWriter != "libxml2" && xmlWriter != "direct") ) {
+    usage();
+    return 1;
+  }
+
+  typedef std::chrono::steady_clock clock;
+  auto ms = [](clock::time_point a, clock::time_point b) { return std::chrono::duration<double, std::milli>(b-a).count(); };
+
+  auto t0 = clock::now();
+  LUTSnapshot snapshot;
+  if ( !snapshot.read(argv[optind], numberOfThreads) ) {
+    std::cerr << snapshot.error() << std::endl;
+    return 1;
+  }
+  auto t1 = clock::now();
+
+  LUTDocument document(snapshot.parameters(), snapshot.luts());
+  document.setExtraChecksums(snapshot.extraChecksums());
+  document.setDeltaContexts(deltaContexts);
+  bool written;
+  if ( splitOutput ) {
+    LUTSplitWriter split(fileName, compression, compressionLevel, xmlWriter == "direct");
+    document.prepare(numberOfThreads);
+    written = split.write(document, numberOfThreads);
+  }
+  else {
+    written = writeXML(document, fileName, compression, compressionLevel, xmlWriter == "direct", numberOfThreads, chunkRows, depth);
+  }
+  if ( !written && splitOutput ) {
+    // LUTSplitWriter has reported which file failed and why
+    std::cerr << "Failed to write the split files of " << fileName << std::endl;
+    return 1;
+  }
+  if ( !written ) {
+    std::cerr << "Failed to write " << fileName << " (compression '" << compression << "', should be none, gzip or zstd)" << std::endl;
+    return 1;
+  }
+  if ( !binaryFileName.empty() && !document.writeBinary(binaryFileName) ) {
+    std::cerr << "Failed to write " << binaryFileName << std::endl;
+    return 1;
+  }
+  auto t2 = clock::now();
+
+  if ( !hcalScaleFileName.empty() || !hcalScaleBinaryFileName.empty() ) {
+    if ( snapshot.hcalScale().empty() ) {
+      std::cerr << argv[optind] << " has no HCAL scale" << std::endl;
+      return 1;
+    }
+    if ( !hcalScaleFileName.empty() && !snapshot.hcalScale().writeText(hcalScaleFileName, numberOfThreads) ) {
+      std::cerr << "Failed to write " << hcalScaleFileName << std::endl;
+      return 1;
+    }
+    if ( !hcalScaleBinaryFileName.empty() && !snapshot.hcalScale().writeBinary(hcalScaleBinaryFileName) ) {
+      std::cerr << "Failed to write " << hcalScaleBinaryFileName << std::endl;
+      return 1;
+    }
+  }
+  auto t3 = clock::now();
+
+  std::cerr << std::fixed << std::setprecision(1)
+            << "run " << snapshot.run() << ", firmware version " << snapshot.parameters().firmwareVersion
+            << ": snapshot read in " << ms(t0, t1) << " ms, LUTs written in " << ms(t1, t2)
+            << " ms, HCAL scale in " << ms(t2, t3) << " ms" << std::endl;
+  return 0;
+}
@@ -0,0 +1,119 @@
+// -*- C++ -*-
+//
+// Package:    L1Trigger/L1TCaloLayer1LUTWriter
+// Program:    calol1LUTLoad
+//
+// Reads a luts.xml (possibly .gz) back into its tables with LUTXMLLoader,
+// one context at a time, and checks every checksum param against the
+// tables read, e.g. a deployed file:
+//   calol1LUTLoad -n 5 -D luts.xml
+// One line per context (tables, checksum), then the best time of -n
+// loads in MB/s of XML and of file, and the peak memory; -D also times
+// a libxml2 DOM parse of the same file for comparison.
+// Exits with 0 if every checksum matches, 1 if not, 2 on error.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <libxml/parser.h>
+
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTXMLLoader.h"
+
+using namespace calol1;
+
+namespace {
+
+  void usage() {
+    std::cerr << "Usage: calol1LUTLoad [-n NLOADS] [-q] [-D] FILE.xml\n"
+              << "NLOADS timed loads (default 1), -q no line per context, -D also time a libxml2 DOM parse\n";
+  }
+
+  // Peak resident memory of the process so far
+  double peakMB() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss/1024.;
+  }
+
+}
+
+int main(int argc, char ** argv) {
+  int nLoads = 1;
+  bool quiet = false;
+  bool dom = false;
+
+  int opt;
+  while ( (opt = getopt(argc, argv, "n:qDh")) != -1 ) {
+    switch ( opt ) {
+      case 'n': nLoads = std::max(1, std::atoi(optarg)); break;
+      case 'q': quiet = true; break;
+      case 'D': dom = true; break;
+      default: usage(); return 2;
+    }
+  }
+  if ( argc - optind != 1 ) {
+    usage();
+    return 2;
+  }
+  const std::string fileName = argv[optind];
+
+  LUTXMLLoader loader;
+  size_t nContexts{0}, nTables{0};
+  double best{0.};
+  for(int i=0; i<nLoads; ++i) {
+    nContexts = nTables = 0;
+    const bool loaded = loader.load(fileName, [&](const LUTXMLLoader::Context& context) {
+      ++nContexts;
+      nTables += context.nTables();
+      if ( i == 0 && !quiet ) {
+        std::cout << std::left << std::setw(12) << context.id << std::right << std::setw(3) << context.nTables() << " tables  md5 "
+                  << (context.md5checksum.empty() ? "none" : context.md5checksum) << "\n";
+      }
+      return true;
+    });
+    if ( !loaded ) {
+      std::cerr << loader.error() << std::endl;
+      return 2;
+    }
+    best = ( i == 0 ) ? loader.seconds() : std::min(best, loader.seconds());
+  }
+  const double memory = peakMB();
+
+  for(const auto& mismatch : loader.mismatches()) {
+    std::cout << mismatch.context << " " << mismatch.id << ": written " << (mismatch.written.empty() ? "nothing" : mismatch.written)
+              << ", tables give " << mismatch.computed << "\n";
+  }
+  const double mb = 1e-6;
+  std::cout << std::fixed << std::setprecision(1)
+            << nContexts << " contexts, " << nTables << " tables, " << loader.checkedChecksums() - loader.mismatches().size()
+            << " of " << loader.checkedChecksums() << " checksums match\n"
+            << "streamed " << loader.bytes()*mb << " MB of XML (" << loader.fileBytes()*mb << " MB file) in " << best*1e3 << " ms"
+            << (nLoads > 1 ? " (best of " + std::to_string(nLoads) + ")" : "") << ": "
+            << loader.bytes()*mb/best << " MB/s of XML, " << loader.fileBytes()*mb/best << " MB/s of file, peak memory " << memory << " MB" << std::endl;
+
+  if ( dom ) {
+    typedef std::chrono::steady_clock clock;
+    auto t0 = clock::now();
+    xmlDocPtr doc = xmlReadFile(fileName.c_str(), nullptr, XML_PARSE_NOBLANKS | XML_PARSE_HUGE);
+    auto t1 = clock::now();
+    if ( doc == nullptr ) {
+      std::cerr << "Could not parse " << fileName << std::endl;
+      return 2;
+    }
+    const double memoryDOM = peakMB();
+    xmlFreeDoc(doc);
+    const double seconds = std::chrono::duration<double>(t1-t0).count();
+    std::cout << "libxml2 DOM parse alone " << seconds*1e3 << " ms: " << loader.bytes()*mb/seconds << " MB/s of XML, peak memory "
+              << memoryDOM << " MB" << std::endl;
+  }
+
+  return loader.mismatches().empty() ? 0 : 1;
+}
@@ -0,0 +1,207 @@
+// -*- C++ -*-
+//
+// Package:    L1Trigger/L1TCaloLayer1LUTWriter
+// Program:    calol1LUTLookup
+//
+// Looks up single entries of a binary LUT file (binaryFileName of
+// L1TCaloLayer1LUTWriter) without loading the whole file, e.g.
+//   calol1LUTLookup luts.bin ecal CTP7_Phi3 minus 12 0 0x40
+// The bench command checks and times the same lookups against a libxml2
+// DOM parse of the matching luts.xml.
+//
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <libxml/parser.h>
+#include <libxml/tree.h>
+
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTBinaryFormat.h"
+
+using namespace calol1;
+using namespace calol1::lutfile;
+
+namespace {
+
+  void usage() {
+    std::cerr << "Usage: calol1LUTLookup FILE.bin info\n"
+              << "       calol1LUTLookup FILE.bin checksum CONTEXT\n"
+              << "       calol1LUTLookup FILE.bin ecal|hcal|hf CONTEXT minus|plus IETA FB INPUT\n"
+              << "       calol1LUTLookup FILE.bin bench FILE.xml [NLOOKUPS]\n"
+              << "CONTEXT is processors or CTP7_Phi<N>\n";
+  }
+
+  struct Lookup {
+    std::string table;
+    uint32_t context;
+    Side side;
+    uint32_t iEta;
+    uint32_t fb;
+    uint32_t input;
+  };
+
+  uint16_t lookup(const LUTBinaryReader& reader, const Lookup& l) {
+    if ( l.table == "ecal" ) return reader.ecal(l.context, l.side, l.iEta, l.fb, l.input);
+    if ( l.table == "hcal" ) return reader.hcal(l.context, l.side, l.iEta, l.fb, l.input);
+    return reader.hf(l.context, l.side, l.iEta, l.fb, l.input);
+  }
+
+  std::string attribute(xmlNodePtr node, const char * name) {
+    xmlChar * value = xmlGetProp(node, BAD_CAST name);
+    std::string result = value ? reinterpret_cast<const char *>(value) : "";
+    xmlFree(value);
+    return result;
+  }
+
+  xmlNodePtr child(xmlNodePtr node, const char * name, const std::string& id="") {
+    for(xmlNodePtr c = node->children; c; c = c->next) {
+      if ( c->type != XML_ELEMENT_NODE || xmlStrcmp(c->name, BAD_CAST name) != 0 ) continue;
+      if ( id.empty() || attribute(c, "id") == id ) return c;
+    }
+    return nullptr;
+  }
+
+  // Same lookup done the way the scripts do it, on the DOM
+  uint16_t lookupXML(xmlNodePtr algo, const Lookup& l) {
+    std::string param = (l.table == "ecal" ? "ECALLUT" : l.table == "hcal" ? "HCALLUT" : "HFLUT");
+    param += (l.side == Side::Plus ? "Plus" : "Minus");
+    xmlNodePtr table = nullptr;
+    xmlNodePtr context = child(algo, "context", contextName(l.context));
+    if ( context ) table = child(context, "param", param);
+    if ( table == nullptr ) table = child(child(algo, "context", "processors"), "param", param);
+    if ( table == nullptr ) throw std::out_of_range("LUT missing from XML");
+
+    uint32_t rowIndex = (l.fb << 8) | l.input;
+    uint32_t column = (l.table == "hf") ? l.iEta-30+1 : l.iEta;
+    for(xmlNodePtr row = child(table, "rows")->children; row; row = row->next) {
+      if ( row->type != XML_ELEMENT_NODE ) continue;
+      if ( rowIndex-- > 0 ) continue;
+      xmlChar * text = xmlNodeGetContent(row);
+      const char * p = reinterpret_cast<const char *>(text);
+      for(uint32_t i=0; i<column; ++i) p = std::strchr(p, ',') + 1;
+      uint16_t value = std::strtoul(p, nullptr, 16);
+      xmlFree(text);
+      return value;
+    }
+    throw std::out_of_range("Row missing from XML");
+  }
+
+  int bench(const std::string& binaryFile, const std::string& xmlFile, size_t nLookups) {
+    std::mt19937 random(1);
+    std::vector<Lookup> lookups;
+    const char * tables[] = {"ecal", "hcal", "hf"};
+    for(size_t i=0; i<nLookups; ++i) {
+      Lookup l;
+      l.table = tables[random() % 3];
+      l.context = random() % nContexts;
+      l.side = static_cast<Side>(random() % 2);
+      l.iEta = (l.table == "hf") ? 30 + random() % 12 : 1 + random() % 28;
+      l.fb = (l.table == "hf") ? random() % 4 : random() % 2;
+      l.input = random() % 256;
+      lookups.push_back(l);
+    }
+
+    typedef std::chrono::steady_clock clock;
+    auto t0 = clock::now();
+    LUTBinaryReader mapped;
+    if ( !mapped.open(binaryFile) ) {
+      std::cerr << mapped.error() << std::endl;
+      return 1;
+    }
+    std::vector<uint16_t> binaryValues;
+    for(const auto& l : lookups) binaryValues.push_back(lookup(mapped, l));
+    auto t1 = clock::now();
+
+    xmlDocPtr doc = xmlReadFile(xmlFile.c_str(), nullptr, XML_PARSE_NOBLANKS);
+    if ( doc == nullptr ) {
+      std::cerr << "Could not parse " << xmlFile << std::endl;
+      return 1;
+    }
+    auto t2 = clock::now();
+    std::vector<uint16_t> xmlValues;
+    for(const auto& l : lookups) xmlValues.push_back(lookupXML(xmlDocGetRootElement(doc), l));
+    auto t3 = clock::now();
+    xmlFreeDoc(doc);
+
+    size_t mismatches = 0;
+    for(size_t i=0; i<lookups.size(); ++i) mismatches += (binaryValues[i] != xmlValues[i]);
+
+    auto ms = [](clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); };
+    std::cout << std::fixed << std::setprecision(3)
+              << nLookups << " lookups\n"
+              << "  binary mmap: open + lookups " << ms(t1-t0) << " ms\n"
+              << "  libxml2 DOM: parse " << ms(t2-t1) << " ms, lookups " << ms(t3-t2) << " ms\n"
+              << "  " << mismatches << " mismatches" << std::endl;
+    return mismatches == 0 ? 0 : 1;
+  }
+
+}
+
+int main(int argc, char ** argv) {
+  if ( argc < 3 ) {
+    usage();
+    return 2;
+  }
+  const std::string command = argv[2];
+
+  LUTBinaryReader reader;
+  if ( !reader.open(argv[1]) ) {
+    std::cerr << reader.error() << std::endl;
+    return 1;
+  }
+
+  try {
+    if ( command == "info" ) {
+      std::cout << "format version " << reader.formatVersion() << ", firmwareVersion " << reader.firmwareVersion()
+                << ", " << reader.sections().size() << " sections\n";
+      for(const auto& section : reader.sections()) {
+        std::cout << "  type " << section.type << " context " << contextName(section.context) << " id " << section.id
+                  << " " << section.size << " bytes\n";
+      }
+      return 0;
+    }
+    if ( command == "checksum" && argc == 4 ) {
+      int context = contextIndex(argv[3]);
+      if ( context < 0 ) {
+        usage();
+        return 2;
+      }
+      std::cout << reader.checksum(context) << std::endl;
+      return 0;
+    }
+    if ( (command == "ecal" || command == "hcal" || command == "hf") && argc == 8 ) {
+      Lookup l;
+      l.table = command;
+      int context = contextIndex(argv[3]);
+      std::string side = argv[4];
+      if ( context < 0 || (side != "minus" && side != "plus") ) {
+        usage();
+        return 2;
+      }
+      l.context = context;
+      l.side = (side == "plus") ? Side::Plus : Side::Minus;
+      l.iEta = std::strtoul(argv[5], nullptr, 0);
+      l.fb = std::strtoul(argv[6], nullptr, 0);
+      l.input = std::strtoul(argv[7], nullptr, 0);
+      std::cout << "0x" << std::hex << std::setw(4) << std::setfill('0') << lookup(reader, l) << std::endl;
+      return 0;
+    }
+    if ( command == "bench" && argc >= 4 ) {
+      size_t nLookups = (argc > 4) ? std::strtoul(argv[4], nullptr, 0) : 1000;
+      return bench(argv[1], argv[3], nLookups);
+    }
+  }
+  catch ( std::out_of_range& e ) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  usage();
+  return 2;
+}
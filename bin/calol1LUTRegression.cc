@@ -0,0 +1,358 @@
+// -*- C++ -*-
+//
+// Package:    L1Trigger/L1TCaloLayer1LUTWriter
+// Program:    calol1LUTRegression
+//
+// Golden output check of the LUT writing code on fixed synthetic inputs
+// (SyntheticLUTs.h): every firmware version with several phi bin
+// patterns, each written the ways L1TCaloLayer1LUTWriter can write it
+// (xmlTextWriter or SWATCHXMLEmitter, whole or streamed), against the
+// goldens checked in under test/golden:
+//   calol1LUTRegression test/golden        # after each change, a few seconds
+//   calol1LUTRegression -w test/golden     # only when the output is meant to change
+// The goldens are digests.txt, the size, md5 and xxh64 of every output
+// and of every context in it, and a few whole contexts,
+// luts_fw<N>_<pattern>_<context>.xml.gz.  A failing output is kept in the
+// -k directory, the contexts that differ are listed, and for those with
+// a whole golden context the first differing param, row and column is
+// printed by LUTXMLComparison.
+// Exits with 0 if everything matches, 1 if not, 2 on error (missing
+// goldens included).
+//
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <libxml/xmlwriter.h>
+
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/CompressedXMLOutput.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTChecksum.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTDocument.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTXMLComparison.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/SWATCHXMLEmitter.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/bin/SyntheticLUTs.h"
+
+using namespace calol1;
+
+namespace {
+
+  void usage() {
+    std::cerr << "Usage: calol1LUTRegression [-w] [-k KEEPDIR] [-t NTHREADS] [-r CHUNKROWS] [-d DEPTH] GOLDENDIR\n"
+              << "-w writes the goldens to GOLDENDIR instead of checking against them, failing outputs are kept\n"
+              << "in KEEPDIR (default .), NTHREADS 0 for all available (default), CHUNKROWS and DEPTH of the\n"
+              << "streamed writes (default 64, 16)\n";
+  }
+
+  struct Pattern {
+    const char * name;
+    std::vector<unsigned int> ecal, hcal, hf;
+  };
+
+  // CaloParams layer1*ScalePhiBins, 18 Minus then 18 Plus cards
+  std::vector<Pattern> patterns() {
+    auto bins = [](unsigned int (*bin)(unsigned int)) {
+      std::vector<unsigned int> phiBins;
+      for(unsigned int card=0; card<36; ++card) phiBins.push_back(bin(card));
+      return phiBins;
+    };
+    std::vector<Pattern> result;
+    // No phi dependence, processors only
+    result.push_back({"none", {}, {}, {}});
+    // Every card on the phi independent table
+    const std::vector<unsigned int> zeros = bins([](unsigned int) { return 0u; });
+    result.push_back({"zeros", zeros, zeros, zeros});
+    // Cards sharing a few tables
+    const std::vector<unsigned int> shared = bins([](unsigned int card) { return 1 + card % 3; });
+    result.push_back({"shared", shared, shared, shared});
+    // A table per card
+    const std::vector<unsigned int> distinct = bins([](unsigned int card) { return 1 + card; });
+    result.push_back({"distinct", distinct, distinct, distinct});
+    // Each detector overriding other cards, some bins unused
+    result.push_back({"mixed",
+                      bins([](unsigned int card) { return card % 3 == 0 ? 1 + card % 2 : 0u; }),
+                      bins([](unsigned int card) { return card % 5 == 0 ? 3u : 0u; }),
+                      bins([](unsigned int card) { return card % 7 == 1 ? 2u : 0u; })});
+    return result;
+  }
+
+  struct Mode {
+    const char * name;
+    bool direct;
+    bool stream;
+  };
+  // The first one writes the goldens
+  const Mode modes[] = {{"libxml2", false, false}, {"direct", true, false}, {"libxml2-stream", false, true}, {"direct-stream", true, true}};
+
+  // Contexts also checked in whole, a few tens of kB each gzipped: the
+  // processors context without and with the second stage LUT, and a card
+  struct WholeContext {
+    int firmwareVersion;
+    const char * pattern;
+    const char * context;
+  };
+  const WholeContext wholeContexts[] = {{1, "mixed", "processors"}, {2, "mixed", "processors"}, {3, "mixed", "CTP7_Phi0"}};
+
+  // A fresh document to the closed file, as L1TCaloLayer1LUTWriter does
+  bool writeFile(const LUTParameters& parameters, const LUTArrays& luts, const std::string& fileName,
+                 const Mode& mode, int numberOfThreads, unsigned int chunkRows, unsigned int depth) {
+    LUTDocument document(parameters, luts);
+    if ( !mode.stream ) document.prepare(numberOfThreads);
+    if ( mode.direct ) {
+      xmlOutputBufferPtr out = newXMLOutputBuffer(fileName, "none", 0);
+      if ( out == nullptr ) return false;
+      SWATCHXMLEmitter emitter(out);
+      bool written = mode.stream ? document.writeXML(emitter, numberOfThreads, chunkRows, depth) : document.writeXML(emitter);
+      return emitter.close() >= 0 && written;
+    }
+    xmlTextWriterPtr writer = newXMLTextWriter(fileName, "none", 0);
+    if ( writer == nullptr ) return false;
+    xmlTextWriterSetIndent(writer, 1);
+    xmlTextWriterSetIndentString(writer, BAD_CAST "  ");
+    bool written = mode.stream ? document.writeXML(writer, numberOfThreads, chunkRows, depth) : document.writeXML(writer);
+    xmlFreeTextWriter(writer);
+    return written;
+  }
+
+  bool readFile(const std::string& fileName, std::string& bytes) {
+    std::ifstream in(fileName, std::ios::binary);
+    if ( !in ) return false;
+    bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return true;
+  }
+
+  struct Digest {
+    size_t bytes{0};
+    std::string md5;
+    std::string xxh64;
+    bool operator==(const Digest& other) const { return bytes == other.bytes && md5 == other.md5 && xxh64 == other.xxh64; }
+  };
+
+  Digest digest(const char * data, size_t size) {
+    Digest result;
+    result.bytes = size;
+    LUTChecksum md5(ChecksumAlgorithm::MD5);
+    md5.update(data, size);
+    result.md5 = md5.digest();
+    LUTChecksum xxh64(ChecksumAlgorithm::XXH64);
+    xxh64.update(data, size);
+    result.xxh64 = xxh64.digest();
+    return result;
+  }
+
+  // Each <context> element of a document as written, from "<context" to
+  // "</context>", by id and in document order
+  std::vector< std::pair<std::string, std::string> > contexts(const std::string& document) {
+    std::vector< std::pair<std::string, std::string> > result;
+    const std::string start = "<context id=\"";
+    const std::string end = "</context>";
+    for(size_t begin = document.find(start); begin != std::string::npos; begin = document.find(start, begin)) {
+      const size_t idEnd = document.find('"', begin + start.size());
+      const size_t close = document.find(end, begin);
+      if ( idEnd == std::string::npos || close == std::string::npos ) break;
+      result.push_back({document.substr(begin + start.size(), idEnd - begin - start.size()),
+                        document.substr(begin, close + end.size() - begin)});
+      begin = close + end.size();
+    }
+    return result;
+  }
+
+  // Case name ("luts_fw1_none"), then "file" or a context id
+  typedef std::map< std::pair<std::string, std::string>, Digest > Digests;
+
+  void addDigests(const std::string& name, const std::string& document, Digests& digests) {
+    digests[{name, "file"}] = digest(document.data(), document.size());
+    for(const auto& context : contexts(document)) {
+      digests[{name, context.first}] = digest(context.second.data(), context.second.size());
+    }
+  }
+
+  const char * digestsFileName = "digests.txt";
+
+  bool writeDigests(const std::string& fileName, const Digests& digests) {
+    std::ofstream out(fileName);
+    out << "# calol1LUTRegression goldens, rewrite with -w: case, \"file\" or context, bytes, md5, xxh64\n";
+    for(const auto& entry : digests) {
+      out << entry.first.first << " " << entry.first.second << " " << entry.second.bytes << " "
+          << entry.second.md5 << " " << entry.second.xxh64 << "\n";
+    }
+    return bool(out);
+  }
+
+  bool readDigests(const std::string& fileName, Digests& digests) {
+    std::ifstream in(fileName);
+    if ( !in ) return false;
+    std::string line;
+    while ( std::getline(in, line) ) {
+      if ( line.empty() || line[0] == '#' ) continue;
+      std::istringstream fields(line);
+      std::string name, context;
+      Digest entry;
+      if ( !(fields >> name >> context >> entry.bytes >> entry.md5 >> entry.xxh64) ) return false;
+      digests[{name, context}] = entry;
+    }
+    return !digests.empty();
+  }
+
+  // A context on its own, as a document LUTXMLComparison can read
+  bool writeContext(const std::string& fileName, const std::string& compression, const std::string& context) {
+    xmlOutputBufferPtr out = newXMLOutputBuffer(fileName, compression, 9);
+    if ( out == nullptr ) return false;
+    const std::string document = "<?xml version=\"1.0\"?>\n<algo id=\"calol1\">\n  " + context + "\n</algo>\n";
+    const bool written = xmlOutputBufferWrite(out, document.size(), document.data()) >= 0;
+    return xmlOutputBufferClose(out) >= 0 && written;
+  }
+
+  bool exists(const std::string& fileName) {
+    struct stat info;
+    return stat(fileName.c_str(), &info) == 0;
+  }
+
+}
+
+int main(int argc, char ** argv) {
+  bool writeGolden = false;
+  std::string keepDirectory = ".";
+  int numberOfThreads = 0;
+  unsigned int chunkRows = 64;
+  unsigned int depth = 16;
+
+  int opt;
+  while ( (opt = getopt(argc, argv, "wk:t:r:d:h")) != -1 ) {
+    switch ( opt ) {
+      case 'w': writeGolden = true; break;
+      case 'k': keepDirectory = optarg; break;
+      case 't': numberOfThreads = std::atoi(optarg); break;
+      case 'r': chunkRows = std::atoi(optarg); break;
+      case 'd': depth = std::atoi(optarg); break;
+      default: usage(); return 2;
+    }
+  }
+  if ( argc - optind != 1 || chunkRows == 0 ) {
+    usage();
+    return 2;
+  }
+  const std::string directory = argv[optind];
+  if ( writeGolden ) mkdir(directory.c_str(), 0755);
+
+  Digests golden;
+  if ( !writeGolden && !readDigests(directory + "/" + digestsFileName, golden) ) {
+    std::cerr << "No golden digests in " << directory << "/" << digestsFileName << ", write them with -w from a reference build" << std::endl;
+    return 2;
+  }
+
+  typedef std::chrono::steady_clock clock;
+  auto ms = [](clock::time_point a, clock::time_point b) { return std::chrono::duration<double, std::milli>(b-a).count(); };
+
+  auto start = clock::now();
+  Digests written;
+  size_t nChecked{0}, nFailed{0};
+  for(int firmwareVersion=1; firmwareVersion<=3; ++firmwareVersion) {
+    for(const Pattern& pattern : patterns()) {
+      LUTParameters parameters;
+      LUTArrays luts;
+      synthetic::synthesize(firmwareVersion, pattern.ecal, pattern.hcal, pattern.hf, parameters, luts);
+      const std::string name = "luts_fw" + std::to_string(firmwareVersion) + "_" + pattern.name;
+
+      for(const Mode& mode : modes) {
+        const std::string output = (writeGolden ? directory : keepDirectory) + "/" + name + "." + mode.name + ".xml";
+        auto t0 = clock::now();
+        std::string document;
+        if ( !writeFile(parameters, luts, output, mode, numberOfThreads, chunkRows, depth) || !readFile(output, document) ) {
+          std::cerr << "Failed to write " << output << std::endl;
+          return 2;
+        }
+        auto t1 = clock::now();
+
+        if ( writeGolden ) {
+          std::remove(output.c_str());
+          addDigests(name, document, written);
+          for(const WholeContext& whole : wholeContexts) {
+            if ( whole.firmwareVersion != firmwareVersion || pattern.name != std::string(whole.pattern) ) continue;
+            for(const auto& context : contexts(document)) {
+              if ( context.first != whole.context ) continue;
+              const std::string fileName = directory + "/" + name + "_" + context.first + ".xml.gz";
+              if ( !writeContext(fileName, "gzip", context.second) ) {
+                std::cerr << "Failed to write " << fileName << std::endl;
+                return 2;
+              }
+              std::cout << "wrote " << fileName << std::endl;
+            }
+          }
+          // The other writers have to agree with it anyway, checked without -w
+          break;
+        }
+
+        Digests actual;
+        addDigests(name, document, actual);
+        auto t2 = clock::now();
+        ++nChecked;
+        std::cout << "fw" << firmwareVersion << " " << std::left << std::setw(9) << pattern.name << std::setw(15) << mode.name << std::right
+                  << std::fixed << std::setprecision(1) << std::setw(8) << ms(t0, t1) << " ms written" << std::setw(8) << ms(t1, t2) << " ms hashed  ";
+        auto expectedFile = golden.find({name, "file"});
+        if ( expectedFile == golden.end() ) {
+          std::cout << "no golden digest" << std::endl;
+          std::cerr << "No golden digest for " << name << " in " << directory << "/" << digestsFileName << std::endl;
+          return 2;
+        }
+        if ( expectedFile->second == actual[{name, "file"}] ) {
+          std::cout << "identical" << std::endl;
+          std::remove(output.c_str());
+          continue;
+        }
+
+        ++nFailed;
+        std::cout << "differs, kept " << output << std::endl;
+        // Contexts of either side whose digest is not the same
+        for(const auto& entry : golden) {
+          if ( entry.first.first != name || entry.first.second == "file" ) continue;
+          if ( actual.count(entry.first) == 0 ) std::cout << "  " << entry.first.second << " missing" << std::endl;
+        }
+        for(const auto& context : contexts(document)) {
+          auto expected = golden.find({name, context.first});
+          if ( expected == golden.end() ) {
+            std::cout << "  " << context.first << " not in the goldens" << std::endl;
+            continue;
+          }
+          if ( expected->second == actual[{name, context.first}] ) continue;
+          std::cout << "  " << context.first << " differs (" << context.second.size() << " bytes, golden " << expected->second.bytes << ")";
+          const std::string wholeGolden = directory + "/" + name + "_" + context.first + ".xml.gz";
+          if ( !exists(wholeGolden) ) {
+            std::cout << std::endl;
+            continue;
+          }
+          const std::string wholeOutput = keepDirectory + "/" + name + "." + mode.name + "_" + context.first + ".xml";
+          if ( !writeContext(wholeOutput, "none", context.second) ) {
+            std::cerr << "Failed to write " << wholeOutput << std::endl;
+            return 2;
+          }
+          std::cout << ": ";
+          LUTXMLComparison(wholeGolden, wholeOutput).print(std::cout);
+        }
+      }
+    }
+  }
+  if ( writeGolden ) {
+    const std::string fileName = directory + "/" + digestsFileName;
+    if ( !writeDigests(fileName, written) ) {
+      std::cerr << "Failed to write " << fileName << std::endl;
+      return 2;
+    }
+    std::cout << "wrote " << fileName << " (" << written.size() << " digests)" << std::endl;
+    return 0;
+  }
+  std::cout << nChecked - nFailed << " of " << nChecked << " outputs match the golden digests in "
+            << std::fixed << std::setprecision(1) << ms(start, clock::now())/1e3 << " s" << std::endl;
+  return nFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,34 @@
+#ifndef L1Trigger_L1TCaloLayer1LUTWriter_CompressedXMLOutput_h
+#define L1Trigger_L1TCaloLayer1LUTWriter_CompressedXMLOutput_h
+// -*- C++ -*-
+//
+// Package:    L1Trigger/L1TCaloLayer1LUTWriter
+// Function:   newXMLTextWriter, newXMLOutputBuffer
+//
+/**\function newXMLTextWriter CompressedXMLOutput.h L1Trigger/L1TCaloLayer1LUTWriter/interface/CompressedXMLOutput.h
+
+   Description: xmlTextWriter on a file, optionally gzip or zstd compressed
+
+   Implementation:
+   gzip uses the compression argument of xmlNewTextWriterFilename.
+   zstd goes through an xmlOutputBuffer whose write callback feeds a
+   ZSTD streaming context, so only one output block is held in memory.
+   In both cases the file is complete only once the writer is freed
+   (the buffer closed).
+*/
+
+#include <string>
+
+#include <libxml/xmlwriter.h>
+
+namespace calol1 {
+
+  // compression is "none", "gzip" or "zstd"; level 0 means the codec default.
+  // Returns NULL if the file cannot be opened or compression is unknown
+  xmlTextWriterPtr newXMLTextWriter(const std::string& fileName, const std::string& compression, int level);
+  // The output under such a writer, for writing without one
+  xmlOutputBufferPtr newXMLOutputBuffer(const std::string& fileName, const std::string& compression, int level);
+
+}
+
+#endif
@@ -0,0 +1,193 @@
+#ifndef L1Trigger_L1TCaloLayer1LUTWriter_FirmwareLayout_h
+#define L1Trigger_L1TCaloLayer1LUTWriter_FirmwareLayout_h
+// -*- C++ -*-
+//
+// Package:    L1Trigger/L1TCaloLayer1LUTWriter
+// Class:      FirmwareLayout
+//
+/**\class FirmwareLayout FirmwareLayout.h L1Trigger/L1TCaloLayer1LUTWriter/interface/FirmwareLayout.h
+
+   Description: Bit layout of the Layer1 hardware LUT words for each firmware version
+
+   Implementation:
+   L1TCaloLayer1FetchLUTs always packs ECAL/HCAL entries the 'old'
+   2015-2016 way; the hardware word is a rearrangement of those bits
+   that depends on the firmware version, and HF words carry the feature
+   bits above the ET.  The layouts are constexpr descriptors, and the
+   repack is a template on the firmware version so that the innermost
+   loop has no branch: a whole table is transformed in one pass over its
+   contiguous std::array storage, which the compiler can vectorize.
+
+   Firmware versions below 1 behave as 1, above 3 as 3.  The layouts are
+   pinned by the static_asserts at the end of this file, and
+   test/testFirmwareLayout.cc checks every 16 bit input against the
+   runtime packing these replaced.
+*/
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "L1Trigger/L1TCaloLayer1/src/L1TCaloLayer1FetchLUTs.hh"
+
+namespace calol1 {
+
+  // One phi bin of the tables filled by L1TCaloLayer1FetchLUTs
+  typedef std::array< std::array< std::array<uint32_t, l1tcalo::nEtBins>, l1tcalo::nCalSideBins >, l1tcalo::nCalEtaBins> CaloLUT;
+  typedef std::array< std::array<uint32_t, l1tcalo::nEtBins>, l1tcalo::nHfEtaBins > HFLUT;
+  // HF words for each of the 4 feature bit combinations
+  typedef std::array<HFLUT, 4> HFLUTWords;
+
+  constexpr size_t caloLUTSize = sizeof(CaloLUT)/sizeof(uint32_t);
+  constexpr size_t hfLUTSize = sizeof(HFLUT)/sizeof(uint32_t);
+  static_assert(caloLUTSize == l1tcalo::nCalEtaBins*l1tcalo::nCalSideBins*l1tcalo::nEtBins, "CaloLUT is not contiguous");
+  static_assert(hfLUTSize == l1tcalo::nHfEtaBins*l1tcalo::nEtBins, "HFLUT is not contiguous");
+
+  // Fields of the ECAL/HCAL words as L1TCaloLayer1FetchLUTs packs them
+  // 0:9   Calibrated ET
+  // 10    'calibrated' FG bit
+  // 11    zero flag
+  // 12:14 log2(calibrated ET)
+  namespace fetchlayout {
+    constexpr uint32_t fgShift = 10;
+    constexpr uint32_t zeroFlagShift = 11;
+    constexpr uint32_t log2Shift = 12;
+    constexpr uint32_t log2Mask = 0b111;
+  }
+
+  struct FirmwareLayout {
+    // ECAL/HCAL words go to the hardware as fetched
+    bool caloPassThrough;
+    // Otherwise where each field goes
+    uint32_t etMask;
+    uint32_t log2Shift;
+    uint32_t zeroFlagShift;
+    uint32_t fgShift;
+    // HF word is output | (fb << hfFeatureShift)
+    uint32_t hfFeatureShift;
+  };
+
+  // 'Old' being 2015-2016 Layer1 firmware
+  constexpr FirmwareLayout firmwareLayoutV1{true, 0, 0, 0, 0, 8};
+  // 2017+ Layer1 firmware where we have turned the whole thing into a
+  // set of LUTs, with some rearrangement of the output bits:
+  // 0:8   9 bit Calibrated ET (for now limit to 8 bit max 0xff)
+  // 9:11  log2(calibrated ET)
+  // 12    zero flag
+  // 13:14 spare bits (undefined currently)
+  // 15    'calibrated' FG bit
+  constexpr FirmwareLayout firmwareLayoutV2{false, 0xff, 9, 12, 15, 8};
+  // HF feature bits moved up by one
+  constexpr FirmwareLayout firmwareLayoutV3{false, 0xff, 9, 12, 15, 9};
+
+  constexpr int layoutVersion(int firmwareVersion)
+  {
+    return firmwareVersion <= 1 ? 1 : (firmwareVersion == 2 ? 2 : 3);
+  }
+
+  constexpr FirmwareLayout firmwareLayout(int firmwareVersion)
+  {
+    return layoutVersion(firmwareVersion) == 1 ? firmwareLayoutV1 :
+           layoutVersion(firmwareVersion) == 2 ? firmwareLayoutV2 : firmwareLayoutV3;
+  }
+
+  template<int FirmwareVersion>
+  constexpr uint32_t caloLUTWord(uint32_t oldValue)
+  {
+    constexpr FirmwareLayout layout = firmwareLayout(FirmwareVersion);
+    if constexpr ( layout.caloPassThrough ) {
+      return oldValue;
+    }
+    else {
+      return (oldValue & layout.etMask)
+        | (((oldValue >> fetchlayout::log2Shift) & fetchlayout::log2Mask) << layout.log2Shift)
+        | (((oldValue >> fetchlayout::zeroFlagShift) & 0b1) << layout.zeroFlagShift)
+        | (((oldValue >> fetchlayout::fgShift) & 0b1) << layout.fgShift);
+    }
+  }
+
+  template<int FirmwareVersion>
+  constexpr uint32_t hfLUTWord(uint32_t output, uint32_t fb)
+  {
+    // HF LUT in emulator does not currently handle
+    // feature bits, instead emulator passes them
+    // unaltered. So this is what we have hardware do
+    return output | (fb << firmwareLayout(FirmwareVersion).hfFeatureShift);
+  }
+
+  // Hardware word for an ECAL or HCAL LUT entry
+  inline uint32_t caloLUTWord(uint32_t oldValue, int firmwareVersion)
+  {
+    switch ( layoutVersion(firmwareVersion) ) {
+      case 1: return caloLUTWord<1>(oldValue);
+      case 2: return caloLUTWord<2>(oldValue);
+      default: return caloLUTWord<3>(oldValue);
+    }
+  }
+
+  // Hardware word for an HF LUT entry with feature bits fb
+  inline uint32_t hfLUTWord(uint32_t output, uint32_t fb, int firmwareVersion)
+  {
+    switch ( layoutVersion(firmwareVersion) ) {
+      case 1: return hfLUTWord<1>(output, fb);
+      case 2: return hfLUTWord<2>(output, fb);
+      default: return hfLUTWord<3>(output, fb);
+    }
+  }
+
+  // Whole table passes, same [iEta][fb][input] shape as the input
+  template<int FirmwareVersion>
+  void repackCaloLUT(const CaloLUT& lut, CaloLUT& words)
+  {
+    const uint32_t * in = lut[0][0].data();
+    uint32_t * out = words[0][0].data();
+    for(size_t i=0; i<caloLUTSize; ++i) {
+      out[i] = caloLUTWord<FirmwareVersion>(in[i]);
+    }
+  }
+
+  template<int FirmwareVersion>
+  void repackHFLUT(const HFLUT& lut, HFLUTWords& words)
+  {
+    const uint32_t * in = lut[0].data();
+    for(uint32_t fb=0; fb<words.size(); ++fb) {
+      uint32_t * out = words[fb][0].data();
+      for(size_t i=0; i<hfLUTSize; ++i) {
+        out[i] = hfLUTWord<FirmwareVersion>(in[i], fb);
+      }
+    }
+  }
+
+  inline void repackCaloLUT(const CaloLUT& lut, int firmwareVersion, CaloLUT& words)
+  {
+    switch ( layoutVersion(firmwareVersion) ) {
+      case 1: repackCaloLUT<1>(lut, words); break;
+      case 2: repackCaloLUT<2>(lut, words); break;
+      default: repackCaloLUT<3>(lut, words); break;
+    }
+  }
+
+  inline void repackHFLUT(const HFLUT& lut, int firmwareVersion, HFLUTWords& words)
+  {
+    switch ( layoutVersion(firmwareVersion) ) {
+      case 1: repackHFLUT<1>(lut, words); break;
+      case 2: repackHFLUT<2>(lut, words); break;
+      default: repackHFLUT<3>(lut, words); break;
+    }
+  }
+
+  // Pin the layouts.  0x7abc: ET 0xbc (0x2bc in 10 bits), FG 0, zero flag 1, log2 7
+  static_assert(caloLUTWord<1>(0x7abc) == 0x7abc, "firmware 1 passes ECAL/HCAL words through");
+  static_assert(caloLUTWord<0>(0xffffffff) == 0xffffffff, "firmware <1 behaves as 1");
+  static_assert(caloLUTWord<2>(0x7abc) == (0xbc | (7u << 9) | (1u << 12)), "firmware 2 ECAL/HCAL layout");
+  static_assert(caloLUTWord<2>(1u << 10) == (1u << 15), "firmware 2 FG bit");
+  static_assert(caloLUTWord<2>(0xffff8300) == 0, "firmware 2 drops ET bits 8:9 and bits above 14");
+  static_assert(caloLUTWord<3>(0x7abc) == caloLUTWord<2>(0x7abc), "firmware 3 ECAL/HCAL layout is firmware 2's");
+  static_assert(caloLUTWord<4>(0x4d5) == caloLUTWord<3>(0x4d5), "firmware >3 behaves as 3");
+  static_assert(hfLUTWord<1>(0x12, 3) == 0x312, "firmware 1 HF feature bits at 8");
+  static_assert(hfLUTWord<2>(0x12, 3) == 0x312, "firmware 2 HF feature bits at 8");
+  static_assert(hfLUTWord<3>(0x12, 3) == 0x612, "firmware 3 HF feature bits at 9");
+
+}
+
+#endif
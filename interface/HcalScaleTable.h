@@ -0,0 +1,76 @@
+#ifndef L1Trigger_L1TCaloLayer1LUTWriter_HcalScaleTable_h
+#define L1Trigger_L1TCaloLayer1LUTWriter_HcalScaleTable_h
+// -*- C++ -*-
+//
+// Package:    L1Trigger/L1TCaloLayer1LUTWriter
+// Class:      HcalScaleTable
+//
+/**\class HcalScaleTable HcalScaleTable.h L1Trigger/L1TCaloLayer1LUTWriter/interface/HcalScaleTable.h
+
+   Description: Decoded HCAL TP compression scale, i.e. what goes into hcalScale.txt
+
+   Implementation:
+   The ET of all 256 compressed values of every trigger tower
+   (iEta -41..41 without 0, iPhi 1..72) is decoded once, one tower per
+   decoder call and eta rings in parallel, and kept until the transcoder
+   changes.  Writing formats eta rings in parallel into memory and then
+   writes the file in one go.
+
+   The text file has one line per tower, "eta %3d phi %2d" followed by
+   the 256 values as "%7.1f".  The binary file is little-endian:
+     magic "CALOL1HS", uint32 format version, uint32 number of eta rings (82),
+     uint32 number of phi bins (72), uint32 number of compressed values (256),
+     float32 [iEta -41..-1,1..41][iPhi 1..72][compressed ET 0..255]
+*/
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace calol1 {
+
+  namespace hcalscale {
+
+    constexpr char magic[8] = {'C', 'A', 'L', 'O', 'L', '1', 'H', 'S'};
+    constexpr uint32_t formatVersion = 1;
+    constexpr int maxEta = 41;
+    constexpr uint32_t nEta = 2*maxEta;
+    constexpr uint32_t nPhi = 72;
+    constexpr uint32_t nEt = 256;
+
+  }
+
+  class HcalScaleTable {
+  public:
+    // Fills values[0..255] with the ET of each compressed value of tower (iEta, iPhi).
+    // Called concurrently for different towers.
+    typedef std::function<void(int iEta, uint32_t iPhi, double * values)> TowerDecoder;
+
+    bool empty() const { return values_.empty(); }
+    void clear() { values_.clear(); }
+
+    // numberOfThreads as for LUTTableCache::prefetch
+    void fill(const TowerDecoder& decoder, int numberOfThreads);
+
+    double value(int iEta, uint32_t iPhi, uint32_t compressedEt) const {
+      return values_[towerIndex(iEta, iPhi)*hcalscale::nEt + compressedEt];
+    }
+
+    bool writeText(const std::string& fileName, int numberOfThreads) const;
+    bool writeBinary(const std::string& fileName) const;
+
+  private:
+    // Eta rings in file order, -41..-1 then 1..41
+    static int ringEta(uint32_t ring) { return ring < uint32_t(hcalscale::maxEta) ? int(ring) - hcalscale::maxEta : int(ring) - hcalscale::maxEta + 1; }
+    static size_t towerIndex(int iEta, uint32_t iPhi) {
+      uint32_t ring = iEta < 0 ? iEta + hcalscale::maxEta : iEta + hcalscale::maxEta - 1;
+      return ring*hcalscale::nPhi + (iPhi-1);
+    }
+
+    std::vector<double> values_;
+  };
+
+}
+
+#endif
@@ -0,0 +1,215 @@
+#ifndef L1Trigger_L1TCaloLayer1LUTWriter_LUTBinaryFormat_h
+#define L1Trigger_L1TCaloLayer1LUTWriter_LUTBinaryFormat_h
+// -*- C++ -*-
+//
+// Package:    L1Trigger/L1TCaloLayer1LUTWriter
+// Class:      LUTBinaryWriter, LUTBinaryReader
+//
+/**\class LUTBinaryWriter LUTBinaryFormat.h L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTBinaryFormat.h
+
+   Description: Compact binary equivalent of luts.xml
+
+   Implementation:
+   Everything is little-endian.  The file is
+
+     header    magic "CALOL1LB", uint32 format version, uint32 firmwareVersion,
+               uint32 number of sections, uint32 reserved, uint64 offset of the index
+     index     one 32 byte SectionEntry per section
+     sections  each starting on an 8 byte boundary
+
+   Contexts are numbered 0 for "processors" and 1+N for "CTP7_Phi<N>".
+   Table sections hold the hardware words, i.e. the XML rows without the
+   Input column, row-major in the same order as the XML:
+     ECALLUT/HCALLUT  uint16 [fb 0..1][input 0..255][iEta 1..28]
+     HFLUT            uint16 [fb 0..3][input 0..255][iEta 30..41]
+     HCALFBLUT        uint64 [iEta 1..28]
+   Vector sections carry the CaloParams layer1 parameters, the Checksum
+   section the same md5checksum (as hex text) written to the XML.
+
+   LUTBinaryReader memory-maps the file and never copies the tables;
+   single entries are looked up in constant time through an index built
+   at open().  Like SWATCH, a CTP7_Phi context without its own table
+   falls back to the one in "processors".
+*/
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTTableRenderer.h"
+
+namespace calol1 {
+
+  namespace lutfile {
+
+    constexpr char magic[8] = {'C', 'A', 'L', 'O', 'L', '1', 'L', 'B'};
+    constexpr uint32_t formatVersion = 1;
+    constexpr size_t headerSize = 32;
+    constexpr size_t sectionAlignment = 8;
+
+    enum class SectionType : uint32_t {
+      ECALLUT = 1,
+      HCALLUT = 2,
+      HFLUT = 3,
+      HCALFBLUT = 4,
+      SecondStageLUT = 5,
+      Vector = 6,
+      Checksum = 7
+    };
+
+    // SectionEntry::id for table sections
+    enum class Side : uint32_t { Minus = 0, Plus = 1 };
+
+    // SectionEntry::id for Vector sections, in luts.xml order
+    enum class VectorId : uint32_t {
+      ECalScaleETBins = 0,
+      ECalScalePhiBins = 1,
+      ECalScaleFactors = 2,
+      HCalScaleETBins = 3,
+      HCalScalePhiBins = 4,
+      HCalScaleFactors = 5,
+      HFScaleETBins = 6,
+      HFScalePhiBins = 7,
+      HFScaleFactors = 8,
+      HCalFBLUTUpper = 9,
+      HCalFBLUTLower = 10,
+      TowerLsbSum = 11
+    };
+
+    struct SectionEntry {
+      uint32_t type;
+      uint32_t context;
+      uint32_t id;
+      uint32_t elementSize;
+      uint64_t offset;
+      uint64_t size;
+    };
+    constexpr size_t sectionEntrySize = 32;
+
+    constexpr uint32_t processorsContext = 0;
+    constexpr uint32_t nContexts = 1 + 18;
+    inline uint32_t cardContext(uint32_t card) { return 1 + card; }
+    // "processors" or "CTP7_Phi<N>" -> context number, -1 if neither
+    int contextIndex(const std::string& name);
+    std::string contextName(uint32_t context);
+
+    constexpr uint32_t caloLUTEntries = 2*256*28;
+    constexpr uint32_t hfLUTEntries = 4*256*12;
+
+    template<typename T>
+    inline void appendLE(std::vector<unsigned char>& out, T value)
+    {
+      for(size_t i=0; i<sizeof(T); ++i) {
+        out.push_back(static_cast<unsigned char>(value >> (8*i)));
+      }
+    }
+
+    template<typename T>
+    inline T readLE(const unsigned char * in)
+    {
+      T value{0};
+      for(size_t i=0; i<sizeof(T); ++i) {
+        value |= static_cast<T>(in[i]) << (8*i);
+      }
+      return value;
+    }
+
+    inline void appendLE(std::vector<unsigned char>& out, double value)
+    {
+      uint64_t bits;
+      std::memcpy(&bits, &value, sizeof(bits));
+      appendLE(out, bits);
+    }
+
+    inline double readDoubleLE(const unsigned char * in)
+    {
+      uint64_t bits = readLE<uint64_t>(in);
+      double value;
+      std::memcpy(&value, &bits, sizeof(value));
+      return value;
+    }
+
+  }
+
+  class LUTBinaryWriter {
+  public:
+    explicit LUTBinaryWriter(int firmwareVersion) : firmwareVersion_(firmwareVersion) {}
+
+    // Tables are repacked exactly as for the XML
+    bool addCaloLUT(lutfile::SectionType type, uint32_t context, lutfile::Side side, const CaloLUT& lut);
+    bool addHFLUT(uint32_t context, lutfile::Side side, const HFLUT& lut);
+    // Already packed hardware words, see LUTPacking.h
+    void addCaloWords(lutfile::SectionType type, uint32_t context, lutfile::Side side, const uint16_t * words);
+    void addHFWords(uint32_t context, lutfile::Side side, const uint16_t * words);
+    void addHCALFBLUT(uint32_t context, lutfile::Side side, const std::vector<unsigned long long int>& lut);
+    void addSecondStageLUT(uint32_t context, const std::vector<uint32_t>& lut);
+    void addVector(uint32_t context, lutfile::VectorId id, const std::vector<int>& vect);
+    void addVector(uint32_t context, lutfile::VectorId id, const std::vector<unsigned int>& vect);
+    void addVector(uint32_t context, lutfile::VectorId id, const std::vector<double>& vect);
+    void addVector(uint32_t context, lutfile::VectorId id, const std::vector<unsigned long long int>& vect);
+    void addChecksum(uint32_t context, const std::string& md5checksum);
+
+    bool write(const std::string& fileName);
+    const std::string& error() const { return error_; }
+
+  private:
+    void addSection(lutfile::SectionType type, uint32_t context, uint32_t id, uint32_t elementSize, std::vector<unsigned char>&& data);
+
+    int firmwareVersion_;
+    std::vector<lutfile::SectionEntry> sections_;
+    std::vector< std::vector<unsigned char> > data_;
+    std::string error_;
+  };
+
+  class LUTBinaryReader {
+  public:
+    LUTBinaryReader() {}
+    ~LUTBinaryReader() { close(); }
+    LUTBinaryReader(const LUTBinaryReader&) = delete;
+    LUTBinaryReader& operator=(const LUTBinaryReader&) = delete;
+
+    // Maps and validates the file, returns false (see error()) if unusable
+    bool open(const std::string& fileName);
+    void close();
+    const std::string& error() const { return error_; }
+
+    uint32_t formatVersion() const { return formatVersion_; }
+    int firmwareVersion() const { return firmwareVersion_; }
+    const std::vector<lutfile::SectionEntry>& sections() const { return sections_; }
+
+    // nullptr if there is no such section
+    const lutfile::SectionEntry * find(lutfile::SectionType type, uint32_t context, uint32_t id=0) const;
+    const unsigned char * data(const lutfile::SectionEntry& section) const { return buffer_ + section.offset; }
+
+    // Single hardware words, iEta as in the XML columns (1-28 or 30-41).
+    // Throw std::out_of_range for arguments outside the table or a
+    // table missing from both the context and "processors"
+    uint16_t ecal(uint32_t context, lutfile::Side side, uint32_t iEta, uint32_t fb, uint32_t input) const;
+    uint16_t hcal(uint32_t context, lutfile::Side side, uint32_t iEta, uint32_t fb, uint32_t input) const;
+    uint16_t hf(uint32_t context, lutfile::Side side, uint32_t iEta, uint32_t fb, uint32_t input) const;
+
+    // Whole sections, decoded
+    std::vector<uint16_t> table(const lutfile::SectionEntry& section) const;
+    std::vector<unsigned long long int> uint64Vector(const lutfile::SectionEntry& section) const;
+    std::vector<double> doubleVector(const lutfile::SectionEntry& section) const;
+    // int vectors (the ScaleETBins) are stored as their two's complement
+    std::vector<uint32_t> uint32Vector(const lutfile::SectionEntry& section) const;
+    std::string checksum(uint32_t context) const;
+
+  private:
+    const unsigned char * tableData(lutfile::SectionType type, uint32_t context, lutfile::Side side) const;
+
+    const unsigned char * buffer_{nullptr};
+    size_t size_{0};
+    std::vector<lutfile::SectionEntry> sections_;
+    // Start of each ECAL/HCAL/HF table by [type][context][side], nullptr if absent
+    std::vector<const unsigned char *> tables_;
+    uint32_t formatVersion_{0};
+    int firmwareVersion_{0};
+    std::string error_;
+  };
+
+}
+
+#endif
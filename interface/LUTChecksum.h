@@ -0,0 +1,71 @@
+#ifndef L1Trigger_L1TCaloLayer1LUTWriter_LUTChecksum_h
+#define L1Trigger_L1TCaloLayer1LUTWriter_LUTChecksum_h
+// -*- C++ -*-
+//
+// Package:    L1Trigger/L1TCaloLayer1LUTWriter
+// Class:      LUTChecksum
+//
+/**\class LUTChecksum LUTChecksum.h L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTChecksum.h
+
+   Description: Incremental digest with a selectable algorithm, lower case hex result
+
+   Implementation:
+   md5      what SWATCH checks, the md5checksum params.  OpenSSL EVP, the
+            MD5_Init/Update/Final API is deprecated.
+   sha256   OpenSSL EVP, for whoever wants a cryptographic digest next to
+            the md5.
+   xxh64    XXH64 (seed 0), non cryptographic and several times faster,
+            meant for internal comparisons.  There is no xxhash external
+            to link against, so it is implemented here; the digest is the
+            canonical big endian XXH64 value, as printed by xxh64sum.
+
+   Callers hand over whole contiguous tables, update() is not meant to
+   be called per row.
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct evp_md_ctx_st;
+
+namespace calol1 {
+
+  enum class ChecksumAlgorithm { MD5, SHA256, XXH64 };
+
+  // "md5", "sha256", "xxh64"
+  const char * checksumAlgorithmName(ChecksumAlgorithm algorithm);
+  // false for an unknown name
+  bool checksumAlgorithmFromName(const std::string& name, ChecksumAlgorithm& algorithm);
+  const std::vector<ChecksumAlgorithm>& checksumAlgorithms();
+
+  class LUTChecksum {
+  public:
+    explicit LUTChecksum(ChecksumAlgorithm algorithm = ChecksumAlgorithm::MD5);
+    ~LUTChecksum();
+    LUTChecksum(const LUTChecksum&) = delete;
+    LUTChecksum& operator=(const LUTChecksum&) = delete;
+
+    void update(const void * data, size_t size);
+    // Hex digest, call once
+    std::string digest();
+
+    ChecksumAlgorithm algorithm() const { return algorithm_; }
+
+  private:
+    struct XXH64State {
+      uint64_t total{0};
+      uint64_t v[4];
+      unsigned char buffer[32];
+      size_t buffered{0};
+    };
+
+    ChecksumAlgorithm algorithm_;
+    evp_md_ctx_st * evp_{nullptr};
+    XXH64State xxh_;
+  };
+
+}
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef L1Trigger_L1TCaloLayer1LUTWriter_LUTDiff_h
+#define L1Trigger_L1TCaloLayer1LUTWriter_LUTDiff_h
+// -*- C++ -*-
+//
+// Package:    L1Trigger/L1TCaloLayer1LUTWriter
+// Class:      LUTTableSet, LUTDiff
+//
+/**\class LUTTableSet LUTDiff.h L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTDiff.h
+
+   Description: Cell by cell comparison of two sets of Layer1 LUTs
+
+   Implementation:
+   LUTTableSet holds the hardware words of every table param of a LUT
+   output, by context and param id (ECALLUTMinus, ..., HCALFBLUTPlus,
+   and layer1SecondStageLUT as a one row table), loaded from a luts.xml
+   (also gzip compressed, streamed by LUTXMLLoader), a binary LUT
+   file, or straight from a LUTDocument.  Like SWATCH, a CTP7_Phi
+   context without a table of its own uses the processors one.
+
+   LUTDiff compares every (context, table) present on either side, each
+   side falling back to its processors table, so a card is only reported
+   where its effective table changes, and a processors change is reported
+   once rather than for every card.  Tables are compared in parallel.
+   The result is a compact summary per table: the number of changed
+   cells, how many per eta column, and the first few changed cells.
+   Only the LUT contents are compared, not the CaloParams vectors or the
+   checksums.
+*/
+
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace calol1 {
+
+  class LUTDocument;
+
+  class LUTTableSet {
+  public:
+    struct Table {
+      uint32_t rows;
+      uint32_t columns;
+      // iEta of the first column (1 ECAL/HCAL/HCALFB, 30 HF, 0 second stage LUT)
+      uint32_t firstEta;
+      // Row-major, rows are fb << 8 | input for ECAL/HCAL/HF
+      std::vector<uint64_t> words;
+    };
+
+    // luts.bin as written with binaryFileName, anything else as XML.
+    // Returns false, see error(), if the file cannot be read
+    bool load(const std::string& fileName);
+    // Tables of a document being written, no file involved
+    void load(const LUTDocument& document);
+
+    // The table a context uses, its own or the processors one; nullptr if neither
+    const Table * find(const std::string& context, const std::string& id) const;
+    // (context, id) of the tables actually present, processors first
+    std::vector< std::pair<std::string, std::string> > keys() const;
+
+    const std::string& error() const { return error_; }
+
+  private:
+    bool loadXML(const std::string& fileName);
+    bool loadBinary(const std::string& fileName);
+
+    std::map< std::pair<std::string, std::string>, Table > tables_;
+    std::string error_;
+  };
+
+  class LUTDiff {
+  public:
+    struct Cell {
+      uint32_t iEta;
+      uint32_t row;
+      uint64_t before;
+      uint64_t after;
+    };
+
+    struct TableDiff {
+      std::string context;
+      std::string id;
+      // On one side only (after the processors fallback), or of another shape
+      bool missingBefore{false};
+      bool missingAfter{false};
+      bool shapeChanged{false};
+      uint64_t cells{0};
+      uint64_t changed{0};
+      // Changed cells per eta column, from the first column
+      uint32_t firstEta{0};
+      std::vector<uint32_t> changedPerEta;
+      // The first maxCells changed cells in row order
+      std::vector<Cell> first;
+    };
+
+    // Tables on up to numberOfThreads threads (0 = all available)
+    LUTDiff(const LUTTableSet& before, const LUTTableSet& after, int numberOfThreads, size_t maxCells = 8);
+
+    bool identical() const { return tables_.empty(); }
+    // Only the tables that differ, in context order
+    const std::vector<TableDiff>& tables() const { return tables_; }
+    size_t comparedTables() const { return compared_; }
+    uint64_t changedCells() const;
+
+    // One line per changed table, e.g.
+    //   CTP7_Phi3 ECALLUTMinus: 1234/14336 cells, iEta 1:20 2:31 ..., first fb 0 input 0x12 iEta 4 0x0123 -> 0x0124
+    void print(std::ostream& out) const;
+    bool writeJSON(const std::string& fileName) const;
+
+  private:
+    std::vector<TableDiff> tables_;
+    size_t compared_{0};
+  };
+
+}
+
+#endif
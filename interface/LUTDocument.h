@@ -0,0 +1,249 @@
+#ifndef L1Trigger_L1TCaloLayer1LUTWriter_LUTDocument_h
+#define L1Trigger_L1TCaloLayer1LUTWriter_LUTDocument_h
+// -*- C++ -*-
+//
+// Package:    L1Trigger/L1TCaloLayer1LUTWriter
+// Class:      LUTDocument
+//
+/**\class LUTDocument LUTDocument.h L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTDocument.h
+
+   Description: The SWATCH luts.xml document (and its binary twin) for one set of Layer1 LUTs
+
+   Implementation:
+   Holds everything L1TCaloLayer1LUTWriter used to do after
+   L1TCaloLayer1FetchLUTs: deciding which CTP7_Phi contexts override
+   which tables, rendering and checksumming the tables through a
+   LUTTableCache, and emitting the XML.  Tables are rendered from the
+   hardware words in a LUTStore, so only the phi bins some card uses are
+   ever repacked.  It only needs the CaloParams
+   values and the LUT arrays, not an EventSetup, so standalone programs
+   (see bin/) drive exactly the same code as the module.
+
+   With delta contexts a CTP7_Phi context only carries the rows of each
+   table that differ from the processors table of the same kind, found
+   with differingRows (LUTPacking.h), as a param of type "table:delta";
+   the Input column gives the row.  SWATCH does not know that type, so
+   such a file cannot be taken for a complete one; LUTXMLLoader rebuilds
+   the tables.  The checksums are those of the complete tables, the same
+   as without delta contexts.
+
+   Rendering, the delta rows and the checksums are all done by the non
+   const members (prepare(), or the pipelined writeXML in one pass); the
+   const ones only read what those left, so a prepared document may be
+   written, verified and diffed by any number of threads at once.
+
+   The document keeps references to the parameters and arrays it was
+   built from, they must outlive it and must not change meanwhile.
+*/
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <libxml/xmlwriter.h>
+
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTMetrics.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTStore.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTTableCache.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTTableRenderer.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/SWATCHFormatter.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/SWATCHXMLEmitter.h"
+
+namespace calol1 {
+
+  // CaloParams layer1 parameters and LUT options, all written to the processors context
+  struct LUTParameters {
+    std::vector<int> ecalScaleETBins;
+    std::vector<unsigned int> ecalScalePhiBins;
+    std::vector<double> ecalScaleFactors;
+    std::vector<int> hcalScaleETBins;
+    std::vector<unsigned int> hcalScalePhiBins;
+    std::vector<double> hcalScaleFactors;
+    std::vector<int> hfScaleETBins;
+    std::vector<unsigned int> hfScalePhiBins;
+    std::vector<double> hfScaleFactors;
+    std::vector<unsigned long long int> hcalFBLUTUpper;
+    std::vector<unsigned long long int> hcalFBLUTLower;
+    std::vector<uint32_t> secondStageLUT;
+    double towerLsbSum{0.};
+    bool useLSB{true};
+    bool useCalib{true};
+    bool useECALLUT{true};
+    bool useHCALLUT{true};
+    bool useHFLUT{true};
+    bool useHCALFBLUT{true};
+    int firmwareVersion{1};
+  };
+
+  typedef std::vector< std::pair<std::string, LUTTableKey> > ContextParams;
+
+  // A CTP7_Phi context, i.e. the tables one card overrides
+  struct CardContext {
+    uint32_t card;
+    std::string id;
+    ContextParams params;
+  };
+
+  class LUTDocument {
+  public:
+    LUTDocument(const LUTParameters& parameters, const LUTArrays& luts);
+    LUTDocument(const LUTDocument&) = delete;
+    LUTDocument& operator=(const LUTDocument&) = delete;
+
+    // Only the cards overriding at least one table, in card order
+    const std::vector<CardContext>& cardContexts() const { return cards_; }
+
+    // Every table param of the document, processors context first
+    std::vector<LUTTableKey> tableKeys() const;
+
+    // Renders all tables up front on up to numberOfThreads threads
+    // (0 = all available, 1 = serial), writing stays in document order
+    void prefetch(int numberOfThreads);
+
+    // Digests of every context with algorithm, rendering the tables
+    // still missing; prepare() does it for MD5 and the extra checksums
+    void computeChecksums(ChecksumAlgorithm algorithm);
+    // md5checksum params, or the same digest with another algorithm;
+    // empty until computed
+    const std::string& processorsChecksum(ChecksumAlgorithm algorithm = ChecksumAlgorithm::MD5) const;
+    const std::string& checksum(const CardContext& context, ChecksumAlgorithm algorithm = ChecksumAlgorithm::MD5) const;
+
+    // Each context gets a "<name>checksum" param for each of these after
+    // its md5checksum, e.g. sha256checksum.  None by default.
+    void setExtraChecksums(const std::vector<ChecksumAlgorithm>& algorithms) { extraChecksums_ = algorithms; prepared_ = false; }
+
+    // Card context tables as the rows differing from the processors
+    // ones.  Off by default.
+    void setDeltaContexts(bool delta) { deltaContexts_ = delta; prepared_ = false; }
+    bool deltaContexts() const { return deltaContexts_; }
+    // Rows of a card table written with delta contexts, in order; nullptr
+    // if the table is written whole (no delta contexts, or words above
+    // 16 bits).  A table equal to the processors one keeps its first row
+    // so that the override and its <rows> are never empty.
+    const std::vector<uint32_t> * deltaRows(const LUTTableKey& key) const;
+
+    // Stage timers (rendering, hashing, each table kind written, end of
+    // document) and row/context counters go there, nothing if nullptr
+    void setMetrics(LUTMetrics * metrics) { metrics_ = metrics; }
+
+    // Renders every table, computes the delta rows and every checksum
+    // on up to numberOfThreads threads; needed by the const writers
+    void prepare(int numberOfThreads);
+    bool prepared() const { return prepared_; }
+
+    // Whole document, from StartDocument to EndDocument, once prepared
+    bool writeXML(xmlTextWriterPtr writer) const;
+    // Same bytes streamed through a pipeline instead of rendering every
+    // table first: the tables are cut into chunks of chunkRows rows,
+    // formatted on up to numberOfThreads threads (0 = all available),
+    // then hashed and written in document order, with at most depth
+    // chunks in flight.  The checksums come out of the same pass and
+    // are kept, hence not const; no prepare() needed.
+    bool writeXML(xmlTextWriterPtr writer, int numberOfThreads, unsigned int chunkRows, unsigned int depth);
+    // Both again, same bytes, without xmlTextWriter
+    bool writeXML(SWATCHXMLEmitter& emitter) const;
+    bool writeXML(SWATCHXMLEmitter& emitter, int numberOfThreads, unsigned int chunkRows, unsigned int depth);
+    // Same content, see LUTBinaryFormat.h; needs the MD5 checksums
+    bool writeBinary(const std::string& fileName) const;
+
+    // The contexts one at a time, each as a document of its own (XML
+    // declaration, <algo> and just that context): 0 is processors, then
+    // cardContexts() in order.  Once prepared, so that different
+    // contexts may be written concurrently.
+    size_t nContexts() const { return 1 + cards_.size(); }
+    std::string contextId(size_t context) const { return context == 0 ? "processors" : cards_[context-1].id; }
+    bool writeContextXML(xmlTextWriterPtr writer, size_t context) const;
+    bool writeContextXML(SWATCHXMLEmitter& emitter, size_t context) const;
+
+    const LUTParameters& parameters() const { return parameters_; }
+    const LUTArrays& luts() const { return luts_; }
+    const LUTStore& store() const { return store_; }
+    const LUTTableCache& cache() const { return cache_; }
+
+  private:
+    // Where the write functions go, one of writer and emitter is set.
+    // Each output has its own, so that several can be written at once.
+    struct XMLOutput {
+      xmlTextWriterPtr writer{nullptr};
+      SWATCHXMLEmitter * emitter{nullptr};
+      // Reused for every vector param
+      SWATCHFormatter formatter;
+    };
+
+    // Digests of the processors context and of each card context
+    typedef std::map<ChecksumAlgorithm, std::string> ProcessorsChecksums;
+    typedef std::map<std::pair<uint32_t, ChecksumAlgorithm>, std::string> ContextChecksums;
+
+    // Whole document
+    bool writeDocument(XMLOutput& out) const;
+    // Into processors and contexts the digests the pass computed
+    bool streamDocument(XMLOutput& out, int numberOfThreads, unsigned int chunkRows, unsigned int depth,
+                        ProcessorsChecksums& processors, ContextChecksums& contexts) const;
+    bool streamXML(XMLOutput& out, int numberOfThreads, unsigned int chunkRows, unsigned int depth);
+    bool startAlgo(XMLOutput& out) const;
+    bool endAlgo(XMLOutput& out) const;
+    bool startContext(XMLOutput& out, const std::string& id) const;
+    bool endContext(XMLOutput& out) const;
+    bool writeXMLParam(XMLOutput& out, const std::string& id, const std::string& type, const std::string& body) const;
+    bool writeXMLParam(XMLOutput& out, const std::string& id, const std::string& type, const char * body) const;
+    bool writeSWATCHVector(XMLOutput& out, const std::string& id, const std::vector<int>& vect) const;
+    bool writeSWATCHVector(XMLOutput& out, const std::string& id, const std::vector<unsigned int>& vect) const;
+    bool writeSWATCHVector(XMLOutput& out, const std::string& id, const std::vector<double>& vect) const;
+    bool writeSWATCHVector(XMLOutput& out, const std::string& id, const std::vector<unsigned long long int>& vect) const;
+    // With rows only those rows, as a "table:delta" param
+    bool writeTable(XMLOutput& out, const std::string& id, const RenderedTable& table, const std::vector<uint32_t> * rows = nullptr) const;
+    bool writeTableStart(XMLOutput& out, const std::string& id, const RenderedTable& table, bool delta = false) const;
+    // table holds rows [first, first + nRows) of the whole table
+    bool writeTableRows(XMLOutput& out, const RenderedTable& table, const std::vector<uint32_t> * rows = nullptr, uint32_t first = 0) const;
+    bool writeTableEnd(XMLOutput& out) const;
+    bool writeContextDocument(XMLOutput& out, size_t context) const;
+    bool writeProcessorsContext(XMLOutput& out) const;
+    bool writeProcessorsHeader(XMLOutput& out) const;
+    bool writeSecondStageLUT(XMLOutput& out) const;
+    bool writeContext(XMLOutput& out, const CardContext& context) const;
+    bool writeExtraChecksums(XMLOutput& out, const std::function<const std::string&(ChecksumAlgorithm)>& checksum) const;
+    // False (and logged) if the document is not prepared
+    bool checkPrepared() const;
+    // A table of a prepared document
+    const RenderedTable& preparedTable(const LUTTableKey& key) const { return *cache_.find(key); }
+
+    // deltaRows of every card table, once, before anything is written
+    void computeDeltaRows();
+
+    // Renderer used by cache_, only reads the LUT store so
+    // several tables can be rendered concurrently
+    void renderTable(const LUTTableKey& key, RenderedTable& table) const;
+    // Rows [first, last) of the table, for the pipeline
+    void renderRows(const LUTTableKey& key, uint32_t first, uint32_t last, RenderedTable& table) const;
+
+    // Timer stage of a table param, one per LUT kind
+    static const char * tableStage(const std::string& id);
+
+    // Wrapper for xmllib error codes
+    // returnCode < 0 if error
+    bool rcWrap(int rc) const;
+
+    const LUTParameters& parameters_;
+    const LUTArrays& luts_;
+    // 16 bit hardware words of the tables the document uses
+    LUTStore store_;
+    std::vector<CardContext> cards_;
+    ProcessorsChecksums processorsChecksums_;
+    // Card context digests, by card
+    ContextChecksums contextChecksums_;
+    std::vector<ChecksumAlgorithm> extraChecksums_;
+    bool deltaContexts_{false};
+    bool deltaRowsComputed_{false};
+    bool prepared_{false};
+    std::map<LUTTableKey, std::vector<uint32_t>> deltaRows_;
+    // Each distinct table is rendered once per document
+    LUTTableCache cache_;
+    LUTMetrics * metrics_{nullptr};
+  };
+
+}
+
+#endif
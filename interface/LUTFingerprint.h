@@ -0,0 +1,75 @@
+#ifndef L1Trigger_L1TCaloLayer1LUTWriter_LUTFingerprint_h
+#define L1Trigger_L1TCaloLayer1LUTWriter_LUTFingerprint_h
+// -*- C++ -*-
+//
+// Package:    L1Trigger/L1TCaloLayer1LUTWriter
+// Class:      LUTFingerprint, LUTSidecar
+//
+/**\class LUTFingerprint LUTFingerprint.h L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTFingerprint.h
+
+   Description: Digest of the inputs a LUT file is generated from, and the sidecar file keeping it
+
+   Implementation:
+   LUTFingerprint is an MD5 over the CaloParams layer1 parameters, the
+   LUT options and whatever else the caller adds (e.g. the fetched
+   tables), each vector prefixed by its size so that different splits of
+   the same bytes differ.  The ECAL TPG scale and the HCAL transcoder are
+   only seen through the tables L1TCaloLayer1FetchLUTs makes from them,
+   so the fingerprint is computed right after the fetch, before anything
+   is rendered or written.
+
+   The sidecar "<output>.fingerprint" is a text file, the fingerprint on
+   the first line then one "<context id> <md5checksum>" line per context
+   of the output, so the checksums are known without reading the output.
+*/
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTChecksum.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTDocument.h"
+
+namespace calol1 {
+
+  class LUTFingerprint {
+  public:
+    LUTFingerprint();
+
+    void add(const LUTParameters& parameters);
+    void add(const std::string& text);
+    void add(const double * values, size_t size);
+    void add(int64_t value);
+    // Fetched tables, e.g. the ECAL ones for the ECAL TPG scale
+    void add(const std::vector<CaloLUT>& luts);
+    void add(const std::vector<HFLUT>& luts);
+
+    // Hex digest, call once
+    std::string digest();
+
+  private:
+    template<typename T>
+    void addVector(const std::vector<T>& vect) {
+      add(static_cast<int64_t>(vect.size()));
+      digest_.update(vect.data(), vect.size()*sizeof(T));
+    }
+
+    LUTChecksum digest_;
+  };
+
+  struct LUTSidecar {
+    std::string fingerprint;
+    // (context id, md5checksum) in document order
+    std::vector< std::pair<std::string, std::string> > checksums;
+
+    static std::string fileName(const std::string& output) { return output + ".fingerprint"; }
+
+    // false if missing or unreadable
+    bool read(const std::string& fileName);
+    bool write(const std::string& fileName) const;
+  };
+
+}
+
+#endif
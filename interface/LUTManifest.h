@@ -0,0 +1,58 @@
+#ifndef L1Trigger_L1TCaloLayer1LUTWriter_LUTManifest_h
+#define L1Trigger_L1TCaloLayer1LUTWriter_LUTManifest_h
+// -*- C++ -*-
+//
+// Package:    L1Trigger/L1TCaloLayer1LUTWriter
+// Class:      LUTManifest
+//
+/**\class LUTManifest LUTManifest.h L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTManifest.h
+
+   Description: JSON index of the LUT files written by a job
+
+   Implementation:
+   One entry per file, with the runs it is valid for and the
+   md5checksum of each context in it, e.g.
+     {"files": [
+       {"file": "luts_run355100.xml", "runs": [355100, 355101],
+        "checksums": {"processors": "...", "CTP7_Phi0": "..."}}
+     ]}
+   Runs are only recorded in the order they were added.
+*/
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace calol1 {
+
+  class LUTManifest {
+  public:
+    struct Entry {
+      std::string fileName;
+      std::vector<unsigned int> runs;
+      // (context id, md5checksum) in document order
+      std::vector< std::pair<std::string, std::string> > checksums;
+    };
+
+    bool empty() const { return entries_.empty(); }
+    const std::vector<Entry>& entries() const { return entries_; }
+
+    Entry& add(const std::string& fileName) {
+      entries_.push_back(Entry{fileName, {}, {}});
+      return entries_.back();
+    }
+    // Attaches run to the last file, once
+    void addRun(unsigned int run) {
+      std::vector<unsigned int>& runs = entries_.back().runs;
+      if ( runs.empty() || runs.back() != run ) runs.push_back(run);
+    }
+
+    bool write(const std::string& fileName) const;
+
+  private:
+    std::vector<Entry> entries_;
+  };
+
+}
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef L1Trigger_L1TCaloLayer1LUTWriter_LUTMetrics_h
+#define L1Trigger_L1TCaloLayer1LUTWriter_LUTMetrics_h
+// -*- C++ -*-
+//
+// Package:    L1Trigger/L1TCaloLayer1LUTWriter
+// Class:      LUTMetrics
+//
+/**\class LUTMetrics LUTMetrics.h L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTMetrics.h
+
+   Description: Per stage timers and counters of LUT generation
+
+   Implementation:
+   A stage is timed by a Timer living for its scope; the elapsed time is
+   added to the stage, so a stage entered many times (e.g. one table
+   write) reports its number of calls and total time.  Counters are
+   plain sums (rows, bytes, cache hits, ...).  Stages and counters are
+   named by string literals and reported in the order they first
+   occurred.
+
+   Everything takes a LUTMetrics pointer that may be nullptr, and a
+   disabled (or absent) LUTMetrics costs one branch: no clock is read
+   and nothing is locked.  When enabled, updates take a mutex so that
+   stages run from several threads add up.
+*/
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace calol1 {
+
+  class LUTMetrics {
+  public:
+    typedef std::chrono::steady_clock clock;
+
+    class Timer {
+    public:
+      Timer(LUTMetrics * metrics, const char * stage) :
+        metrics_((metrics != nullptr && metrics->enabled()) ? metrics : nullptr),
+        stage_(stage)
+      {
+        if ( metrics_ != nullptr ) start_ = clock::now();
+      }
+      ~Timer() { stop(); }
+      Timer(const Timer&) = delete;
+      Timer& operator=(const Timer&) = delete;
+
+      // Ends the stage before the end of the scope
+      void stop() {
+        if ( metrics_ == nullptr ) return;
+        metrics_->addTime(stage_, std::chrono::duration<double, std::milli>(clock::now() - start_).count());
+        metrics_ = nullptr;
+      }
+
+    private:
+      LUTMetrics * metrics_;
+      const char * stage_;
+      clock::time_point start_;
+    };
+
+    explicit LUTMetrics(bool enabled = true) : enabled_(enabled) {}
+
+    bool enabled() const { return enabled_; }
+
+    void addTime(const char * stage, double ms);
+    void count(const char * counter, uint64_t n = 1);
+    static void count(LUTMetrics * metrics, const char * counter, uint64_t n = 1) {
+      if ( metrics != nullptr && metrics->enabled() ) metrics->count(counter, n);
+    }
+
+    // One line per stage (calls, total and mean ms) then the counters
+    std::string summary() const;
+    // {"stages": {"fetch": {"calls": 1, "ms": 12.3}, ...}, "counters": {"rows": 123, ...}}
+    bool writeJSON(const std::string& fileName) const;
+    void clear();
+
+  private:
+    struct Stage {
+      std::string name;
+      uint64_t calls;
+      double ms;
+    };
+    struct Counter {
+      std::string name;
+      uint64_t value;
+    };
+
+    bool enabled_;
+    mutable std::mutex mutex_;
+    std::vector<Stage> stages_;
+    std::vector<Counter> counters_;
+  };
+
+}
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef L1Trigger_L1TCaloLayer1LUTWriter_LUTPacking_h
+#define L1Trigger_L1TCaloLayer1LUTWriter_LUTPacking_h
+// -*- C++ -*-
+//
+// Package:    L1Trigger/L1TCaloLayer1LUTWriter
+// Class:      LUTPacking
+//
+/**\class LUTPacking LUTPacking.h L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTPacking.h
+
+   Description: Repacks whole LUTs into 16 bit hardware words in table row order
+
+   Implementation:
+   The words come out row-major in the order of the luts.xml rows:
+     ECAL/HCAL  [fb 0..1][input 0..255][iEta 1..28]
+     HF         [fb 0..3][input 0..255][iEta 30..41]
+   The Input column is not stored, it is the row number.
+
+   The repack and the narrowing to 16 bits run 8 (SSE4.1) or 16 (AVX2)
+   entries at a time along the input axis, which is contiguous in the
+   LUT arrays, and the results are then scattered into the rows.  The
+   kernel is chosen at run time from what the CPU supports; the scalar
+   one is the reference and is used on other architectures.
+
+   differingRows compares two packed tables with the same kernels, 8 or
+   16 words at a time over the whole contiguous table, going on from the
+   next row as soon as a row differs.
+*/
+
+#include <cstdint>
+#include <vector>
+
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/FirmwareLayout.h"
+
+namespace calol1 {
+
+  enum class PackKernel { Scalar, SSE41, AVX2 };
+
+  // Best kernel for this CPU
+  PackKernel bestPackKernel();
+  bool packKernelSupported(PackKernel kernel);
+  const char * packKernelName(PackKernel kernel);
+
+  constexpr size_t caloPackedSize = 2*256*28;
+  constexpr size_t hfPackedSize = 4*256*12;
+
+  // words must hold caloPackedSize (hfPackedSize) entries.  Return false if
+  // a word does not fit in 16 bits, words is then incomplete.
+  bool packCaloLUT(const CaloLUT& lut, int firmwareVersion, uint16_t * words, PackKernel kernel = bestPackKernel());
+  bool packHFLUT(const HFLUT& lut, int firmwareVersion, uint16_t * words, PackKernel kernel = bestPackKernel());
+
+  // Sets rows to, in order, the rows where two packed tables of nRows
+  // rows of columns words differ, e.g. a card table and the processors one
+  void differingRows(const uint16_t * a, const uint16_t * b, uint32_t nRows, uint32_t columns, std::vector<uint32_t>& rows,
+                     PackKernel kernel = bestPackKernel());
+
+}
+
+#endif
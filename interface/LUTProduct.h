@@ -0,0 +1,42 @@
+#ifndef L1Trigger_L1TCaloLayer1LUTWriter_LUTProduct_h
+#define L1Trigger_L1TCaloLayer1LUTWriter_LUTProduct_h
+// -*- C++ -*-
+//
+// Package:    L1Trigger/L1TCaloLayer1LUTWriter
+// Class:      LUTProduct
+//
+/**\class LUTProduct LUTProduct.h L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTProduct.h
+
+   Description: Run product of L1TCaloLayer1LUTProducer, the LUTs every consumer of the job shares
+
+   Implementation:
+   Only holds a pointer to the SharedLUTs, so that runs in the same
+   CaloParams/transcoder IOVs share a single set.  Transient, it is
+   never written to a file; invalid if the LUTs could not be made.
+*/
+
+#include <memory>
+#include <utility>
+
+namespace calol1 {
+
+  class SharedLUTs;
+
+  class LUTProduct {
+  public:
+    LUTProduct() {}
+    explicit LUTProduct(std::shared_ptr<const SharedLUTs> luts) : luts_(std::move(luts)) {}
+
+    bool isValid() const { return luts_ != nullptr; }
+    const SharedLUTs& operator*() const { return *luts_; }
+    const SharedLUTs * operator->() const { return luts_.get(); }
+    // Keeps the LUTs alive beyond the Run
+    const std::shared_ptr<const SharedLUTs>& shared() const { return luts_; }
+
+  private:
+    std::shared_ptr<const SharedLUTs> luts_;
+  };
+
+}
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef L1Trigger_L1TCaloLayer1LUTWriter_LUTSnapshot_h
+#define L1Trigger_L1TCaloLayer1LUTWriter_LUTSnapshot_h
+// -*- C++ -*-
+//
+// Package:    L1Trigger/L1TCaloLayer1LUTWriter
+// Class:      LUTSnapshot
+//
+/**\class LUTSnapshot LUTSnapshot.h L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTSnapshot.h
+
+   Description: Everything L1TCaloLayer1LUTWriter writes its files from, in one file
+
+   Implementation:
+   The CaloParams values and LUT options (LUTParameters), the tables
+   L1TCaloLayer1FetchLUTs made of them with the ECAL and HCAL scales
+   folded in (LUTArrays), the extra checksums and, if it was decoded,
+   the HCAL TP compression scale.  A LUTDocument made from a snapshot
+   writes the same bytes as the module did, without a Global Tag,
+   geometry or transcoder, see calol1LUTFromSnapshot.
+
+   The file is little-endian:
+     header  magic "CALOL1SN", uint32 format version, uint32 run,
+             uint64 size of the body once decompressed
+     body    one zstd frame of
+       LUTParameters   each vector as uint32 size and its elements (int and
+                       unsigned as uint32, double as IEEE bits, uint64),
+                       double towerLsbSum, uint32 use* flags (bit 0 useLSB
+                       ... bit 5 useHCALFBLUT), int32 firmwareVersion
+       extraChecksums  uint32 count, each name as uint32 size and its chars
+       LUTArrays       uint32 count and uint32 [count][caloLUTSize] for
+                       ECAL and HCAL, the same with hfLUTSize for HF,
+                       uint32 count and uint64 words for HCALFB
+       HCAL scale      uint32 number of distinct tower scales (0 if not
+                       decoded), float64 [number][256] and, if not 0, the
+                       uint32 scale of each tower [iEta -41..-1,1..41][iPhi 1..72]
+   Doubles are kept bit for bit, so nothing formatted from them changes.
+*/
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/HcalScaleTable.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTChecksum.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTDocument.h"
+
+namespace calol1 {
+
+  namespace lutsnapshot {
+
+    constexpr char magic[8] = {'C', 'A', 'L', 'O', 'L', '1', 'S', 'N'};
+    constexpr uint32_t formatVersion = 1;
+    constexpr size_t headerSize = 24;
+
+  }
+
+  class LUTSnapshot {
+  public:
+    // hcalScale is left out if empty; compressionLevel 0 is the zstd default.
+    // Returns false, see error, if the file cannot be written
+    static bool write(const std::string& fileName, uint32_t run, const LUTParameters& parameters, const LUTArrays& luts,
+                      const std::vector<ChecksumAlgorithm>& extraChecksums, const HcalScaleTable& hcalScale,
+                      int compressionLevel, std::string& error);
+
+    // Returns false, see error(), if the file cannot be read
+    bool read(const std::string& fileName, int numberOfThreads=0);
+    const std::string& error() const { return error_; }
+
+    uint32_t run() const { return run_; }
+    const LUTParameters& parameters() const { return parameters_; }
+    const LUTArrays& luts() const { return luts_; }
+    const std::vector<ChecksumAlgorithm>& extraChecksums() const { return extraChecksums_; }
+    // Empty if the module had not decoded it
+    const HcalScaleTable& hcalScale() const { return hcalScale_; }
+
+  private:
+    uint32_t run_{0};
+    LUTParameters parameters_;
+    LUTArrays luts_;
+    std::vector<ChecksumAlgorithm> extraChecksums_;
+    HcalScaleTable hcalScale_;
+    std::string error_;
+  };
+
+}
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef L1Trigger_L1TCaloLayer1LUTWriter_LUTSplitWriter_h
+#define L1Trigger_L1TCaloLayer1LUTWriter_LUTSplitWriter_h
+// -*- C++ -*-
+//
+// Package:    L1Trigger/L1TCaloLayer1LUTWriter
+// Class:      LUTSplitWriter
+//
+/**\class LUTSplitWriter LUTSplitWriter.h L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTSplitWriter.h
+
+   Description: Writes a LUTDocument as one file per context plus a JSON index
+
+   Implementation:
+   luts.xml.gz becomes luts_processors.xml.gz, luts_CTP7_Phi0.xml.gz, ...
+   each a complete SWATCH document (<algo id="calol1"> around a single
+   context), so a card is loaded from the processors file and its own
+   file only.  The document must be prepared (all tables rendered, all
+   checksums computed), the files are then written, compressed and
+   hashed concurrently, one task per file.  The index, luts_index.json,
+   lists the files in document order with their size and the md5 of the
+   file as written, next to the md5checksum of the context in it:
+     {"files": [
+       {"context": "processors", "file": "luts_processors.xml", "bytes": 1234,
+        "md5": "...", "md5checksum": "..."}
+     ]}
+   File names in the index are relative to its directory.
+*/
+
+#include <string>
+#include <vector>
+
+namespace calol1 {
+
+  class LUTDocument;
+
+  class LUTSplitWriter {
+  public:
+    struct File {
+      std::string context;
+      std::string fileName;
+      size_t bytes;
+      // Of the file bytes, i.e. after compression
+      std::string md5;
+      // Of the context, as in its md5checksum param
+      std::string md5checksum;
+    };
+
+    // compression and level as for newXMLTextWriter; direct writes
+    // through SWATCHXMLEmitter instead of xmlTextWriter
+    LUTSplitWriter(const std::string& fileName, const std::string& compression, int level, bool direct);
+
+    // luts.xml.gz -> luts_<context>.xml.gz
+    static std::string contextFileName(const std::string& fileName, const std::string& context);
+    // luts.xml.gz -> luts_index.json
+    static std::string indexFileName(const std::string& fileName);
+
+    // All files and the index of a prepared document, on up to
+    // numberOfThreads threads (0 = all available)
+    bool write(const LUTDocument& document, int numberOfThreads);
+
+    const std::vector<File>& files() const { return files_; }
+
+  private:
+    // On failure error says what went wrong with the file
+    bool writeFile(const LUTDocument& document, size_t context, File& file, std::string& error) const;
+    bool writeIndex() const;
+
+    std::string fileName_;
+    std::string compression_;
+    int level_;
+    bool direct_;
+    std::vector<File> files_;
+  };
+
+}
+
+#endif
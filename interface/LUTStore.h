@@ -0,0 +1,89 @@
+#ifndef L1Trigger_L1TCaloLayer1LUTWriter_LUTStore_h
+#define L1Trigger_L1TCaloLayer1LUTWriter_LUTStore_h
+// -*- C++ -*-
+//
+// Package:    L1Trigger/L1TCaloLayer1LUTWriter
+// Class:      LUTStore
+//
+/**\class LUTStore LUTStore.h L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTStore.h
+
+   Description: Hardware words of the Layer1 LUTs, 16 bits per cell in table row order
+
+   Implementation:
+   One contiguous block per detector with a slot for every phi bin of the
+   LUT arrays.  A slot is packed (see LUTPacking.h) the first time it is
+   asked for, so only the phi independent table and the bins some card
+   actually uses ever get written.  The block is allocated uninitialized,
+   the pages of slots never asked for are not touched.  Access is
+   thread safe, a slot is packed exactly once.
+
+   L1TCaloLayer1FetchLUTs still fills the nested uint32_t arrays for
+   every phi bin, the store only replaces what is derived from them.
+   Like LUTDocument it keeps a reference to the arrays.
+*/
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/FirmwareLayout.h"
+
+namespace calol1 {
+
+  // The arrays filled by L1TCaloLayer1FetchLUTs, index 0 is the phi independent table
+  struct LUTArrays {
+    std::vector<CaloLUT> ecalLUT;
+    std::vector<CaloLUT> hcalLUT;
+    std::vector<HFLUT> hfLUT;
+    std::vector<unsigned long long int> hcalFBLUT;
+  };
+
+  class LUTStore {
+  public:
+    LUTStore(const LUTArrays& luts, int firmwareVersion);
+    LUTStore(const LUTStore&) = delete;
+    LUTStore& operator=(const LUTStore&) = delete;
+
+    // Rows [fb][input][iEta] as in luts.xml, caloPackedSize (hfPackedSize)
+    // words.  nullptr if some word of the table does not fit in 16 bits.
+    const uint16_t * ecal(uint32_t index) const { return slot(ecal_, index); }
+    const uint16_t * hcal(uint32_t index) const { return slot(hcal_, index); }
+    const uint16_t * hf(uint32_t index) const { return slot(hf_, index); }
+
+    int firmwareVersion() const { return firmwareVersion_; }
+
+    // Tables packed so far and the bytes they occupy
+    size_t materialized() const;
+    size_t materializedBytes() const;
+    // What the nested uint32_t arrays of all phi bins take
+    size_t nestedBytes() const;
+    std::string memoryReport() const;
+
+  private:
+    struct Detector {
+      Detector(size_t nTables, size_t tableSize);
+      size_t nTables;
+      size_t tableSize;
+      std::unique_ptr<uint16_t[]> cells;
+      std::unique_ptr<std::once_flag[]> once;
+      std::unique_ptr<bool[]> fits;
+      mutable std::atomic<size_t> materialized{0};
+    };
+
+    const uint16_t * slot(Detector& detector, uint32_t index) const;
+    void pack(Detector& detector, uint32_t index) const;
+
+    const LUTArrays& luts_;
+    int firmwareVersion_;
+    // Packed lazily from const accessors
+    mutable Detector ecal_;
+    mutable Detector hcal_;
+    mutable Detector hf_;
+  };
+
+}
+
+#endif
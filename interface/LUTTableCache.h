@@ -0,0 +1,97 @@
+#ifndef L1Trigger_L1TCaloLayer1LUTWriter_LUTTableCache_h
+#define L1Trigger_L1TCaloLayer1LUTWriter_LUTTableCache_h
+// -*- C++ -*-
+//
+// Package:    L1Trigger/L1TCaloLayer1LUTWriter
+// Class:      LUTTableCache
+//
+/**\class LUTTableCache LUTTableCache.h L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTTableCache.h
+
+   Description: Renders each distinct (LUT kind, phi bin index, firmware version) table once
+
+   Implementation:
+   Many CTP7_Phi contexts point at the same phi bin index, and the global
+   context writes index 0 for both Minus and Plus, so most table params
+   in a document are repeats.  The cache keeps the rendered text and the
+   checksum payload for each distinct table; a context checksum is then
+   one update per table, and contexts made of the same tables share the
+   final digest.
+
+   The cache is only valid for the LUT arrays it was filled from, call
+   clear() whenever they are refetched.
+*/
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTChecksum.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTTableRenderer.h"
+
+namespace calol1 {
+
+  enum class LUTKind { ECAL, HCAL, HF, HCALFB };
+
+  struct LUTTableKey {
+    LUTKind kind;
+    uint32_t index;
+    int firmwareVersion;
+
+    bool operator<(const LUTTableKey& other) const {
+      return std::tie(kind, index, firmwareVersion) < std::tie(other.kind, other.index, other.firmwareVersion);
+    }
+    bool operator==(const LUTTableKey& other) const {
+      return kind == other.kind && index == other.index && firmwareVersion == other.firmwareVersion;
+    }
+  };
+
+  class LUTTableCache {
+  public:
+    typedef std::function<void(const LUTTableKey&, RenderedTable&)> Renderer;
+
+    explicit LUTTableCache(Renderer renderer) : renderer_(std::move(renderer)) {}
+
+    // Renders the table on first use
+    const RenderedTable& get(const LUTTableKey& key);
+
+    // Renders all keys not cached yet, distributing them over up to
+    // numberOfThreads threads (0 = all available, 1 = serial).
+    // Lookups are not counted, only renders.
+    void prefetch(const std::vector<LUTTableKey>& keys, int numberOfThreads);
+
+    // Digest of a context made of these tables, in this order; the
+    // md5checksum param for MD5
+    const std::string& checksum(const std::vector<LUTTableKey>& keys, ChecksumAlgorithm algorithm = ChecksumAlgorithm::MD5);
+
+    void clear();
+
+    // A table already rendered, nullptr otherwise; not counted as a lookup
+    const RenderedTable * find(const LUTTableKey& key) const;
+
+    unsigned int lookups() const { return lookups_; }
+    unsigned int renders() const { return renders_; }
+    unsigned int hits() const { return lookups_ > renders_ ? lookups_ - renders_ : 0; }
+    unsigned int checksumLookups() const { return checksumLookups_; }
+    unsigned int checksumRenders() const { return checksums_.size(); }
+
+  private:
+    const RenderedTable& table(const LUTTableKey& key);
+
+    Renderer renderer_;
+    std::map<LUTTableKey, std::unique_ptr<RenderedTable>> tables_;
+    std::map<std::pair<ChecksumAlgorithm, std::vector<LUTTableKey>>, std::string> checksums_;
+    // Lookups of cached entries only read the maps, so once everything
+    // is cached get() and checksum() can be called concurrently
+    std::atomic<unsigned int> lookups_{0};
+    unsigned int renders_{0};
+    std::atomic<unsigned int> checksumLookups_{0};
+  };
+
+}
+
+#endif
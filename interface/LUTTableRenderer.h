@@ -0,0 +1,73 @@
+#ifndef L1Trigger_L1TCaloLayer1LUTWriter_LUTTableRenderer_h
+#define L1Trigger_L1TCaloLayer1LUTWriter_LUTTableRenderer_h
+// -*- C++ -*-
+//
+// Package:    L1Trigger/L1TCaloLayer1LUTWriter
+// Class:      RenderedTable
+//
+/**\class RenderedTable LUTTableRenderer.h L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTTableRenderer.h
+
+   Description: Renders Layer1 LUTs into SWATCH table text, independent of the XML writer
+
+   Implementation:
+   A table param is fully formatted into memory first, together with the
+   words that go into the checksum, then handed to whoever owns the
+   xmlTextWriter.  The rendered table does not depend on the param id
+   (Minus/Plus) so the same one can be written in several places.
+   Rendering only reads the LUT arrays, so several tables can be
+   rendered on different threads.
+*/
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/FirmwareLayout.h"
+
+namespace calol1 {
+
+  struct RenderedTable {
+    const char * columns;
+    const char * types;
+    // Row text, each row NUL terminated so it can go straight to libxml2
+    std::string rows;
+    std::vector<uint32_t> rowStarts;
+    // Exactly the bytes that go into the context md5checksum
+    std::vector<unsigned char> payload;
+
+    size_t nRows() const { return rowStarts.size(); }
+    const char * row(size_t i) const { return rows.data() + rowStarts[i]; }
+    void addRow(const std::string& text) {
+      rowStarts.push_back(rows.size());
+      rows.append(text);
+      rows.push_back('\0');
+    }
+    void addPayload(const void * data, size_t size) {
+      const unsigned char * bytes = static_cast<const unsigned char *>(data);
+      payload.insert(payload.end(), bytes, bytes+size);
+    }
+    void clear() {
+      rows.clear();
+      rowStarts.clear();
+      payload.clear();
+    }
+  };
+
+  // ECAL and HCAL share the table layout and the firmware bit rearrangement
+  void renderCaloLUT(const CaloLUT& lut, int firmwareVersion, RenderedTable& table);
+  void renderHFLUT(const HFLUT& lut, int firmwareVersion, RenderedTable& table);
+  // Same tables from 16 bit words already in row order (LUTPacking.h)
+  void renderCaloWords(const uint16_t * words, RenderedTable& table);
+  void renderHFWords(const uint16_t * words, RenderedTable& table);
+  // Only rows [first, last) of those, e.g. a chunk of a streamed table
+  void renderCaloRows(const uint16_t * words, uint32_t first, uint32_t last, RenderedTable& table);
+  void renderHFRows(const uint16_t * words, uint32_t first, uint32_t last, RenderedTable& table);
+
+  constexpr uint32_t caloTableRows = 2*256;
+  constexpr uint32_t hfTableRows = 4*256;
+  void renderHCALFBLUT(const std::vector<unsigned long long int>& lut, RenderedTable& table);
+
+}
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef L1Trigger_L1TCaloLayer1LUTWriter_LUTVerification_h
+#define L1Trigger_L1TCaloLayer1LUTWriter_LUTVerification_h
+// -*- C++ -*-
+//
+// Package:    L1Trigger/L1TCaloLayer1LUTWriter
+// Class:      LUTVerification
+//
+/**\class LUTVerification LUTVerification.h L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTVerification.h
+
+   Description: Checks every cell of the tables a LUTDocument writes against L1TCaloLayer1FetchLUTs
+
+   Implementation:
+   The tables as they go to the file, i.e. the rendered rows and the
+   checksum payload, are compared for every (fb, input, iEta) with the
+   words expected from the LUT arrays: the repack of FirmwareLayout.h,
+   one branch free pass over each whole table, which does not share the
+   SIMD packing of the LUT store the tables are rendered from.  The row
+   text is parsed back, so the formatting is covered too.  Tables are
+   checked in parallel, each distinct table once however many contexts
+   write it, and reported for every (context, param) it appears in.
+
+   The document has to be prepared, which the non streamed writer needs
+   anyway; it is only read.  Only the HCAL FB LUT of the CaloParams vectors is checked,
+   the other vectors are not derived from the LUT arrays.
+*/
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTTableCache.h"
+
+namespace calol1 {
+
+  class LUTDocument;
+
+  class LUTVerification {
+  public:
+    struct Cell {
+      // Checksum payload, otherwise the row text
+      bool payload;
+      uint32_t fb;
+      uint32_t input;
+      uint32_t iEta;
+      uint64_t expected;
+      uint64_t written;
+    };
+
+    struct TableReport {
+      std::string context;
+      std::string id;
+      LUTKind kind;
+      // Wrong number of rows or columns, wrong Input column, ...
+      std::string problem;
+      uint64_t textMismatches{0};
+      uint64_t payloadMismatches{0};
+      // The first maxCells mismatching cells, text then payload, in row order
+      std::vector<Cell> first;
+    };
+
+    // Tables of a prepared document on up to numberOfThreads threads
+    // (0 = all available)
+    LUTVerification(const LUTDocument& document, int numberOfThreads, size_t maxCells = 16);
+
+    bool passed() const { return failures_.empty(); }
+    // Only the tables that do not match, in document order
+    const std::vector<TableReport>& failures() const { return failures_; }
+    // Table params and their cells as written, shared tables counted each time
+    size_t checkedTables() const { return tables_; }
+    uint64_t checkedCells() const { return cells_; }
+
+    // One line per failing table then its first cells, expected and
+    // written words with their fields decoded for the firmware, e.g.
+    //   CTP7_Phi3 ECALLUTMinus: 2 text and 2 checksum cells differ
+    //     text fb 0 input 0x12 iEta 4: written 0x1034 (ET 0x34 log2 0 zero 1 FG 0), expected 0x1035 (ET 0x35 ...)
+    void print(std::ostream& out) const;
+
+  private:
+    int firmwareVersion_;
+    std::vector<TableReport> failures_;
+    size_t tables_{0};
+    uint64_t cells_{0};
+  };
+
+}
+
+#endif
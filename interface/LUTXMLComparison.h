@@ -0,0 +1,72 @@
+#ifndef L1Trigger_L1TCaloLayer1LUTWriter_LUTXMLComparison_h
+#define L1Trigger_L1TCaloLayer1LUTWriter_LUTXMLComparison_h
+// -*- C++ -*-
+//
+// Package:    L1Trigger/L1TCaloLayer1LUTWriter
+// Class:      LUTXMLComparison
+//
+/**\class LUTXMLComparison LUTXMLComparison.h L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTXMLComparison.h
+
+   Description: Where a luts.xml first differs from an expected (golden) one
+
+   Implementation:
+   The files are first compared block by block, which settles the usual
+   case of identical outputs at disk speed.  Only if the bytes differ are
+   both streamed through xmlTextReader in lock step, node by node (element
+   names, attributes in order, text and whitespace), stopping at the first
+   difference, which is reported with its context, param, row and column
+   rather than as a text diff.  Files that differ in bytes but not in any
+   node, e.g. one gzip compressed, have the same content.
+
+   Unlike LUTDiff, which compares the table cells whatever the formatting
+   and fallbacks, this checks the exact SWATCH document.  Both files may be
+   gzip compressed.
+*/
+
+#include <ostream>
+#include <string>
+
+namespace calol1 {
+
+  class LUTXMLComparison {
+  public:
+    enum class Result { SameBytes, SameContent, Different, Error };
+
+    struct Difference {
+      // Innermost context and param ids, empty outside any
+      std::string context;
+      std::string param;
+      // Row of the param table (0 is the first <row>) and comma separated
+      // field of its text (0 is Input where present), -1 if not in a row
+      long row{-1};
+      long column{-1};
+      // Element, "element@attribute", "#text" or "end of document"
+      std::string node;
+      std::string expected;
+      std::string actual;
+    };
+
+    LUTXMLComparison(const std::string& expectedFile, const std::string& actualFile);
+
+    Result result() const { return result_; }
+    bool passed() const { return result_ == Result::SameBytes || result_ == Result::SameContent; }
+    // Set if result() is Different
+    const Difference& difference() const { return difference_; }
+    // Set if result() is Error
+    const std::string& error() const { return error_; }
+
+    // One line, or a few for a difference
+    void print(std::ostream& out) const;
+
+  private:
+    bool sameBytes(const std::string& expectedFile, const std::string& actualFile);
+    void compareNodes(const std::string& expectedFile, const std::string& actualFile);
+
+    Result result_{Result::Error};
+    Difference difference_;
+    std::string error_;
+  };
+
+}
+
+#endif
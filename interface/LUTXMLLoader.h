@@ -0,0 +1,110 @@
+#ifndef L1Trigger_L1TCaloLayer1LUTWriter_LUTXMLLoader_h
+#define L1Trigger_L1TCaloLayer1LUTWriter_LUTXMLLoader_h
+// -*- C++ -*-
+//
+// Package:    L1Trigger/L1TCaloLayer1LUTWriter
+// Class:      LUTXMLLoader
+//
+/**\class LUTXMLLoader LUTXMLLoader.h L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTXMLLoader.h
+
+   Description: Reads a luts.xml back into the tables of each context and checks its checksums
+
+   Implementation:
+   The file (also gzip compressed) is streamed through xmlTextReader, no
+   DOM is ever built.  Each table param goes straight into one contiguous
+   array of its context, row by row, the Input column checked against
+   the row and dropped.  When a table ends its array is added to the
+   context md5 digest, which is exactly the checksum payload the writer
+   hashes (uint32 words, the HCAL FB LUT as uint64 without its first
+   eta bin), so the md5checksum param is checked as soon as it is read;
+   extra checksum params (sha256checksum, ...) are recomputed from the
+   arrays of the context.  A checksum that does not match is reported,
+   it does not stop the load.
+
+   A card table of type "table:delta" (LUTDocument::setDeltaContexts)
+   starts as a copy of the same table of the processors context, its rows
+   then overwrite the rows given by their Input column, so the arrays and
+   checksums are those of the complete table.
+
+   With a callback each context is handed over when it ends and then
+   dropped, so memory is that of one context and the processors tables
+   (about 0.8 MB) whatever the size of the file.  Only the tables and layer1SecondStageLUT are read,
+   not the other CaloParams vectors of the processors context.
+*/
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace calol1 {
+
+  class LUTXMLLoader {
+  public:
+    struct Context {
+      std::string id;
+      // [0] Minus, [1] Plus, row major without the Input column: ECAL and
+      // HCAL 2*256 rows (fb << 8 | input) of 28 iEta, HF 4*256 rows of
+      // 12 iEta from 30, HCAL FB one row of 28 iEta.  Empty if the
+      // context does not have the table.
+      std::array<std::vector<uint32_t>, 2> ecal;
+      std::array<std::vector<uint32_t>, 2> hcal;
+      std::array<std::vector<uint32_t>, 2> hf;
+      std::array<std::vector<uint64_t>, 2> hcalFB;
+      std::vector<uint32_t> secondStageLUT;
+      // As written, empty if there is none
+      std::string md5checksum;
+
+      size_t nTables() const;
+    };
+
+    struct ChecksumMismatch {
+      std::string context;
+      // md5checksum, sha256checksum, ...
+      std::string id;
+      // Empty if the context has tables but no md5checksum
+      std::string written;
+      std::string computed;
+    };
+
+    // Every context kept, see contexts().  Returns false, see error(),
+    // if the file cannot be read or a table is malformed
+    bool load(const std::string& fileName);
+    // Each context handed to onContext as soon as it is read, nothing
+    // kept; onContext returns false to stop reading
+    bool load(const std::string& fileName, const std::function<bool(const Context&)>& onContext);
+
+    // In document order, processors first
+    const std::vector<Context>& contexts() const { return contexts_; }
+    // nullptr if there is no such context
+    const Context * find(const std::string& id) const;
+
+    // Checksum params recomputed, and those that did not match
+    size_t checkedChecksums() const { return checked_; }
+    const std::vector<ChecksumMismatch>& mismatches() const { return mismatches_; }
+    bool verified() const { return checked_ > 0 && mismatches_.empty(); }
+
+    // Of the last load: XML bytes parsed (uncompressed), file size, wall time
+    uint64_t bytes() const { return bytes_; }
+    uint64_t fileBytes() const { return fileBytes_; }
+    double seconds() const { return seconds_; }
+
+    const std::string& error() const { return error_; }
+
+  private:
+    // Contexts handed over to be moved or copied
+    bool read(const std::string& fileName, const std::function<bool(Context&)>& onContext);
+
+    std::vector<Context> contexts_;
+    size_t checked_{0};
+    std::vector<ChecksumMismatch> mismatches_;
+    uint64_t bytes_{0};
+    uint64_t fileBytes_{0};
+    double seconds_{0.};
+    std::string error_;
+  };
+
+}
+
+#endif
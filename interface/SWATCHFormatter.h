@@ -0,0 +1,84 @@
+#ifndef L1Trigger_L1TCaloLayer1LUTWriter_SWATCHFormatter_h
+#define L1Trigger_L1TCaloLayer1LUTWriter_SWATCHFormatter_h
+// -*- C++ -*-
+//
+// Package:    L1Trigger/L1TCaloLayer1LUTWriter
+// Class:      SWATCHFormatter
+//
+/**\class SWATCHFormatter SWATCHFormatter.h L1Trigger/L1TCaloLayer1LUTWriter/interface/SWATCHFormatter.h
+
+   Description: Formats SWATCH table rows and vector params into a reusable text buffer
+
+   Implementation:
+   Output is identical to what we used to get from a std::stringstream with
+     std::showbase << std::internal << std::setfill('0') << std::setw(width) << std::hex
+   including the iostream quirk that showbase does not print 0x for zero,
+   so 0 comes out as "000000" while 0xff is "0x00ff".
+   The buffer is kept between calls, so after the first few rows
+   formatting a row does not allocate at all.
+*/
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace calol1 {
+
+  class SWATCHFormatter {
+  public:
+    SWATCHFormatter() { buffer_.reserve(1024); }
+
+    void clear() { buffer_.clear(); }
+    const char * c_str() const { return buffer_.c_str(); }
+    size_t size() const { return buffer_.size(); }
+    const std::string& str() const { return buffer_; }
+
+    void appendSeparator() { buffer_.append(", ", 2); }
+    inline void appendHex(uint64_t value, unsigned int width);
+    void appendDecimal(long long int value);
+    void appendDecimal(unsigned long long int value);
+    void appendFloat(float value);
+
+    // Comma separated hex list, e.g. a table row or layer1SecondStageLUT
+    template<typename T>
+    const char * formatHex(const T * values, size_t size, unsigned int width) {
+      clear();
+      for(size_t i=0; i<size; ++i) {
+        if ( i > 0 ) appendSeparator();
+        appendHex(values[i], width);
+      }
+      return c_str();
+    }
+
+    // Comma separated list in the format used by writeSWATCHVector
+    const char * formatList(const std::vector<int>& vect);
+    const char * formatList(const std::vector<unsigned int>& vect);
+    const char * formatList(const std::vector<double>& vect);
+    const char * formatList(const std::vector<unsigned long long int>& vect);
+
+  private:
+    std::string buffer_;
+  };
+
+  inline void
+  SWATCHFormatter::appendHex(uint64_t value, unsigned int width)
+  {
+    static constexpr char digits[] = "0123456789abcdef";
+    char tmp[16];
+    unsigned int nDigits = 0;
+    do {
+      tmp[nDigits++] = digits[value & 0xf];
+      value >>= 4;
+    } while ( value != 0 );
+
+    // std::showbase only adds 0x for non-zero values
+    const bool zero = (nDigits == 1 && tmp[0] == '0');
+    unsigned int length = nDigits + (zero ? 0 : 2);
+    if ( !zero ) buffer_.append("0x", 2);
+    if ( length < width ) buffer_.append(width-length, '0');
+    while ( nDigits > 0 ) buffer_.push_back(tmp[--nDigits]);
+  }
+
+}
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef L1Trigger_L1TCaloLayer1LUTWriter_SWATCHXMLEmitter_h
+#define L1Trigger_L1TCaloLayer1LUTWriter_SWATCHXMLEmitter_h
+// -*- C++ -*-
+//
+// Package:    L1Trigger/L1TCaloLayer1LUTWriter
+// Class:      SWATCHXMLEmitter
+//
+/**\class SWATCHXMLEmitter SWATCHXMLEmitter.h L1Trigger/L1TCaloLayer1LUTWriter/interface/SWATCHXMLEmitter.h
+
+   Description: Writes the SWATCH luts.xml schema directly, without xmlTextWriter
+
+   Implementation:
+   Only knows algo/context/param/columns/types/rows/row, so the
+   indentation is fixed per element instead of tracked, and the markup is
+   appended to one reusable buffer that goes to the xmlOutputBuffer
+   (plain, gzip or zstd file, see CompressedXMLOutput.h) in a single
+   write whenever it holds flushSize bytes.  Row text is copied as is, it
+   only ever holds hex numbers and commas; ids and param values are
+   escaped like xmlTextWriter does.  The bytes are exactly those of an
+   xmlTextWriter with indentation 1 and indent string "  ".
+
+   Like the xmlTextWriter functions every call returns < 0 on error.
+*/
+
+#include <cstddef>
+#include <string>
+
+#include <libxml/xmlIO.h>
+
+namespace calol1 {
+
+  class SWATCHXMLEmitter {
+  public:
+    // Takes ownership of out
+    explicit SWATCHXMLEmitter(xmlOutputBufferPtr out, size_t flushSize = 1 << 20);
+    ~SWATCHXMLEmitter();
+    SWATCHXMLEmitter(const SWATCHXMLEmitter&) = delete;
+    SWATCHXMLEmitter& operator=(const SWATCHXMLEmitter&) = delete;
+
+    // XML declaration and <algo id="...">
+    int startAlgo(const char * id);
+    int startContext(const char * id);
+    // <param id="..." type="...">body</param>
+    int param(const char * id, const char * type, const char * body);
+    // <param id="..." type="table"> (or another type) with its columns and types, up to <rows>
+    int startTable(const char * id, const char * columns, const char * types, const char * type = "table");
+    int row(const char * text);
+    int endTable();
+    int endContext();
+    int endAlgo();
+
+    // Flushes and closes the output, the file is complete after this.
+    // Called by the destructor if needed.
+    int close();
+
+  private:
+    int flush(bool force);
+    void appendEscaped(const char * text, bool attribute);
+
+    xmlOutputBufferPtr out_;
+    size_t flushSize_;
+    std::string buffer_;
+    bool failed_{false};
+  };
+
+}
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef L1Trigger_L1TCaloLayer1LUTWriter_SharedLUTs_h
+#define L1Trigger_L1TCaloLayer1LUTWriter_SharedLUTs_h
+// -*- C++ -*-
+//
+// Package:    L1Trigger/L1TCaloLayer1LUTWriter
+// Class:      SharedLUTs
+//
+/**\class SharedLUTs SharedLUTs.h L1Trigger/L1TCaloLayer1LUTWriter/interface/SharedLUTs.h
+
+   Description: One set of Layer1 LUTs, fetched, repacked, rendered and checksummed once
+
+   Implementation:
+   Owns the CaloParams values, the L1TCaloLayer1FetchLUTs arrays, the
+   decoded HCAL scale (empty unless the producer was asked for it) and a
+   LUTDocument over them.  The document is prepared (every table
+   rendered, every delta row and checksum computed) in the constructor
+   and only handed out const, so writing it whole or by context, writing
+   the binary file, verifying it or diffing it only read it, and any
+   number of consumers may do so concurrently.
+
+   Made by L1TCaloLayer1LUTProducer, handed around through LUTProduct.
+*/
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/HcalScaleTable.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTChecksum.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTDocument.h"
+
+namespace calol1 {
+
+  class SharedLUTs {
+  public:
+    // Rendering and hashing on up to numberOfThreads threads (0 = all available)
+    SharedLUTs(LUTParameters parameters, LUTArrays luts, HcalScaleTable hcalScale, const std::vector<ChecksumAlgorithm>& extraChecksums,
+               bool deltaContexts, std::string fingerprint, int numberOfThreads);
+    SharedLUTs(const SharedLUTs&) = delete;
+    SharedLUTs& operator=(const SharedLUTs&) = delete;
+
+    const LUTParameters& parameters() const { return parameters_; }
+    const LUTArrays& luts() const { return luts_; }
+    const HcalScaleTable& hcalScale() const { return hcalScale_; }
+    const std::vector<ChecksumAlgorithm>& extraChecksums() const { return extraChecksums_; }
+    // Of everything the LUTs were made from, see LUTFingerprint.h
+    const std::string& fingerprint() const { return fingerprint_; }
+
+    // Prepared, see above
+    const LUTDocument& document() const { return *document_; }
+
+  private:
+    const LUTParameters parameters_;
+    const LUTArrays luts_;
+    const HcalScaleTable hcalScale_;
+    const std::vector<ChecksumAlgorithm> extraChecksums_;
+    const std::string fingerprint_;
+    // Refers to the members above
+    std::unique_ptr<LUTDocument> document_;
+  };
+
+}
+
+#endif
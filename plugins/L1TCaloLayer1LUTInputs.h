@@ -0,0 +1,83 @@
+#ifndef L1Trigger_L1TCaloLayer1LUTWriter_L1TCaloLayer1LUTInputs_h
+#define L1Trigger_L1TCaloLayer1LUTWriter_L1TCaloLayer1LUTInputs_h
+// -*- C++ -*-
+//
+// Package:    L1Trigger/L1TCaloLayer1LUTWriter
+//
+// What L1TCaloLayer1LUTWriter and L1TCaloLayer1LUTProducer both take from
+// the EventSetup: the CaloParams values the LUT document is written
+// from, the decoded HCAL scale and the fetched tables part of the input
+// fingerprint.
+//
+
+#include <cstdlib>
+#include <vector>
+
+#include "L1Trigger/L1TCalorimeter/interface/CaloParamsHelper.h"
+#include "CalibFormats/CaloTPG/interface/CaloTPGTranscoder.h"
+#include "DataFormats/HcalDetId/interface/HcalTrigTowerDetId.h"
+#include "DataFormats/HcalDigi/interface/HcalTriggerPrimitiveSample.h"
+
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/HcalScaleTable.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTDocument.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTFingerprint.h"
+
+namespace calol1 {
+
+  // CaloParams values and the LUT options, as passed to L1TCaloLayer1FetchLUTs
+  inline LUTParameters lutParameters(const l1t::CaloParamsHelper& caloParams, bool useLSB, bool useCalib,
+                                     bool useECALLUT, bool useHCALLUT, bool useHFLUT, bool useHCALFBLUT, int firmwareVersion)
+  {
+    LUTParameters parameters;
+    parameters.ecalScaleETBins = caloParams.layer1ECalScaleETBins();
+    parameters.ecalScalePhiBins = caloParams.layer1ECalScalePhiBins();
+    parameters.ecalScaleFactors = caloParams.layer1ECalScaleFactors();
+    parameters.hcalScaleETBins = caloParams.layer1HCalScaleETBins();
+    parameters.hcalScalePhiBins = caloParams.layer1HCalScalePhiBins();
+    parameters.hcalScaleFactors = caloParams.layer1HCalScaleFactors();
+    parameters.hfScaleETBins = caloParams.layer1HFScaleETBins();
+    parameters.hfScalePhiBins = caloParams.layer1HFScalePhiBins();
+    parameters.hfScaleFactors = caloParams.layer1HFScaleFactors();
+    parameters.hcalFBLUTUpper = caloParams.layer1HCalFBLUTUpper();
+    parameters.hcalFBLUTLower = caloParams.layer1HCalFBLUTLower();
+    parameters.secondStageLUT = caloParams.layer1SecondStageLUT();
+    parameters.towerLsbSum = caloParams.towerLsbSum();
+    parameters.useLSB = useLSB;
+    parameters.useCalib = useCalib;
+    parameters.useECALLUT = useECALLUT;
+    parameters.useHCALLUT = useHCALLUT;
+    parameters.useHFLUT = useHFLUT;
+    parameters.useHCALFBLUT = useHCALFBLUT;
+    parameters.firmwareVersion = firmwareVersion;
+    return parameters;
+  }
+
+  // All 256 compressed values of every tower, as hcalScale.txt has them;
+  // hcaletValue is const, towers are decoded concurrently
+  inline void decodeHcalScale(const CaloTPGTranscoder& decoder, HcalScaleTable& hcalScale, int numberOfThreads)
+  {
+    auto decodeTower = [&decoder](int iEta, uint32_t iPhi, double * values) {
+      HcalTrigTowerDetId id(iEta, iPhi);
+      if ( std::abs(iEta) >= 30 ) {
+        id.setVersion(1);
+      }
+      for(uint32_t et=0; et<256; ++et) {
+        values[et] = decoder.hcaletValue(id, HcalTriggerPrimitiveSample(et));
+      }
+    };
+    hcalScale.fill(decodeTower, numberOfThreads);
+  }
+
+  // The fetched tables: the ECAL ones carry the ECAL TPG scale, the HCAL
+  // and HF ones the transcoder (made through hcaletValue), so neither has
+  // to be read, let alone the HCAL scale decoded, to know the LUTs changed
+  inline void addFetchedLUTs(LUTFingerprint& fingerprint, const LUTArrays& luts)
+  {
+    fingerprint.add(luts.ecalLUT);
+    fingerprint.add(luts.hcalLUT);
+    fingerprint.add(luts.hfLUT);
+  }
+
+}
+
+#endif
@@ -0,0 +1,254 @@
+// -*- C++ -*-
+//
+// Package:    L1Trigger/L1TCaloLayer1LUTWriter
+// Class:      L1TCaloLayer1LUTProducer
+//
+/**\class L1TCaloLayer1LUTProducer L1TCaloLayer1LUTProducer.cc L1Trigger/L1TCaloLayer1LUTWriter/plugins/L1TCaloLayer1LUTProducer.cc
+
+   Description: Makes the Layer1 LUTs once per CaloParams/transcoder/ECAL TPG scale IOV for every consumer of the job
+
+   Implementation:
+   The LUTs are fetched with L1TCaloLayer1FetchLUTs, which needs the whole
+   EventSetup and so cannot run in an ESProducer of a single record;
+   instead they are made at the beginning of each run and put in the Run
+   as a LUTProduct.  Runs in the same L1TCaloParamsRcd, CaloTPGRecord and
+   ECAL TPG scale record IOVs share the SharedLUTs of the previous run,
+   nothing is redone.
+   Every L1TCaloLayer1LUTWriter with lutProduct set to this module reads
+   the same prepared LUTDocument concurrently.
+*/
+
+// system include files
+#include <array>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+// user include files
+#include "FWCore/Framework/interface/Frameworkfwd.h"
+#include "FWCore/Framework/interface/global/EDProducer.h"
+
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/Run.h"
+#include "FWCore/Framework/interface/MakerMacros.h"
+#include "FWCore/Utilities/interface/EDPutToken.h"
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/ParameterSet/interface/ConfigurationDescriptions.h"
+#include "FWCore/ParameterSet/interface/ParameterSetDescription.h"
+
+#include "FWCore/Framework/interface/ESHandle.h"
+#include "FWCore/Framework/interface/EventSetup.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+
+#include "L1Trigger/L1TCalorimeter/interface/CaloParamsHelper.h"
+#include "CondFormats/L1TObjects/interface/CaloParams.h"
+#include "CondFormats/DataRecord/interface/L1TCaloParamsRcd.h"
+#include "CondFormats/DataRecord/interface/EcalTPGLutGroupRcd.h"
+#include "CondFormats/DataRecord/interface/EcalTPGLutIdMapRcd.h"
+#include "CondFormats/DataRecord/interface/EcalTPGPhysicsConstRcd.h"
+#include "CalibFormats/CaloTPG/interface/CaloTPGTranscoder.h"
+#include "CalibFormats/CaloTPG/interface/CaloTPGRecord.h"
+
+#include "L1Trigger/L1TCaloLayer1/src/L1TCaloLayer1FetchLUTs.hh"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTProduct.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/SharedLUTs.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/plugins/L1TCaloLayer1LUTInputs.h"
+
+//
+// class declaration
+//
+
+class L1TCaloLayer1LUTProducer : public edm::global::EDProducer<edm::BeginRunProducer> {
+public:
+  explicit L1TCaloLayer1LUTProducer(const edm::ParameterSet& iConfig);
+  ~L1TCaloLayer1LUTProducer();
+
+  static void fillDescriptions(edm::ConfigurationDescriptions& descriptions);
+
+private:
+  //----edm control---
+  virtual void produce(edm::StreamID, edm::Event&, const edm::EventSetup&) const override {}
+  virtual void globalBeginRunProduce(edm::Run& iRun, const edm::EventSetup& iSetup) const override;
+
+  // NULL (and logged) on failure
+  std::shared_ptr<const calol1::SharedLUTs> makeLUTs(const edm::EventSetup& iSetup) const;
+
+  // ----------member data ---------------------------
+
+  const L1TCaloLayer1FetchLUTsTokens lutsTokens;
+  const edm::EDPutTokenT<calol1::LUTProduct> putToken;
+  bool useLSB;
+  bool useCalib;
+  bool useECALLUT;
+  bool useHCALLUT;
+  bool useHFLUT;
+  bool useHCALFBLUT;
+  int firmwareVersion;
+  // Threads used to render and hash the LUT tables: 1 is serial, 0 means all the job has
+  int numberOfThreads;
+  // Digests written next to each md5checksum
+  std::vector<calol1::ChecksumAlgorithm> extraChecksums;
+  // Card tables as the rows differing from the processors ones
+  bool deltaContexts;
+  // The whole HCAL scale, for writers saving hcalScale.txt or a snapshot
+  bool decodeHcalScale;
+  bool verbose;
+
+  // LUTs of the last run and the IOVs they were made in: CaloParams,
+  // transcoder and the three ECAL TPG scale records.  The mutex only
+  // guards reading and publishing them, never making them
+  typedef std::array<unsigned long long, 5> IOVKey;
+  mutable std::mutex lastMutex;
+  mutable IOVKey lastIOV{};
+  mutable std::shared_ptr<const calol1::SharedLUTs> last;
+};
+
+L1TCaloLayer1LUTProducer::L1TCaloLayer1LUTProducer(const edm::ParameterSet& iConfig) :
+  lutsTokens{esConsumes<edm::Transition::BeginRun>(),
+             esConsumes<edm::Transition::BeginRun>(),
+             esConsumes<edm::Transition::BeginRun>()},
+  putToken(produces<calol1::LUTProduct, edm::Transition::BeginRun>()),
+  useLSB(iConfig.getParameter<bool>("useLSB")),
+  useCalib(iConfig.getParameter<bool>("useCalib")),
+  useECALLUT(iConfig.getParameter<bool>("useECALLUT")),
+  useHCALLUT(iConfig.getParameter<bool>("useHCALLUT")),
+  useHFLUT(iConfig.getParameter<bool>("useHFLUT")),
+  useHCALFBLUT(iConfig.getParameter<bool>("useHCALFBLUT")),
+  firmwareVersion(iConfig.getParameter<int>("firmwareVersion")),
+  numberOfThreads(iConfig.getParameter<int>("numberOfThreads")),
+  deltaContexts(iConfig.getParameter<bool>("deltaContexts")),
+  decodeHcalScale(iConfig.getParameter<bool>("decodeHcalScale")),
+  verbose(iConfig.getUntrackedParameter<bool>("verbose"))
+{
+  for(const auto& name : iConfig.getParameter<std::vector<std::string>>("extraChecksums")) {
+    calol1::ChecksumAlgorithm algorithm;
+    if ( !calol1::checksumAlgorithmFromName(name, algorithm) ) {
+      edm::LogError("L1TCaloLayer1LUTProducer") << "Unknown checksum '" << name << "' in extraChecksums, should be sha256 or xxh64";
+      continue;
+    }
+    extraChecksums.push_back(algorithm);
+  }
+}
+
+
+L1TCaloLayer1LUTProducer::~L1TCaloLayer1LUTProducer()
+{
+}
+
+
+//
+// member functions
+//
+
+std::shared_ptr<const calol1::SharedLUTs>
+L1TCaloLayer1LUTProducer::makeLUTs(const edm::EventSetup& iSetup) const
+{
+  // CaloParams contains all persisted parameters for Layer 1
+  edm::ESHandle<l1t::CaloParams> paramsHandle = iSetup.getHandle(lutsTokens.params_);
+  if (not paramsHandle.isValid()) {
+    edm::LogError("L1TCaloLayer1LUTProducer") << "Missing CaloParams object! Check Global Tag, etc.";
+    return nullptr;
+  }
+  l1t::CaloParamsHelper caloParams(*paramsHandle.product());
+
+  calol1::LUTParameters parameters = calol1::lutParameters(caloParams, useLSB, useCalib, useECALLUT, useHCALLUT,
+                                                           useHFLUT, useHCALFBLUT, firmwareVersion);
+
+  // Helper function translates CaloParams into actual LUT vectors
+  calol1::LUTArrays luts;
+  std::vector< unsigned int > ePhiMap(72*2);
+  std::vector< unsigned int > hPhiMap(72*2);
+  std::vector< unsigned int > hfPhiMap(72*2);
+  if(!L1TCaloLayer1FetchLUTs(lutsTokens, iSetup, luts.ecalLUT, luts.hcalLUT, luts.hfLUT, luts.hcalFBLUT, ePhiMap, hPhiMap, hfPhiMap, useLSB, useCalib, useECALLUT, useHCALLUT, useHFLUT, useHCALFBLUT, firmwareVersion)) {
+    edm::LogError("L1TCaloLayer1LUTProducer") << "Failed to fetch LUTs";
+    return nullptr;
+  }
+
+  // Same inputs as the fingerprint of L1TCaloLayer1LUTWriter, without its output options
+  calol1::LUTFingerprint fingerprint;
+  fingerprint.add(parameters);
+  calol1::addFetchedLUTs(fingerprint, luts);
+  for(auto algorithm : extraChecksums) fingerprint.add(calol1::checksumAlgorithmName(algorithm));
+  if ( deltaContexts ) fingerprint.add(std::string("deltaContexts"));
+
+  // Empty unless asked for, nothing else needs it
+  calol1::HcalScaleTable hcalScale;
+  if ( decodeHcalScale ) {
+    edm::ESHandle<CaloTPGTranscoder> decoder = iSetup.getHandle(lutsTokens.decoder_);
+    if (not decoder.isValid()) {
+      edm::LogError("L1TCaloLayer1LUTProducer") << "Missing CaloTPGTranscoder object! Check Global Tag, etc.";
+      return nullptr;
+    }
+    calol1::decodeHcalScale(*decoder, hcalScale, numberOfThreads);
+  }
+
+  return std::make_shared<const calol1::SharedLUTs>(std::move(parameters), std::move(luts), std::move(hcalScale), extraChecksums,
+                                                    deltaContexts, fingerprint.digest(), numberOfThreads);
+}
+
+// ------------ method called at the beginning of each run  ------------
+void
+L1TCaloLayer1LUTProducer::globalBeginRunProduce(edm::Run& iRun, const edm::EventSetup& iSetup) const
+{
+  const IOVKey iov{{iSetup.get<L1TCaloParamsRcd>().cacheIdentifier(),
+                   iSetup.get<CaloTPGRecord>().cacheIdentifier(),
+                   iSetup.get<EcalTPGLutGroupRcd>().cacheIdentifier(),
+                   iSetup.get<EcalTPGLutIdMapRcd>().cacheIdentifier(),
+                   iSetup.get<EcalTPGPhysicsConstRcd>().cacheIdentifier()}};
+  std::shared_ptr<const calol1::SharedLUTs> luts;
+  {
+    std::lock_guard<std::mutex> guard(lastMutex);
+    if ( last != nullptr && iov == lastIOV ) luts = last;
+  }
+  if ( luts == nullptr ) {
+    // Made without the lock, so that concurrent runs of known IOVs are not
+    // held up; two runs of the same new IOV may both make it, the first
+    // one published is kept
+    luts = makeLUTs(iSetup);
+    if ( luts != nullptr ) {
+      std::lock_guard<std::mutex> guard(lastMutex);
+      if ( last != nullptr && iov == lastIOV ) {
+        luts = last;
+      }
+      else {
+        last = luts;
+        lastIOV = iov;
+      }
+    }
+    if ( verbose && luts != nullptr ) {
+      edm::LogInfo("L1TCaloLayer1LUTProducer") << "LUTs made for run " << iRun.run() << " (fingerprint " << luts->fingerprint() << ")";
+    }
+  }
+  // Invalid on failure, consumers log and skip the run
+  iRun.emplace(putToken, std::move(luts));
+}
+
+// ------------ method fills 'descriptions' with the allowed parameters for the module  ------------
+void
+L1TCaloLayer1LUTProducer::fillDescriptions(edm::ConfigurationDescriptions& descriptions) {
+  edm::ParameterSetDescription desc;
+  desc.addUntracked<bool>("verbose", false);
+  desc.add<bool>("useLSB", true);
+  desc.add<bool>("useCalib", true);
+  desc.add<bool>("useECALLUT", true);
+  desc.add<bool>("useHCALLUT", true);
+  desc.add<bool>("useHFLUT", true);
+  desc.add<bool>("useHCALFBLUT", true);
+  desc.add<int>("firmwareVersion", 1);
+  // 0 = use all threads available to the job, 1 = render and hash serially
+  desc.add<int>("numberOfThreads", 0);
+  // More digests of each context written after its md5checksum, as
+  // <name>checksum params: sha256 and/or xxh64
+  desc.add<std::vector<std::string>>("extraChecksums", {});
+  // CTP7 context tables as the rows differing from the processors ones,
+  // see deltaContexts of L1TCaloLayer1LUTWriter
+  desc.add<bool>("deltaContexts", false);
+  // Decode the whole HCAL scale along with the LUTs, needed by writers
+  // with saveHcalScaleFile or snapshotFileName
+  desc.add<bool>("decodeHcalScale", false);
+  descriptions.addDefault(desc);
+}
+
+//define this as a plug-in
+DEFINE_FWK_MODULE(L1TCaloLayer1LUTProducer);
@@ -19,14 +19,17 @@
 
 
 // system include files
+#include <chrono>
 #include <iostream>
 #include <iomanip>
 #include <fstream>
+#include <sstream>
 #include <math.h>
+#include <optional>
+#include <sys/stat.h>
 
 #include <libxml/encoding.h>
 #include <libxml/xmlwriter.h>
-#include <openssl/md5.h>
 
 // user include files
 #include "FWCore/Framework/interface/Frameworkfwd.h"
@@ -34,19 +37,41 @@
 
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
+#include "FWCore/Framework/interface/Run.h"
+#include "FWCore/Utilities/interface/Exception.h"
+#include "FWCore/Utilities/interface/InputTag.h"
 
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/ParameterSet/interface/ConfigurationDescriptions.h"
+#include "FWCore/ParameterSet/interface/ParameterSetDescription.h"
 
 #include "FWCore/Framework/interface/ESHandle.h"
 #include "FWCore/Framework/interface/EventSetup.h"
+#include "FWCore/Framework/interface/ESWatcher.h"
 
 #include "L1Trigger/L1TCalorimeter/interface/CaloParamsHelper.h"
 #include "CondFormats/L1TObjects/interface/CaloParams.h"
 #include "CondFormats/DataRecord/interface/L1TCaloParamsRcd.h"
 
 #include "CondFormats/DataRecord/interface/L1EmEtScaleRcd.h"
+#include "CondFormats/DataRecord/interface/EcalTPGLutGroupRcd.h"
+#include "CondFormats/DataRecord/interface/EcalTPGLutIdMapRcd.h"
+#include "CondFormats/DataRecord/interface/EcalTPGPhysicsConstRcd.h"
 
 #include "L1Trigger/L1TCaloLayer1/src/L1TCaloLayer1FetchLUTs.hh"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTDocument.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/HcalScaleTable.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTManifest.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTFingerprint.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/CompressedXMLOutput.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTSplitWriter.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTDiff.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTMetrics.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTVerification.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTProduct.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/SharedLUTs.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTSnapshot.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/plugins/L1TCaloLayer1LUTInputs.h"
 
 #include "CalibFormats/CaloTPG/interface/CaloTPGTranscoder.h"
 #include "CalibFormats/CaloTPG/interface/CaloTPGRecord.h"
@@ -78,32 +103,29 @@ private:
   virtual void endLuminosityBlock(edm::LuminosityBlock const&, edm::EventSetup const&) override;
 
 
-  bool writeXMLParam(std::string id, std::string type, std::string body);
-  bool writeSWATCHVector(std::string id, const std::vector<int> vect);
-  bool writeSWATCHVector(std::string id, const std::vector<unsigned int> vect);
-  bool writeSWATCHVector(std::string id, const std::vector<double> vect);
-  bool writeSWATCHVector(std::string id, const std::vector<unsigned long long int> vect);
-  bool writeSWATCHTableRow(std::vector<uint32_t> vect);
-  bool writeSWATCHTableRow(std::vector<uint64_t> vect);
+  // CaloParams values the LUT document is written from
+  calol1::LUTParameters lutParameters(const l1t::CaloParamsHelper& caloParams) const;
 
-  bool writeECALLUT(std::string id, uint32_t index, MD5_CTX& md5context);
-  bool writeHCALLUT(std::string id, uint32_t index, MD5_CTX& md5context);
-  bool writeHFLUT(std::string id, uint32_t index, MD5_CTX& md5context);
-  bool writeHCALFBLUT(std::string id, uint32_t index, MD5_CTX& md5context);
-
-  // Wrapper for xmllib error codes
-  // returnCode < 0 if error
-  inline bool rcWrap(int rc) const {
-    if ( rc < 0 ) {
-      edm::LogError("L1TCaloLayer1LUTWriter") << "Error while processing an xmllib command :<";
-      return false;
-    }
-    return true;
-  };
+  // NULL (and logged) on failure
+  xmlTextWriterPtr newWriter(const std::string& name) const;
+  // Everything the LUTs are made from, see LUTFingerprint.h
+  std::string inputFingerprint(const calol1::LUTParameters& parameters, const calol1::LUTArrays& luts) const;
+  // Same from the fingerprint L1TCaloLayer1LUTProducer made of its inputs
+  std::string inputFingerprint(const calol1::SharedLUTs& shared) const;
+  // True if the sidecar of xmlName has the same fingerprint and all
+  // outputs exist; the sidecar checksums are then copied over
+  bool upToDate(const std::string& xmlName, unsigned int run, calol1::LUTSidecar& sidecar) const;
+  // In sweep mode files are named after the first run of their IOV,
+  // luts.xml.gz -> luts_run355100.xml.gz
+  std::string outputFileName(const std::string& name, unsigned int run) const;
 
   // ----------member data ---------------------------
 
-  const L1TCaloLayer1FetchLUTsTokens lutsTokens;
+  // Unset with lutProduct, the producer consumes the records instead
+  std::optional<L1TCaloLayer1FetchLUTsTokens> lutsTokens;
+  // LUTs of L1TCaloLayer1LUTProducer instead of fetching them here, if the label is not empty
+  edm::InputTag lutProductTag;
+  edm::EDGetTokenT<calol1::LUTProduct> lutProductToken;
   bool useLSB;
   bool useCalib;
   bool useECALLUT;
@@ -112,24 +134,87 @@ private:
   bool useHCALFBLUT;
   int firmwareVersion;
   bool saveHcalScaleFile;
-
-  std::vector< std::array< std::array< std::array<uint32_t, l1tcalo::nEtBins>, l1tcalo::nCalSideBins >, l1tcalo::nCalEtaBins> > ecalLUT;
-  std::vector< std::array< std::array< std::array<uint32_t, l1tcalo::nEtBins>, l1tcalo::nCalSideBins >, l1tcalo::nCalEtaBins> > hcalLUT;
-  std::vector< std::array< std::array<uint32_t, l1tcalo::nEtBins>, l1tcalo::nHfEtaBins > > hfLUT;
-  std::vector< unsigned long long int > hcalFBLUT;
+  // Threads used to render the LUT tables: 1 is serial, 0 means all the job has
+  int numberOfThreads;
+  // Rows per chunk of the streamed XML writing, 0 renders all tables first
+  unsigned int pipelineChunkRows;
+  // Chunks in flight at most
+  unsigned int pipelineDepth;
+  // libxml2 (xmlTextWriter) or direct (SWATCHXMLEmitter), same bytes
+  std::string xmlWriter;
+  // One file per context and an index instead of fileName, see LUTSplitWriter.h
+  bool splitOutput;
+  // Earlier LUT output (xml or bin) the new LUTs are diffed against, not if empty
+  std::string diffReference;
+  // The diff as JSON, only logged if empty
+  std::string diffFileName;
+  // Check every written cell against the FetchLUTs arrays, the job fails on a mismatch
+  bool verify;
+  std::string fileName;
+  std::string compression;
+  int compressionLevel;
+  // Optional binary copy of the LUTs, not written if empty
+  std::string binaryFileName;
+  std::string hcalScaleFileName;
+  // Binary float table of the HCAL scale, not written if empty
+  std::string hcalScaleBinaryFileName;
+  // Inputs of the written files for calol1LUTFromSnapshot, not written if empty
+  std::string snapshotFileName;
+  // Digests written next to each md5checksum
+  std::vector<calol1::ChecksumAlgorithm> extraChecksums;
+  // Card tables as the rows differing from the processors ones
+  bool deltaContexts;
+
+  // Filled by L1TCaloLayer1FetchLUTs
+  calol1::LUTArrays luts;
 
   std::vector< unsigned int > ePhiMap;
   std::vector< unsigned int > hPhiMap;
   std::vector< unsigned int > hfPhiMap;
 
   bool verbose;
-  xmlTextWriterPtr writer_;
+  // Regenerate even if the inputs did not change
+  bool force;
+  // One output per CaloParams/transcoder/ECAL TPG scale IOV instead of one per event
+  bool sweep;
+  std::string manifestFileName;
+  // The records the LUTs are fetched from, only watched without lutProduct
+  struct SweepWatchers {
+    edm::ESWatcher<L1TCaloParamsRcd> params;
+    edm::ESWatcher<CaloTPGRecord> transcoder;
+    // The ECAL TPG scale L1TCaloLayer1FetchLUTs makes the ECAL LUTs with
+    edm::ESWatcher<EcalTPGLutGroupRcd> ecalLutGroup;
+    edm::ESWatcher<EcalTPGLutIdMapRcd> ecalLutIdMap;
+    edm::ESWatcher<EcalTPGPhysicsConstRcd> ecalPhysicsConst;
+
+    // Every watcher has to see every event
+    bool check(const edm::EventSetup& iSetup) {
+      bool changed = params.check(iSetup);
+      changed |= transcoder.check(iSetup);
+      changed |= ecalLutGroup.check(iSetup);
+      changed |= ecalLutIdMap.check(iSetup);
+      changed |= ecalPhysicsConst.check(iSetup);
+      return changed;
+    }
+  };
+  std::optional<SweepWatchers> sweepWatchers;
+  // With lutProduct a new set of LUTs is a new producer fingerprint
+  std::string sweepFingerprint;
+  // An IOV changed and its files and manifest entry are not written yet
+  bool sweepPending{false};
+  calol1::LUTManifest manifest;
+  // Only for saveHcalScaleFile and snapshotFileName, kept across events,
+  // redecoded when CaloTPGRecord changes; with lutProduct the producer's is used
+  calol1::HcalScaleTable hcalScale;
+  // Stage timers and counters of the whole job, reported at endJob
+  bool reportMetrics;
+  std::string metricsFileName;
+  calol1::LUTMetrics metrics;
+  edm::ESWatcher<CaloTPGRecord> hcalScaleWatcher;
 };
 
 L1TCaloLayer1LUTWriter::L1TCaloLayer1LUTWriter(const edm::ParameterSet& iConfig) :
-  lutsTokens{esConsumes<edm::Transition::Event>(),
-             esConsumes<edm::Transition::Event>(),
-             esConsumes<edm::Transition::Event>()},
+  lutProductTag(iConfig.getParameter<edm::InputTag>("lutProduct")),
   useLSB(iConfig.getParameter<bool>("useLSB")),
   useCalib(iConfig.getParameter<bool>("useCalib")),
   useECALLUT(iConfig.getParameter<bool>("useECALLUT")),
@@ -138,32 +223,66 @@ L1TCaloLayer1LUTWriter::L1TCaloLayer1LUTWriter(const edm::ParameterSet& iConfig)
   useHCALFBLUT(iConfig.getParameter<bool>("useHCALFBLUT")),
   firmwareVersion(iConfig.getParameter<int>("firmwareVersion")),
   saveHcalScaleFile(iConfig.getParameter<bool>("saveHcalScaleFile")),
+  numberOfThreads(iConfig.getParameter<int>("numberOfThreads")),
+  pipelineChunkRows(iConfig.getParameter<unsigned int>("pipelineChunkRows")),
+  pipelineDepth(iConfig.getParameter<unsigned int>("pipelineDepth")),
+  xmlWriter(iConfig.getParameter<std::string>("xmlWriter")),
+  splitOutput(iConfig.getParameter<bool>("splitOutput")),
+  diffReference(iConfig.getParameter<std::string>("diffReference")),
+  diffFileName(iConfig.getParameter<std::string>("diffFileName")),
+  verify(iConfig.getParameter<bool>("verify")),
+  fileName(iConfig.getParameter<std::string>("fileName")),
+  compression(iConfig.getParameter<std::string>("compression")),
+  compressionLevel(iConfig.getParameter<int>("compressionLevel")),
+  binaryFileName(iConfig.getParameter<std::string>("binaryFileName")),
+  hcalScaleFileName(iConfig.getParameter<std::string>("hcalScaleFileName")),
+  hcalScaleBinaryFileName(iConfig.getParameter<std::string>("hcalScaleBinaryFileName")),
+  snapshotFileName(iConfig.getParameter<std::string>("snapshotFileName")),
+  deltaContexts(iConfig.getParameter<bool>("deltaContexts")),
   ePhiMap(72*2),
   hPhiMap(72*2),
   hfPhiMap(72*2),
-  verbose(iConfig.getUntrackedParameter<bool>("verbose"))
+  verbose(iConfig.getUntrackedParameter<bool>("verbose")),
+  force(iConfig.getParameter<bool>("force")),
+  sweep(iConfig.getParameter<bool>("sweep")),
+  manifestFileName(iConfig.getParameter<std::string>("manifestFileName")),
+  reportMetrics(iConfig.getUntrackedParameter<bool>("reportMetrics")),
+  metricsFileName(iConfig.getUntrackedParameter<std::string>("metricsFileName")),
+  metrics(reportMetrics || !metricsFileName.empty())
 {
-  std::string fileName = iConfig.getParameter<std::string>("fileName");
-
-  writer_ = xmlNewTextWriterFilename(fileName.c_str(), 0);
-  if (writer_ == NULL) {
-    edm::LogError("L1TCaloLayer1LUTWriter") << ("testXmlwriterFilename: Error creating the xml writer");
+  for(const auto& name : iConfig.getParameter<std::vector<std::string>>("extraChecksums")) {
+    calol1::ChecksumAlgorithm algorithm;
+    if ( !calol1::checksumAlgorithmFromName(name, algorithm) ) {
+      edm::LogError("L1TCaloLayer1LUTWriter") << "Unknown checksum '" << name << "' in extraChecksums, should be sha256 or xxh64";
+      continue;
+    }
+    extraChecksums.push_back(algorithm);
+  }
+  if ( lutProductTag.label().empty() ) {
+    lutsTokens = L1TCaloLayer1FetchLUTsTokens{esConsumes<edm::Transition::Event>(),
+                                              esConsumes<edm::Transition::Event>(),
+                                              esConsumes<edm::Transition::Event>()};
+    if ( sweep ) sweepWatchers.emplace();
   }
   else {
-    // See these links for why this is bad:
-    // https://www.w3.org/TR/2008/REC-xml-20081126/#sec-white-space
-    // http://usingxml.com/Basics/XmlSpace
-    xmlTextWriterSetIndent(writer_, 1);
-    // If curious about all this BAD_CAST stuff:
-    // http://xmlsoft.org/html/libxml-xmlstring.html#BAD_CAST
-    xmlTextWriterSetIndentString(writer_, BAD_CAST "  ");
+    lutProductToken = consumes<calol1::LUTProduct, edm::InRun>(lutProductTag);
+    if ( !extraChecksums.empty() ) {
+      edm::LogWarning("L1TCaloLayer1LUTWriter") << "extraChecksums is ignored with lutProduct, the LUTs come with the checksums of "
+                                                << lutProductTag.label();
+    }
+    if ( deltaContexts ) {
+      edm::LogWarning("L1TCaloLayer1LUTWriter") << "deltaContexts is ignored with lutProduct, set it on " << lutProductTag.label();
+    }
+  }
+  if ( xmlWriter != "libxml2" && xmlWriter != "direct" ) {
+    edm::LogError("L1TCaloLayer1LUTWriter") << "Unknown xmlWriter '" << xmlWriter << "', should be libxml2 or direct; using libxml2";
+    xmlWriter = "libxml2";
   }
 }
 
 
 L1TCaloLayer1LUTWriter::~L1TCaloLayer1LUTWriter()
 {
-  xmlFreeTextWriter(writer_);
 }
 
 
@@ -171,514 +290,372 @@ L1TCaloLayer1LUTWriter::~L1TCaloLayer1LUTWriter()
 // member functions
 //
 
-bool
-L1TCaloLayer1LUTWriter::writeXMLParam(std::string id, std::string type, std::string body)
+xmlTextWriterPtr
+L1TCaloLayer1LUTWriter::newWriter(const std::string& name) const
 {
-  if ( !rcWrap(xmlTextWriterStartElement(writer_, BAD_CAST "param")) ) return false;
-  if ( !rcWrap(xmlTextWriterWriteAttribute(writer_, BAD_CAST "id", BAD_CAST id.c_str())) ) return false;
-  if ( !rcWrap(xmlTextWriterWriteAttribute(writer_, BAD_CAST "type", BAD_CAST type.c_str())) ) return false;
-  if ( !rcWrap(xmlTextWriterWriteString(writer_, BAD_CAST body.c_str())) ) return false;
-  if ( !rcWrap(xmlTextWriterEndElement(writer_)) ) return false;
-
-  // Success!
-  return true;
-}
-
-
-bool
-L1TCaloLayer1LUTWriter::writeSWATCHTableRow(std::vector<uint32_t> vect)
-{
-  std::stringstream output;
-  for(auto it=vect.begin(); it!=vect.end(); ++it) {
-    output << std::showbase << std::internal << std::setfill('0') << std::setw(6) << std::hex << *it;
-    if ( it != vect.end()-1 ) {
-      output << ", ";
-    }
+  xmlTextWriterPtr writer = calol1::newXMLTextWriter(name, compression, compressionLevel);
+  if (writer == NULL) {
+    edm::LogError("L1TCaloLayer1LUTWriter") << "Error creating the xml writer for " << name
+                                            << " (compression '" << compression << "', should be none, gzip or zstd)";
+    return NULL;
   }
-
-  if ( !rcWrap(xmlTextWriterWriteElement(writer_, BAD_CAST "row", BAD_CAST output.str().c_str())) ) return false;
-  return true;
+  // See these links for why this is bad:
+  // https://www.w3.org/TR/2008/REC-xml-20081126/#sec-white-space
+  // http://usingxml.com/Basics/XmlSpace
+  xmlTextWriterSetIndent(writer, 1);
+  // If curious about all this BAD_CAST stuff:
+  // http://xmlsoft.org/html/libxml-xmlstring.html#BAD_CAST
+  xmlTextWriterSetIndentString(writer, BAD_CAST "  ");
+  return writer;
 }
 
-bool
-L1TCaloLayer1LUTWriter::writeSWATCHTableRow(std::vector<uint64_t> vect)
+std::string
+L1TCaloLayer1LUTWriter::outputFileName(const std::string& name, unsigned int run) const
 {
-  std::stringstream output;
-  for(auto it=vect.begin(); it!=vect.end(); ++it) {
-    output << std::showbase << std::internal << std::setfill('0') << std::setw(6) << std::hex << *it;
-    if ( it != vect.end()-1 ) {
-      output << ", ";
-    }
-  }
-
-  if ( !rcWrap(xmlTextWriterWriteElement(writer_, BAD_CAST "row", BAD_CAST output.str().c_str())) ) return false;
-  return true;
+  if ( !sweep || name.empty() ) return name;
+  size_t base = name.rfind('/');
+  base = (base == std::string::npos) ? 0 : base+1;
+  size_t dot = name.find('.', base);
+  if ( dot == std::string::npos ) dot = name.size();
+  return name.substr(0, dot) + "_run" + std::to_string(run) + name.substr(dot);
 }
 
-bool
-L1TCaloLayer1LUTWriter::writeSWATCHVector(std::string id, const std::vector<int> vect)
+calol1::LUTParameters
+L1TCaloLayer1LUTWriter::lutParameters(const l1t::CaloParamsHelper& caloParams) const
 {
-  std::stringstream output;
-  for(auto it=vect.begin(); it!=vect.end(); ++it) {
-    output << *it;
-    if ( it != vect.end()-1 ) {
-      output << ", ";
-    }
-  }
-  return writeXMLParam(id, "vector:int", output.str());
+  return calol1::lutParameters(caloParams, useLSB, useCalib, useECALLUT, useHCALLUT, useHFLUT, useHCALFBLUT, firmwareVersion);
 }
 
-bool
-L1TCaloLayer1LUTWriter::writeSWATCHVector(std::string id, const std::vector<unsigned int> vect)
+// ------------ method called for each event  ------------
+void
+L1TCaloLayer1LUTWriter::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup)
 {
-  std::stringstream output;
-  for(auto it=vect.begin(); it!=vect.end(); ++it) {
-    output << *it;
-    if ( it != vect.end()-1 ) {
-      output << ", ";
+  const unsigned int run = iEvent.id().run();
+
+  // Fetched, repacked and checksummed once for all consumers of the job
+  std::shared_ptr<const calol1::SharedLUTs> shared;
+  if ( !lutProductTag.label().empty() ) {
+    const calol1::LUTProduct& product = iEvent.getRun().get(lutProductToken);
+    if ( !product.isValid() ) {
+      edm::LogError("L1TCaloLayer1LUTWriter") << "No LUTs from " << lutProductTag.label() << " for run " << run;
+      return;
     }
+    shared = product.shared();
   }
-  return writeXMLParam(id, "vector:uint", output.str());
-}
 
-bool
-L1TCaloLayer1LUTWriter::writeSWATCHVector(std::string id, const std::vector<double> vect)
-{
-  std::stringstream output;
-  for(auto it=vect.begin(); it!=vect.end(); ++it) {
-    output << (float) *it;
-    if ( it != vect.end()-1 ) {
-      output << ", ";
+  if ( sweep ) {
+    // A change stays pending until the files of the new IOV are written,
+    // so that a failed run does not leave the next runs of that IOV on
+    // the previous files
+    if ( shared ) {
+      if ( shared->fingerprint() != sweepFingerprint ) {
+        sweepFingerprint = shared->fingerprint();
+        sweepPending = true;
+      }
+    }
+    else if ( sweepWatchers->check(iSetup) ) {
+      sweepPending = true;
+    }
+    if ( !manifest.empty() && !sweepPending ) {
+      // Same LUTs as the last file written
+      manifest.addRun(run);
+      return;
     }
   }
-  return writeXMLParam(id, "vector:float", output.str());
-}
 
-bool
-L1TCaloLayer1LUTWriter::writeSWATCHVector(std::string id, const std::vector<unsigned long long int> vect)
-{
-  std::stringstream output;
-  for(auto it=vect.begin(); it!=vect.end(); ++it) {
-    output << (float) *it;
-    if ( it != vect.end()-1 ) {
-      output << ", ";
+  calol1::LUTParameters parameters;
+  if ( !shared ) {
+    // CaloParams contains all persisted parameters for Layer 1
+    edm::ESHandle<l1t::CaloParams> paramsHandle = iSetup.getHandle(lutsTokens->params_);
+    if (not paramsHandle.isValid()) {
+      edm::LogError("L1TCaloLayer1LUTWriter") << "Missing CaloParams object! Check Global Tag, etc.";
+      return;
+    }
+    l1t::CaloParamsHelper caloParams(*paramsHandle.product());
+    parameters = lutParameters(caloParams);
+
+    // Before the fingerprint, which only sees the ECAL TPG scale and the
+    // HCAL transcoder through the tables made from them
+    calol1::LUTMetrics::Timer fetchTimer(&metrics, "fetch LUTs");
+    if(!L1TCaloLayer1FetchLUTs(*lutsTokens, iSetup, luts.ecalLUT, luts.hcalLUT, luts.hfLUT, luts.hcalFBLUT, ePhiMap, hPhiMap, hfPhiMap, useLSB, useCalib, useECALLUT, useHCALLUT, useHFLUT, useHCALFBLUT, firmwareVersion)) {
+      edm::LogError("L1TCaloLayer1LUTWriter") << "Failed to fetch LUTs";
+      return;
     }
+
+    fetchTimer.stop();
+    metrics.count("LUT sets");
   }
-  return writeXMLParam(id, "vector:uint64", output.str());
-}
 
-// ------------ method called for each event  ------------
-void
-L1TCaloLayer1LUTWriter::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup)
-{
-  // Can't bail out of constructor, so bail here
-  if ( writer_ == NULL ) return;
+  const std::string xmlName = outputFileName(fileName, run);
 
-  // CaloParams contains all persisted parameters for Layer 1
-  edm::ESHandle<l1t::CaloParams> paramsHandle = iSetup.getHandle(lutsTokens.params_);
-  if (not paramsHandle.isValid()) {
-    edm::LogError("L1TCaloLayer1LUTWriter") << "Missing CaloParams object! Check Global Tag, etc.";
+  // Nothing to do if the files are there and were made from the same inputs
+  calol1::LUTSidecar sidecar;
+  {
+    calol1::LUTMetrics::Timer timer(&metrics, "fingerprint");
+    sidecar.fingerprint = shared ? inputFingerprint(*shared) : inputFingerprint(parameters, luts);
+  }
+  // verify and diffReference check the LUTs being written, so they always regenerate
+  if ( !force && !verify && diffReference.empty() && upToDate(xmlName, run, sidecar) ) {
+    calol1::LUTMetrics::count(&metrics, "up to date");
+    if ( sweep ) {
+      calol1::LUTManifest::Entry& entry = manifest.add(splitOutput ? calol1::LUTSplitWriter::indexFileName(xmlName) : xmlName);
+      entry.checksums = sidecar.checksums;
+      manifest.addRun(run);
+      sweepPending = false;
+    }
+    if ( verbose ) {
+      edm::LogInfo("L1TCaloLayer1LUTWriter") << xmlName << " is up to date (fingerprint " << sidecar.fingerprint << "), not regenerated";
+    }
     return;
   }
-  l1t::CaloParamsHelper caloParams(*paramsHandle.product());
 
-  if ( saveHcalScaleFile ) {
-    edm::ESHandle<CaloTPGTranscoder> decoder = iSetup.getHandle(lutsTokens.decoder_);
+  // Only the outputs carrying the HCAL scale need it decoded, only again
+  // when the transcoder changes
+  const bool needHcalScale = saveHcalScaleFile || !snapshotFileName.empty();
+  if ( needHcalScale && shared && shared->hcalScale().empty() ) {
+    edm::LogError("L1TCaloLayer1LUTWriter") << "saveHcalScaleFile and snapshotFileName need the HCAL scale, set decodeHcalScale of "
+                                            << lutProductTag.label();
+    return;
+  }
+  if ( needHcalScale && !shared && (hcalScaleWatcher.check(iSetup) || hcalScale.empty()) ) {
+    edm::ESHandle<CaloTPGTranscoder> decoder = iSetup.getHandle(lutsTokens->decoder_);
     if (not decoder.isValid()) {
       edm::LogError("L1TCaloLayer1LUTWriter") << "Missing CaloTPGTranscoder object! Check Global Tag, etc.";
       return;
     }
-    auto decodeHcalEt = [&decoder](int iEta, uint32_t compressedEt, uint32_t iPhi=3) -> double {
-      HcalTriggerPrimitiveSample sample(compressedEt);
-      HcalTrigTowerDetId id(iEta, iPhi);
-      if ( std::abs(iEta) >= 30 ) {
-        id.setVersion(1);
-      }
-      return decoder->hcaletValue(id, sample);
-    };
-    std::ofstream hs("hcalScale.txt");
-    hs << std::fixed << std::setprecision(1);
-    for(int iEta=-41; iEta<=41; ++iEta) {
-      if ( iEta == 0 ) continue;
-      for(uint32_t iPhi=1; iPhi<=72; ++iPhi) {
-        hs << "eta " << std::setw(3) << iEta << " phi " << std::setw(2) << iPhi;
-        for(uint32_t et=0; et<256; ++et) {
-          hs << std::setw(7) << decodeHcalEt(iEta, et, iPhi);
-        }
-        hs << std::endl;
-      }
+    auto t0 = std::chrono::steady_clock::now();
+    calol1::LUTMetrics::Timer timer(&metrics, "decode hcalScale");
+    calol1::decodeHcalScale(*decoder, hcalScale, numberOfThreads);
+    if ( verbose ) {
+      typedef std::chrono::duration<double, std::milli> ms;
+      edm::LogInfo("L1TCaloLayer1LUTWriter") << "HCAL scale decoded in " << ms(std::chrono::steady_clock::now()-t0).count() << " ms";
     }
-    hs.close();
   }
-  
-  // Helper function translates CaloParams into actual LUT vectors
- 
-  if(!L1TCaloLayer1FetchLUTs(lutsTokens, iSetup, ecalLUT, hcalLUT, hfLUT, hcalFBLUT, ePhiMap, hPhiMap, hfPhiMap, useLSB, useCalib, useECALLUT, useHCALLUT, useHFLUT, useHCALFBLUT, firmwareVersion)) {
-    edm::LogError("L1TCaloLayer1LUTWriter") << "Failed to fetch LUTs";
-    return;
+
+  const calol1::HcalScaleTable& scale = shared ? shared->hcalScale() : hcalScale;
+  if ( saveHcalScaleFile ) {
+    calol1::LUTMetrics::Timer timer(&metrics, "write hcalScale");
+    const std::string textName = outputFileName(hcalScaleFileName, run);
+    if ( !scale.writeText(textName, numberOfThreads) ) {
+      edm::LogError("L1TCaloLayer1LUTWriter") << "Failed to write " << textName;
+      return;
+    }
+    const std::string binaryName = outputFileName(hcalScaleBinaryFileName, run);
+    if ( !binaryName.empty() && !scale.writeBinary(binaryName) ) {
+      edm::LogError("L1TCaloLayer1LUTWriter") << "Failed to write " << binaryName;
+      return;
+    }
   }
 
-  if ( !rcWrap(xmlTextWriterStartDocument(writer_, NULL, NULL, NULL)) ) return;
-
-  // Root node <algo>
-  if ( !rcWrap(xmlTextWriterStartElement(writer_, BAD_CAST "algo")) ) return;
-  if ( !rcWrap(xmlTextWriterWriteAttribute(writer_, BAD_CAST "id", BAD_CAST "calol1")) ) return;
-
-  // SWATCH magic for all cards
-  // different LUTs are added via contexts at the end
-  if ( !rcWrap(xmlTextWriterStartElement(writer_, BAD_CAST "context")) ) return;
-  if ( !rcWrap(xmlTextWriterWriteAttribute(writer_, BAD_CAST "id", BAD_CAST "processors")) ) return;
-
-  // LUT generation parameters
-  // This is not needed for SWATCH
-  // but necessary for O2O, given the offline format
-  // (i.e. what we are reading right now)
-  // NB "layer1SecondStageLUT" written later since it is same format as offline
-  if ( !writeSWATCHVector("layer1ECalScaleETBins", caloParams.layer1ECalScaleETBins()) ) return;
-  if ( !writeSWATCHVector("layer1ECalScalePhiBins", caloParams.layer1ECalScalePhiBins()) ) return;
-  if ( !writeSWATCHVector("layer1ECalScaleFactors", caloParams.layer1ECalScaleFactors()) ) return;
-  if ( !writeSWATCHVector("layer1HCalScaleETBins", caloParams.layer1HCalScaleETBins()) ) return;
-  if ( !writeSWATCHVector("layer1HCalScalePhiBins", caloParams.layer1HCalScalePhiBins()) ) return;
-  if ( !writeSWATCHVector("layer1HCalScaleFactors", caloParams.layer1HCalScaleFactors()) ) return;
-  if ( !writeSWATCHVector("layer1HFScaleETBins", caloParams.layer1HFScaleETBins()) ) return;
-  if ( !writeSWATCHVector("layer1HFScalePhiBins", caloParams.layer1HFScalePhiBins()) ) return;
-  if ( !writeSWATCHVector("layer1HFScaleFactors", caloParams.layer1HFScaleFactors()) ) return;
-  if ( !writeSWATCHVector("layer1HFScaleFactors", caloParams.layer1HFScaleFactors()) ) return;
-  if ( !writeSWATCHVector("layer1HCalFBLUTUpper", caloParams.layer1HCalFBLUTUpper()) ) return;
-  if ( !writeSWATCHVector("layer1HCalFBLUTLower", caloParams.layer1HCalFBLUTLower()) ) return;
-  if ( !writeXMLParam("towerLsbSum", "float", std::to_string(caloParams.towerLsbSum())) ) return;
-  if ( !writeXMLParam("useLSB", "bool", (useLSB) ? "true":"false") ) return;
-  if ( !writeXMLParam("useCalib", "bool", (useCalib) ? "true":"false") ) return;
-  if ( !writeXMLParam("useECALLUT", "bool", (useECALLUT) ? "true":"false") ) return;
-  if ( !writeXMLParam("useHCALLUT", "bool", (useHCALLUT) ? "true":"false") ) return;
-  if ( !writeXMLParam("useHFLUT", "bool", (useHFLUT) ? "true":"false") ) return;
-  if ( !writeXMLParam("useHCALFBLUT", "bool", (useHCALFBLUT) ? "true":"false") ) return;
-
-  // We will checksum the LUT contents and put it at the end
-  MD5_CTX md5context;
-  MD5_Init(&md5context);
-
-  // Loop and write the ECAL LUT -> Minus and Plus
-  if ( !writeECALLUT("ECALLUTMinus",0,md5context) ) return;
-  if ( !writeECALLUT("ECALLUTPlus",0,md5context) ) return;
-
-  // Loop and write the HCAL LUT -> Minus and Plus
-  if ( !writeHCALLUT("HCALLUTMinus",0,md5context) ) return;
-  if ( !writeHCALLUT("HCALLUTPlus",0,md5context) ) return;
-
-  // Firmware version 2 has also second-stage LUT (aka HoverE LUT)
-  if ( firmwareVersion > 1 ) {
-    const std::vector<uint32_t>& lut = caloParams.layer1SecondStageLUT();
-    std::stringstream output;
-    for(auto it=lut.begin(); it!=lut.end(); ++it) {
-      output << std::showbase << std::internal << std::setfill('0') << std::setw(10) << std::hex << *it;
-      if ( it != lut.end()-1 ) {
-        output << ", ";
-      }
+  // The pipeline renders and hashes while writing, anything else reads a prepared document
+  const bool streamed = pipelineChunkRows > 0 && !shared && !splitOutput;
+  std::unique_ptr<calol1::LUTDocument> ownDocument;
+  if ( !shared ) {
+    // Over the LUT vectors L1TCaloLayer1FetchLUTs translated CaloParams into
+    ownDocument = std::make_unique<calol1::LUTDocument>(parameters, luts);
+    ownDocument->setExtraChecksums(extraChecksums);
+    ownDocument->setDeltaContexts(deltaContexts);
+    ownDocument->setMetrics(&metrics);
+    // Every distinct table rendered, possibly in parallel, then the
+    // contexts are written in card order so the output does not depend
+    // on the number of threads
+    if ( !streamed || verify ) ownDocument->prepare(numberOfThreads);
+  }
+  else {
+    metrics.count("shared LUT sets");
+  }
+  // Shared LUTs are already prepared, only read from here on
+  const calol1::LUTDocument& document = shared ? shared->document() : *ownDocument;
+
+  // Before anything is written, so that a bad set of LUTs leaves no file
+  if ( verify ) {
+    calol1::LUTMetrics::Timer timer(&metrics, "verify");
+    calol1::LUTVerification verification(document, numberOfThreads);
+    if ( !verification.passed() ) {
+      std::ostringstream report;
+      verification.print(report);
+      throw cms::Exception("L1TCaloLayer1LUTWriter") << verification.failures().size() << " of " << verification.checkedTables()
+                                                     << " LUT tables do not match L1TCaloLayer1FetchLUTs for firmware "
+                                                     << document.parameters().firmwareVersion << ":\n"
+                                                     << report.str();
     }
-    if ( !writeXMLParam("layer1SecondStageLUT", "vector:uint", output.str()) ) return;
-    MD5_Update(&md5context, &lut[0], lut.size()*sizeof(uint32_t));
-  }
-
-  // Loop and write the HF LUT -> Minus and Plus
-  if ( !writeHFLUT("HFLUTMinus",0,md5context) ) return;
-  if ( !writeHFLUT("HFLUTPlus",0,md5context) ) return;
-
-  // Loop and write the HCAL FB LUT -> Minus and Plus
-  if ( !writeHCALFBLUT("HCALFBLUTMinus",0,md5context) ) return;
-  if ( !writeHCALFBLUT("HCALFBLUTPlus",0,md5context) ) return;
-
-  // Now to write the checksum
-  unsigned char checksum[MD5_DIGEST_LENGTH];
-  MD5_Final(checksum, &md5context);
-  std::stringstream checksumString;
-  checksumString << std::hex << std::setfill('0');
-  for(size_t i=0; i<MD5_DIGEST_LENGTH; ++i) {
-    checksumString << std::setw(2) << static_cast<unsigned int>(checksum[i]);
-  }
-  if ( !writeXMLParam("md5checksum", "string", checksumString.str()) ) return;
-
-  // </context>
-  if ( !rcWrap(xmlTextWriterEndElement(writer_)) ) return;
-
-  // Now add phi dependent context for each ctp7
-  // map CTP7 0 1 ... 17 -> CTP7_Phi0 CTP7_Phi1 ... CTP7_Phi17
-  std::vector<unsigned int> ePhiBins  = caloParams.layer1ECalScalePhiBins();
-  std::vector<unsigned int> hPhiBins  = caloParams.layer1HCalScalePhiBins();
-  std::vector<unsigned int> hfPhiBins = caloParams.layer1HFScalePhiBins();
-  for ( uint32_t card=0; card<18; card++ ){
-    // check which processors to write
-    if (!(
-         ( ePhiBins.size()==36 && ePhiBins[card] )
-         || ( ePhiBins.size()==36 && ePhiBins[18+card] )
-         || ( hPhiBins.size()==36 && hPhiBins[card] )
-         || ( hPhiBins.size()==36 && hPhiBins[18+card] )
-         || ( hfPhiBins.size()==36 && hfPhiBins[card] )
-         || ( hfPhiBins.size()==36 && hfPhiBins[18+card] )
-       ))
-      continue;
+    if ( verbose ) {
+      edm::LogInfo("L1TCaloLayer1LUTWriter") << "Verified " << verification.checkedCells() << " cells of "
+                                             << verification.checkedTables() << " LUT tables";
+    }
+  }
 
-    // <context>
-    std::stringstream idStream;
-    idStream << "CTP7_Phi";
-    idStream << card;
-    if ( !rcWrap(xmlTextWriterStartElement(writer_, BAD_CAST "context")) ) return;
-    if ( !rcWrap(xmlTextWriterWriteAttribute(writer_, BAD_CAST "id", BAD_CAST idStream.str().c_str())) ) return;
-    
-    // checksum initialization  
-    MD5_CTX md5context;
-    MD5_Init(&md5context);
+  if ( !snapshotFileName.empty() ) {
+    calol1::LUTMetrics::Timer timer(&metrics, "write snapshot");
+    const std::string snapshotName = outputFileName(snapshotFileName, run);
+    std::string error;
+    if ( !calol1::LUTSnapshot::write(snapshotName, run, document.parameters(), shared ? shared->luts() : luts,
+                                     shared ? shared->extraChecksums() : extraChecksums, scale, 0, error) ) {
+      edm::LogError("L1TCaloLayer1LUTWriter") << "Failed to write " << snapshotName << ": " << error;
+      return;
+    }
+  }
 
-    // if override ECAL LUT
-    if ( ePhiBins.size()==36 && ePhiBins[card] ) {
-      if ( !writeECALLUT("ECALLUTMinus",ePhiBins[card],md5context) ) return;
+  bool written;
+  if ( splitOutput ) {
+    // Contexts written concurrently, each to its own file
+    calol1::LUTSplitWriter split(xmlName, compression, compressionLevel, xmlWriter == "direct");
+    calol1::LUTMetrics::Timer timer(&metrics, "write split files");
+    written = split.write(document, numberOfThreads);
+    if ( written && verbose ) {
+      edm::LogInfo("L1TCaloLayer1LUTWriter") << split.files().size() << " files indexed in " << calol1::LUTSplitWriter::indexFileName(xmlName);
     }
-    if ( ePhiBins.size()==36 && ePhiBins[18+card] ) {
-      if ( !writeECALLUT("ECALLUTPlus",ePhiBins[18+card],md5context) ) return;
+  }
+  else if ( xmlWriter == "direct" ) {
+    xmlOutputBufferPtr out = calol1::newXMLOutputBuffer(xmlName, compression, compressionLevel);
+    if ( out == NULL ) {
+      edm::LogError("L1TCaloLayer1LUTWriter") << "Error creating the xml output for " << xmlName
+                                              << " (compression '" << compression << "', should be none, gzip or zstd)";
+      return;
     }
-
-    // if override HCAL LUT
-    if ( hPhiBins.size()==36 && hPhiBins[card] ) {
-      if ( !writeHCALLUT("HCALLUTMinus",hPhiBins[card],md5context) ) return;
+    calol1::SWATCHXMLEmitter emitter(out);
+    if ( streamed ) {
+      written = ownDocument->writeXML(emitter, numberOfThreads, pipelineChunkRows, pipelineDepth);
     }
-    if ( hfPhiBins.size()==36 && hPhiBins[18+card] ) {
-      if ( !writeHCALLUT("HCALLUTPlus",hPhiBins[18+card],md5context) ) return;
+    else {
+      written = document.writeXML(emitter);
     }
-
-    // if override HF LUT
-    if ( hfPhiBins.size()==36 && hfPhiBins[card] ) {
-      if ( !writeHFLUT("HFLUTMinus",hfPhiBins[card],md5context) ) return;
+    // Flushes and closes the file
+    calol1::LUTMetrics::Timer timer(&metrics, "close XML");
+    if ( emitter.close() < 0 ) {
+      edm::LogError("L1TCaloLayer1LUTWriter") << "Error writing " << xmlName;
+      written = false;
     }
-    if ( hfPhiBins.size()==36 && hfPhiBins[18+card] ) {
-      if ( !writeHFLUT("HFLUTPlus",hfPhiBins[18+card],md5context) ) return;
+  }
+  else {
+    xmlTextWriterPtr writer = newWriter(xmlName);
+    if ( writer == NULL ) return;
+    if ( streamed ) {
+      // Format, hash and write overlap, bounded memory
+      written = ownDocument->writeXML(writer, numberOfThreads, pipelineChunkRows, pipelineDepth);
     }
-
-    // write checksum
-    unsigned char checksum[MD5_DIGEST_LENGTH];
-    MD5_Final(checksum, &md5context);
-    std::stringstream checksumString;
-    checksumString << std::hex << std::setfill('0');
-    for(size_t i=0; i<MD5_DIGEST_LENGTH; ++i) {
-      checksumString << std::setw(2) << static_cast<unsigned int>(checksum[i]);
+    else {
+      written = document.writeXML(writer);
     }
-    if ( !writeXMLParam("md5checksum", "string", checksumString.str()) ) return;
-
-    // </context>
-    if ( !rcWrap(xmlTextWriterEndElement(writer_)) ) return;
+    // Flushes and closes the file
+    calol1::LUTMetrics::Timer timer(&metrics, "close XML");
+    xmlFreeTextWriter(writer);
   }
-
-  // Closes all open elements recursively for us
-  if ( !rcWrap(xmlTextWriterEndDocument(writer_)) ) return;
-}
-
-bool
-L1TCaloLayer1LUTWriter::writeECALLUT(std::string id, uint32_t index, MD5_CTX& md5context) {
-
-  // <param id="ECALLUT" type="table">
-  if ( !rcWrap(xmlTextWriterStartElement(writer_, BAD_CAST "param")) ) return false;
-  if ( !rcWrap(xmlTextWriterWriteAttribute(writer_, BAD_CAST "id", BAD_CAST id.c_str())) ) return false;
-  if ( !rcWrap(xmlTextWriterWriteAttribute(writer_, BAD_CAST "type", BAD_CAST "table")) ) return false;
-
-  // <columns>
-  const char * ecal_columns{"Input, 01, 02, 03, 04, 05, 06, 07, 08, 09, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28"};
-  if ( !rcWrap(xmlTextWriterWriteElement(writer_, BAD_CAST "columns", BAD_CAST ecal_columns)) ) return false;
-
-  // <types>
-  const char * ecal_types{"uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint"};
-  if ( !rcWrap(xmlTextWriterWriteElement(writer_, BAD_CAST "types", BAD_CAST ecal_types)) ) return false;
-
-  // <rows>
-  if ( !rcWrap(xmlTextWriterStartElement(writer_, BAD_CAST "rows")) ) return false;
-
-  for(uint32_t fb = 0; fb < 2; fb++) {
-    for(uint32_t ecalInput = 0; ecalInput <= 0xFF; ecalInput++) {
-      std::vector<uint32_t> row;
-      uint32_t fullInput = (fb << 8) | ecalInput;
-      row.push_back(fullInput);
-      for(int iEta=1; iEta<=28; ++iEta) {
-        // 'Old' being 2015-2016 Layer1 firmware
-        // 0:9   Calibrated ET
-        // 10    'calibrated' FG bit
-        // 11    zero flag
-        // 12:14 log2(calibrated ET)
-        uint32_t oldValue = ecalLUT[index][iEta-1][fb][ecalInput];
-        // New value is the 2017+ Layer1 firmware where we have
-        // turned the whole thing into a set of LUTs.  There is some
-        // rearrangement of output bits becouse of this change.
-        // 0:8   9 bit Calibrated ET (for now limit to 8 bit max 0xff)
-        // 9:11  log2(calibrated ET)
-        // 12    zero flag
-        // 13:14 spare bits (undefined currently)
-        // 15    'calibrated' FG bit
-        uint32_t value{0};
-        value |= 0xff & oldValue;
-        value |= ((oldValue>>12) & 0b111)<<9;
-        value |= ((oldValue>>11) & 0b1)<<12;
-        value |= (0b00)<<13;
-        value |= ((oldValue>>10) & 0b1)<<15;
-        if ( firmwareVersion > 1 )
-          row.push_back(value);
-        else
-          row.push_back(oldValue);
-      }
-      MD5_Update(&md5context, &row[1], (row.size()-1)*sizeof(uint32_t));
-      if ( !writeSWATCHTableRow(row) ) return false;
+  if ( !written ) return;
+
+  if ( metrics.enabled() ) {
+    // The cache of shared LUTs counts for every consumer, reported by none
+    if ( !shared ) {
+      const calol1::LUTTableCache& cache = document.cache();
+      metrics.count("tables rendered", cache.renders());
+      metrics.count("table cache hits", cache.hits());
     }
+    struct stat info;
+    if ( !splitOutput && stat(xmlName.c_str(), &info) == 0 ) metrics.count("XML bytes", info.st_size);
   }
 
-  // </rows>
-  if ( !rcWrap(xmlTextWriterEndElement(writer_)) ) return false;
-  // </param>
-  if ( !rcWrap(xmlTextWriterEndElement(writer_)) ) return false;
+  if ( verbose && !streamed ) {
+    const calol1::LUTTableCache& cache = document.cache();
+    edm::LogInfo("L1TCaloLayer1LUTWriter") << "LUT table cache: " << cache.lookups() << " table params, "
+                                           << cache.renders() << " rendered (misses), "
+                                           << cache.hits() << " reused (hits); "
+                                           << cache.checksumLookups() << " context checksums, "
+                                           << cache.checksumRenders() << " computed";
+  }
+  if ( verbose ) {
+    edm::LogInfo("L1TCaloLayer1LUTWriter") << document.store().memoryReport();
+  }
 
-  return true;
-}
+  if ( !binaryFileName.empty() ) {
+    calol1::LUTMetrics::Timer timer(&metrics, "write binary");
+    if ( !document.writeBinary(outputFileName(binaryFileName, run)) ) return;
+  }
 
-bool
-L1TCaloLayer1LUTWriter::writeHCALLUT(std::string id, uint32_t index, MD5_CTX& md5context) {
-
-  // <param id="HCALLUT" type="table">
-  if ( !rcWrap(xmlTextWriterStartElement(writer_, BAD_CAST "param")) ) return false;
-  if ( !rcWrap(xmlTextWriterWriteAttribute(writer_, BAD_CAST "id", BAD_CAST id.c_str())) ) return false;
-  if ( !rcWrap(xmlTextWriterWriteAttribute(writer_, BAD_CAST "type", BAD_CAST "table")) ) return false;
-
-  // <columns>
-  const char * hcal_columns{"Input, 01, 02, 03, 04, 05, 06, 07, 08, 09, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28"};
-  if ( !rcWrap(xmlTextWriterWriteElement(writer_, BAD_CAST "columns", BAD_CAST hcal_columns)) ) return false;
-
-  // <types>
-  const char * hcal_types{"uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint"};
-  if ( !rcWrap(xmlTextWriterWriteElement(writer_, BAD_CAST "types", BAD_CAST hcal_types)) ) return false;
-
-  // <rows>
-  if ( !rcWrap(xmlTextWriterStartElement(writer_, BAD_CAST "rows")) ) return false;
-
-  for(uint32_t fb = 0; fb < 2; fb++) {
-    for(uint32_t hcalInput = 0; hcalInput <= 0xFF; hcalInput++) {
-      std::vector<uint32_t> row;
-      uint32_t fullInput = (fb << 8) | hcalInput;
-      row.push_back(fullInput);
-      for(int iEta=1; iEta<=28; ++iEta) {
-        // 'Old' being 2015-2016 Layer1 firmware
-        // 0:9   Calibrated ET
-        // 10    'calibrated' FG bit
-        // 11    zero flag
-        // 12:14 log2(calibrated ET)
-        uint32_t oldValue = hcalLUT[index][iEta-1][fb][hcalInput];
-        // New value is the 2017+ Layer1 firmware where we have
-        // turned the whole thing into a set of LUTs.  There is some
-        // rearrangement of output bits becouse of this change.
-        // 0:8   9 bit Calibrated ET (for now limit to 8 bit max 0xff)
-        // 9:11  log2(calibrated ET)
-        // 12    zero flag
-        // 13:14 spare bits (undefined currently)
-        // 15    'calibrated' FG bit
-        uint32_t value{0};
-        value |= 0xff & oldValue;
-        value |= ((oldValue>>12) & 0b111)<<9;
-        value |= ((oldValue>>11) & 0b1)<<12;
-        value |= (0b00)<<13;
-        value |= ((oldValue>>10) & 0b1)<<15;
-        if ( firmwareVersion > 1 )
-          row.push_back(value);
-        else
-          row.push_back(oldValue);
+  if ( !diffReference.empty() ) {
+    calol1::LUTMetrics::Timer timer(&metrics, "diff");
+    calol1::LUTTableSet reference, current;
+    if ( !reference.load(diffReference) ) {
+      edm::LogError("L1TCaloLayer1LUTWriter") << "Cannot diff against " << diffReference << ": " << reference.error();
+    }
+    else {
+      current.load(document);
+      calol1::LUTDiff diff(reference, current, numberOfThreads);
+      std::ostringstream summary;
+      diff.print(summary);
+      edm::LogInfo("L1TCaloLayer1LUTWriter") << "LUT changes since " << diffReference << ":\n" << summary.str();
+      const std::string diffName = outputFileName(diffFileName, run);
+      if ( !diffName.empty() && !diff.writeJSON(diffName) ) {
+        edm::LogError("L1TCaloLayer1LUTWriter") << "Failed to write " << diffName;
       }
-      MD5_Update(&md5context, &row[1], (row.size()-1)*sizeof(uint32_t));
-      if ( !writeSWATCHTableRow(row) ) return false;
     }
   }
 
-  // </rows>
-  if ( !rcWrap(xmlTextWriterEndElement(writer_)) ) return false;
-  // </param>
-  if ( !rcWrap(xmlTextWriterEndElement(writer_)) ) return false;
-
-  return true;
-}
-
-bool
-L1TCaloLayer1LUTWriter::writeHFLUT(std::string id, uint32_t index, MD5_CTX& md5context) {
-
-  // <param id="HFLUT" type="table">
-  if ( !rcWrap(xmlTextWriterStartElement(writer_, BAD_CAST "param")) ) return false;
-  if ( !rcWrap(xmlTextWriterWriteAttribute(writer_, BAD_CAST "id", BAD_CAST id.c_str())) ) return false;
-  if ( !rcWrap(xmlTextWriterWriteAttribute(writer_, BAD_CAST "type", BAD_CAST "table")) ) return false;
-
-  // <columns>
-  const char * hf_columns{"Input, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41"};
-  if ( !rcWrap(xmlTextWriterWriteElement(writer_, BAD_CAST "columns", BAD_CAST hf_columns)) ) return false;
-
-  // <types>
-  const char * hf_types{"uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint"};
-  if ( !rcWrap(xmlTextWriterWriteElement(writer_, BAD_CAST "types", BAD_CAST hf_types)) ) return false;
-
-  // <rows>
-  if ( !rcWrap(xmlTextWriterStartElement(writer_, BAD_CAST "rows")) ) return false;
-
-  for(uint32_t fb = 0; fb < 4; fb++) {
-    for(uint32_t hfInput = 0; hfInput <= 0xFF; hfInput++) {
-      std::vector<uint32_t> row;
-      uint32_t fullInput = (fb << 8) | hfInput;
-      row.push_back(fullInput);
-      for(int hfEta=0; hfEta<12; ++hfEta) {
-        uint32_t output = hfLUT[index][hfEta][hfInput];
-        // HF LUT in emulator does not currently handle
-        // feature bits, instead emulator passes them
-        // unaltered. So this is what we have hardware do
-        if ( firmwareVersion > 2 ) {
-          output |= (fb << 9);
-        }
-        else {
-          output |= (fb << 8);
-        }
-        row.push_back(output);
-      }
-      MD5_Update(&md5context, &row[1], (row.size()-1)*sizeof(uint32_t));
-      if ( !writeSWATCHTableRow(row) ) return false;
-    }
+  sidecar.checksums.push_back({"processors", document.processorsChecksum()});
+  for(const auto& context : document.cardContexts()) {
+    sidecar.checksums.push_back({context.id, document.checksum(context)});
+  }
+  if ( sweep ) {
+    calol1::LUTManifest::Entry& entry = manifest.add(splitOutput ? calol1::LUTSplitWriter::indexFileName(xmlName) : xmlName);
+    entry.checksums = sidecar.checksums;
+    manifest.addRun(run);
+    sweepPending = false;
   }
+  // Last, so that an interrupted job leaves no sidecar for incomplete files
+  if ( !sidecar.write(calol1::LUTSidecar::fileName(xmlName)) ) {
+    edm::LogWarning("L1TCaloLayer1LUTWriter") << "Failed to write " << calol1::LUTSidecar::fileName(xmlName)
+                                              << ", the LUTs will be regenerated next time";
+  }
+}
 
-  // </rows>
-  if ( !rcWrap(xmlTextWriterEndElement(writer_)) ) return false;
-  // </param>
-  if ( !rcWrap(xmlTextWriterEndElement(writer_)) ) return false;
+std::string
+L1TCaloLayer1LUTWriter::inputFingerprint(const calol1::LUTParameters& parameters, const calol1::LUTArrays& luts) const
+{
+  calol1::LUTFingerprint fingerprint;
+  fingerprint.add(parameters);
+  // The ECAL TPG scale and the HCAL transcoder, as L1TCaloLayer1FetchLUTs applied them
+  calol1::addFetchedLUTs(fingerprint, luts);
+  fingerprint.add(compression);
+  fingerprint.add(static_cast<int64_t>(compressionLevel));
+  for(auto algorithm : extraChecksums) fingerprint.add(calol1::checksumAlgorithmName(algorithm));
+  // Other files, switching modes has to regenerate
+  if ( splitOutput ) fingerprint.add(std::string("splitOutput"));
+  if ( deltaContexts ) fingerprint.add(std::string("deltaContexts"));
+  return fingerprint.digest();
+}
 
-  return true;
+std::string
+L1TCaloLayer1LUTWriter::inputFingerprint(const calol1::SharedLUTs& shared) const
+{
+  // The producer fingerprinted the CaloParams, the fetched tables and its options
+  calol1::LUTFingerprint fingerprint;
+  fingerprint.add(shared.fingerprint());
+  fingerprint.add(compression);
+  fingerprint.add(static_cast<int64_t>(compressionLevel));
+  if ( splitOutput ) fingerprint.add(std::string("splitOutput"));
+  return fingerprint.digest();
 }
 
 bool
-L1TCaloLayer1LUTWriter::writeHCALFBLUT(std::string id, uint32_t index, MD5_CTX& md5context) {
-
-  // <param id="HCALFBLUT" type="table">
-  if ( !rcWrap(xmlTextWriterStartElement(writer_, BAD_CAST "param")) ) return false;
-  if ( !rcWrap(xmlTextWriterWriteAttribute(writer_, BAD_CAST "id", BAD_CAST id.c_str())) ) return false;
-  if ( !rcWrap(xmlTextWriterWriteAttribute(writer_, BAD_CAST "type", BAD_CAST "table")) ) return false;
-
-  // <columns>
-  const char * hcalFB_columns{"01, 02, 03, 04, 05, 06, 07, 08, 09, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28"};
-  if ( !rcWrap(xmlTextWriterWriteElement(writer_, BAD_CAST "columns", BAD_CAST hcalFB_columns)) ) return false;
-
-  // <types>
-  const char * hcalFB_types{"uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64"};
-  if ( !rcWrap(xmlTextWriterWriteElement(writer_, BAD_CAST "types", BAD_CAST hcalFB_types)) ) return false;
-
-  // <rows>
-  if ( !rcWrap(xmlTextWriterStartElement(writer_, BAD_CAST "rows")) ) return false;
-
-  std::vector<uint64_t> row;
-  for(int iEta=0; iEta<28; ++iEta) {
-    uint64_t value = hcalFBLUT[iEta];
-    row.push_back(value);
+L1TCaloLayer1LUTWriter::upToDate(const std::string& xmlName, unsigned int run, calol1::LUTSidecar& sidecar) const
+{
+  calol1::LUTSidecar previous;
+  if ( !previous.read(calol1::LUTSidecar::fileName(xmlName)) ) return false;
+  if ( previous.fingerprint != sidecar.fingerprint ) return false;
+
+  // Every file this job would write has to exist
+  std::vector<std::string> outputs{splitOutput ? calol1::LUTSplitWriter::indexFileName(xmlName) : xmlName};
+  if ( !binaryFileName.empty() ) outputs.push_back(outputFileName(binaryFileName, run));
+  if ( !snapshotFileName.empty() ) outputs.push_back(outputFileName(snapshotFileName, run));
+  if ( saveHcalScaleFile ) {
+    outputs.push_back(outputFileName(hcalScaleFileName, run));
+    if ( !hcalScaleBinaryFileName.empty() ) outputs.push_back(outputFileName(hcalScaleBinaryFileName, run));
+  }
+  for(const auto& output : outputs) {
+    struct stat info;
+    if ( stat(output.c_str(), &info) != 0 ) return false;
   }
-  MD5_Update(&md5context, &row[1], (row.size()-1)*sizeof(uint64_t));
-  if ( !writeSWATCHTableRow(row) ) return false;
-
-  // </rows>
-  if ( !rcWrap(xmlTextWriterEndElement(writer_)) ) return false;
-  // </param>
-  if ( !rcWrap(xmlTextWriterEndElement(writer_)) ) return false;
 
+  sidecar.checksums = previous.checksums;
   return true;
 }
 
@@ -695,6 +672,20 @@ L1TCaloLayer1LUTWriter::writeHCALFBLUT(std::string id, uint32_t index, MD5_CTX&
   void 
   L1TCaloLayer1LUTWriter::endJob() 
   {
+    if ( reportMetrics ) {
+      edm::LogInfo("L1TCaloLayer1LUTWriter") << "LUT generation metrics:\n" << metrics.summary();
+    }
+    if ( !metricsFileName.empty() && !metrics.writeJSON(metricsFileName) ) {
+      edm::LogError("L1TCaloLayer1LUTWriter") << "Failed to write " << metricsFileName;
+    }
+    if ( sweep ) {
+      if ( !manifest.write(manifestFileName) ) {
+        edm::LogError("L1TCaloLayer1LUTWriter") << "Failed to write " << manifestFileName;
+      }
+      else if ( verbose ) {
+        edm::LogInfo("L1TCaloLayer1LUTWriter") << "Sweep wrote " << manifest.entries().size() << " LUT files, see " << manifestFileName;
+      }
+    }
   }
 
 // ------------ method called when starting to processes a run  ------------
@@ -732,10 +723,81 @@ L1TCaloLayer1LUTWriter::writeHCALFBLUT(std::string id, uint32_t index, MD5_CTX&
 // ------------ method fills 'descriptions' with the allowed parameters for the module  ------------
 void
 L1TCaloLayer1LUTWriter::fillDescriptions(edm::ConfigurationDescriptions& descriptions) {
-  //The following says we do not know what parameters are allowed so do no validation
-  // Please change this to state exactly what you do use, even if it is no parameters
   edm::ParameterSetDescription desc;
-  desc.setUnknown();
+  desc.addUntracked<bool>("verbose", false);
+  // Time of each stage (fetch, hcalScale, rendering, hashing, each table
+  // kind written, closing the file) and row/context/cache counters,
+  // summed over the job: logged at the end and/or written as JSON
+  desc.addUntracked<bool>("reportMetrics", false);
+  desc.addUntracked<std::string>("metricsFileName", "");
+  desc.add<std::string>("fileName", "luts.xml");
+  // none, gzip or zstd; the file is streamed through the compressor
+  desc.add<std::string>("compression", "none");
+  // 0 = default level of the chosen compression
+  desc.add<int>("compressionLevel", 0);
+  desc.add<bool>("useLSB", true);
+  desc.add<bool>("useCalib", true);
+  desc.add<bool>("useECALLUT", true);
+  desc.add<bool>("useHCALLUT", true);
+  desc.add<bool>("useHFLUT", true);
+  desc.add<bool>("useHCALFBLUT", true);
+  desc.add<int>("firmwareVersion", 1);
+  desc.add<bool>("saveHcalScaleFile", false);
+  desc.add<std::string>("hcalScaleFileName", "hcalScale.txt");
+  // Also write the HCAL scale as a binary float table (see HcalScaleTable.h) if not empty
+  desc.add<std::string>("hcalScaleBinaryFileName", "");
+  // 0 = use all threads available to the job, 1 = render the CTP7 contexts serially
+  desc.add<int>("numberOfThreads", 0);
+  // If not 0 the XML is streamed: tables are formatted in chunks of this
+  // many rows while earlier chunks are hashed and written, with at most
+  // pipelineDepth chunks in memory.  Same output either way.
+  desc.add<unsigned int>("pipelineChunkRows", 0);
+  desc.add<unsigned int>("pipelineDepth", 16);
+  // libxml2: xmlTextWriter; direct: SWATCHXMLEmitter, byte for byte the
+  // same file without the per element overhead of xmlTextWriter
+  desc.add<std::string>("xmlWriter", "libxml2");
+  // Instead of fileName write one file per context, luts_processors.xml,
+  // luts_CTP7_Phi0.xml, ... concurrently, indexed with their md5 in
+  // luts_index.json.  pipelineChunkRows does not apply.
+  desc.add<bool>("splitOutput", false);
+  // If not empty, the new LUTs are compared cell by cell with this earlier
+  // output (luts.xml, .xml.gz or .bin), see LUTDiff.h; the summary is
+  // logged and written as JSON to diffFileName if that is not empty
+  desc.add<std::string>("diffReference", "");
+  desc.add<std::string>("diffFileName", "");
+  // Check every cell of the tables about to be written (text and checksum
+  // payload) against the L1TCaloLayer1FetchLUTs arrays through the firmware
+  // bit layout, see LUTVerification.h; a mismatch fails the job
+  desc.add<bool>("verify", false);
+  // Also write the LUTs in the binary format of LUTBinaryFormat.h if not empty
+  desc.add<std::string>("binaryFileName", "");
+  // If not empty, also write what the files are made from (CaloParams values,
+  // FetchLUTs tables, decoded HCAL scale), see LUTSnapshot.h; calol1LUTFromSnapshot
+  // writes the same files from it without cmsRun
+  desc.add<std::string>("snapshotFileName", "");
+  // More digests of each context written after its md5checksum, as
+  // <name>checksum params: sha256 and/or xxh64
+  desc.add<std::vector<std::string>>("extraChecksums", {});
+  // Write the tables of the CTP7 contexts as type="table:delta", only the
+  // rows that differ from the processors table; checksums are unchanged,
+  // LUTXMLLoader reads them back whole, SWATCH does not
+  desc.add<bool>("deltaContexts", false);
+  // Write LUTs only when the CaloParams, CaloTPGRecord or ECAL TPG scale IOV
+  // changes (with lutProduct: when the producer makes a new set), one set
+  // of files per IOV named after its first run, indexed in manifestFileName
+  desc.add<bool>("sweep", false);
+  // Outputs are only regenerated when the inputs fingerprinted in
+  // <fileName>.fingerprint changed, unless forced (or verify or
+  // diffReference is set)
+  desc.add<bool>("force", false);
+  desc.add<std::string>("manifestFileName", "lutsManifest.json");
+  // Run product of L1TCaloLayer1LUTProducer: if set the LUTs are taken from
+  // it, already rendered and checksummed, with the decoded HCAL scale if
+  // the producer has decodeHcalScale, instead of being fetched here; no
+  // EventSetup record is consumed or watched.
+  // The LUT options, firmwareVersion, extraChecksums and deltaContexts are then those of
+  // the producer; pipelineChunkRows does not apply.
+  desc.add<edm::InputTag>("lutProduct", edm::InputTag(""));
   descriptions.addDefault(desc);
 }
 
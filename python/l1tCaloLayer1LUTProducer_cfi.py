@@ -0,0 +1,16 @@
+import FWCore.ParameterSet.Config as cms
+
+l1tCaloLayer1LUTProducer = cms.EDProducer('L1TCaloLayer1LUTProducer',
+    verbose = cms.untracked.bool(False),
+    useLSB = cms.bool(True),
+    useCalib = cms.bool(True),
+    useECALLUT = cms.bool(True),
+    useHCALLUT = cms.bool(True),
+    useHFLUT = cms.bool(True),
+    useHCALFBLUT = cms.bool(True),
+    firmwareVersion = cms.int32(1),
+    numberOfThreads = cms.int32(0),
+    extraChecksums = cms.vstring(),
+    deltaContexts = cms.bool(False),
+    decodeHcalScale = cms.bool(False),
+)
@@ -2,7 +2,11 @@ import FWCore.ParameterSet.Config as cms
 
 l1tCaloLayer1LUTWriter = cms.EDAnalyzer('L1TCaloLayer1LUTWriter',
     verbose = cms.untracked.bool(False),
+    reportMetrics = cms.untracked.bool(False),
+    metricsFileName = cms.untracked.string(""),
     fileName = cms.string("luts.xml"),
+    compression = cms.string("none"),
+    compressionLevel = cms.int32(0),
     useLSB = cms.bool(True),
     useCalib = cms.bool(True),
     useECALLUT = cms.bool(True),
@@ -11,4 +15,22 @@ l1tCaloLayer1LUTWriter = cms.EDAnalyzer('L1TCaloLayer1LUTWriter',
     useHCALFBLUT = cms.bool(True),
     firmwareVersion = cms.int32(1),
     saveHcalScaleFile = cms.bool(False),
+    hcalScaleFileName = cms.string("hcalScale.txt"),
+    hcalScaleBinaryFileName = cms.string(""),
+    numberOfThreads = cms.int32(0),
+    pipelineChunkRows = cms.uint32(0),
+    pipelineDepth = cms.uint32(16),
+    xmlWriter = cms.string("libxml2"),
+    splitOutput = cms.bool(False),
+    diffReference = cms.string(""),
+    diffFileName = cms.string(""),
+    verify = cms.bool(False),
+    binaryFileName = cms.string(""),
+    snapshotFileName = cms.string(""),
+    extraChecksums = cms.vstring(),
+    deltaContexts = cms.bool(False),
+    sweep = cms.bool(False),
+    force = cms.bool(False),
+    manifestFileName = cms.string("lutsManifest.json"),
+    lutProduct = cms.InputTag(""),
 )
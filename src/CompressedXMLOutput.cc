@@ -0,0 +1,103 @@
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/CompressedXMLOutput.h"
+
+#include <cstdio>
+#include <vector>
+
+#include <zstd.h>
+
+namespace {
+
+  struct ZstdSink {
+    FILE * file;
+    ZSTD_CCtx * cctx;
+    std::vector<char> out;
+  };
+
+  bool compress(ZstdSink * sink, ZSTD_inBuffer& in, ZSTD_EndDirective mode)
+  {
+    // With ZSTD_e_end keep going until the frame is complete (rc == 0)
+    size_t remaining;
+    do {
+      ZSTD_outBuffer out{sink->out.data(), sink->out.size(), 0};
+      remaining = ZSTD_compressStream2(sink->cctx, &out, &in, mode);
+      if ( ZSTD_isError(remaining) ) return false;
+      if ( std::fwrite(sink->out.data(), 1, out.pos, sink->file) != out.pos ) return false;
+    } while ( (mode == ZSTD_e_end) ? remaining != 0 : in.pos < in.size );
+    return true;
+  }
+
+  int zstdWrite(void * context, const char * buffer, int len)
+  {
+    ZstdSink * sink = static_cast<ZstdSink *>(context);
+    ZSTD_inBuffer in{buffer, static_cast<size_t>(len), 0};
+    return compress(sink, in, ZSTD_e_continue) ? len : -1;
+  }
+
+  int zstdClose(void * context)
+  {
+    ZstdSink * sink = static_cast<ZstdSink *>(context);
+    ZSTD_inBuffer in{nullptr, 0, 0};
+    bool ok = compress(sink, in, ZSTD_e_end);
+    ok = (std::fclose(sink->file) == 0) && ok;
+    ZSTD_freeCCtx(sink->cctx);
+    delete sink;
+    return ok ? 0 : -1;
+  }
+
+  xmlOutputBufferPtr zstdOutputBuffer(const std::string& fileName, int level)
+  {
+    FILE * file = std::fopen(fileName.c_str(), "wb");
+    if ( file == nullptr ) return nullptr;
+    ZstdSink * sink = new ZstdSink{file, ZSTD_createCCtx(), std::vector<char>(ZSTD_CStreamOutSize())};
+    if ( sink->cctx == nullptr || ZSTD_isError(ZSTD_CCtx_setParameter(sink->cctx, ZSTD_c_compressionLevel, level)) ) {
+      zstdClose(sink);
+      return nullptr;
+    }
+    xmlOutputBufferPtr buffer = xmlOutputBufferCreateIO(zstdWrite, zstdClose, sink, nullptr);
+    if ( buffer == nullptr ) zstdClose(sink);
+    return buffer;
+  }
+
+}
+
+namespace calol1 {
+
+  xmlTextWriterPtr
+  newXMLTextWriter(const std::string& fileName, const std::string& compression, int level)
+  {
+    if ( compression == "none" ) {
+      return xmlNewTextWriterFilename(fileName.c_str(), 0);
+    }
+    if ( compression == "gzip" ) {
+      // zlib levels are 1-9, 6 is its usual default
+      return xmlNewTextWriterFilename(fileName.c_str(), (level > 0) ? level : 6);
+    }
+    if ( compression == "zstd" ) {
+      xmlOutputBufferPtr buffer = newXMLOutputBuffer(fileName, compression, level);
+      if ( buffer == nullptr ) return nullptr;
+      // The writer owns the buffer from here on
+      xmlTextWriterPtr writer = xmlNewTextWriter(buffer);
+      if ( writer == nullptr ) xmlOutputBufferClose(buffer);
+      return writer;
+    }
+    return nullptr;
+  }
+
+  xmlOutputBufferPtr
+  newXMLOutputBuffer(const std::string& fileName, const std::string& compression, int level)
+  {
+    // What xmlNewTextWriterFilename opens
+    if ( compression == "none" ) {
+      return xmlOutputBufferCreateFilename(fileName.c_str(), nullptr, 0);
+    }
+    if ( compression == "gzip" ) {
+      return xmlOutputBufferCreateFilename(fileName.c_str(), nullptr, (level > 0) ? level : 6);
+    }
+    if ( compression == "zstd" ) {
+      // 0 is the zstd default level
+      return zstdOutputBuffer(fileName, level);
+    }
+    return nullptr;
+  }
+
+}
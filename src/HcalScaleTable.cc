@@ -0,0 +1,104 @@
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/HcalScaleTable.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTBinaryFormat.h"
+
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include "tbb/parallel_for.h"
+#include "tbb/task_arena.h"
+
+namespace {
+
+  template<typename F>
+  void forEachRing(int numberOfThreads, F&& body)
+  {
+    if ( numberOfThreads == 1 ) {
+      for(uint32_t ring=0; ring<calol1::hcalscale::nEta; ++ring) body(ring);
+    }
+    else {
+      tbb::task_arena arena(numberOfThreads > 0 ? numberOfThreads : static_cast<int>(tbb::task_arena::automatic));
+      arena.execute([&]() { tbb::parallel_for(uint32_t(0), calol1::hcalscale::nEta, body); });
+    }
+  }
+
+  // Same text as std::fixed << std::setprecision(1) << std::setw(7)
+  void appendValue(std::string& out, double value)
+  {
+    char tmp[32];
+    auto result = std::to_chars(tmp, tmp+sizeof(tmp), value, std::chars_format::fixed, 1);
+    for(ptrdiff_t n = result.ptr-tmp; n < 7; ++n) out.push_back(' ');
+    out.append(tmp, result.ptr-tmp);
+  }
+
+}
+
+namespace calol1 {
+
+  using namespace hcalscale;
+
+  void
+  HcalScaleTable::fill(const TowerDecoder& decoder, int numberOfThreads)
+  {
+    values_.assign(size_t(nEta)*nPhi*nEt, 0.);
+    forEachRing(numberOfThreads, [&](uint32_t ring) {
+      const int iEta = ringEta(ring);
+      for(uint32_t iPhi=1; iPhi<=nPhi; ++iPhi) {
+        decoder(iEta, iPhi, &values_[towerIndex(iEta, iPhi)*nEt]);
+      }
+    });
+  }
+
+  bool
+  HcalScaleTable::writeText(const std::string& fileName, int numberOfThreads) const
+  {
+    if ( empty() ) return false;
+
+    std::vector<std::string> rings(nEta);
+    forEachRing(numberOfThreads, [&](uint32_t ring) {
+      const int iEta = ringEta(ring);
+      std::string& out = rings[ring];
+      out.reserve(nPhi*(14+7*nEt+1));
+      for(uint32_t iPhi=1; iPhi<=nPhi; ++iPhi) {
+        char head[32];
+        int n = std::snprintf(head, sizeof(head), "eta %3d phi %2u", iEta, iPhi);
+        out.append(head, n);
+        const double * values = &values_[towerIndex(iEta, iPhi)*nEt];
+        for(uint32_t et=0; et<nEt; ++et) appendValue(out, values[et]);
+        out.push_back('\n');
+      }
+    });
+
+    std::ofstream file(fileName, std::ios::trunc);
+    for(const auto& ring : rings) file.write(ring.data(), ring.size());
+    file.close();
+    return static_cast<bool>(file);
+  }
+
+  bool
+  HcalScaleTable::writeBinary(const std::string& fileName) const
+  {
+    if ( empty() ) return false;
+
+    std::vector<unsigned char> out;
+    out.reserve(8 + 4*4 + values_.size()*sizeof(float));
+    out.insert(out.end(), magic, magic+sizeof(magic));
+    lutfile::appendLE(out, formatVersion);
+    lutfile::appendLE(out, nEta);
+    lutfile::appendLE(out, nPhi);
+    lutfile::appendLE(out, nEt);
+    for(double value : values_) {
+      float f = value;
+      uint32_t bits;
+      std::memcpy(&bits, &f, sizeof(bits));
+      lutfile::appendLE(out, bits);
+    }
+
+    std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(out.data()), out.size());
+    file.close();
+    return static_cast<bool>(file);
+  }
+
+}
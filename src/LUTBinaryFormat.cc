@@ -0,0 +1,399 @@
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTBinaryFormat.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTPacking.h"
+
+#include <fstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace calol1 {
+
+  using namespace lutfile;
+
+  namespace lutfile {
+
+    int
+    contextIndex(const std::string& name)
+    {
+      if ( name == "processors" ) return processorsContext;
+      const std::string prefix{"CTP7_Phi"};
+      if ( name.compare(0, prefix.size(), prefix) != 0 || name.size() == prefix.size() ) return -1;
+      size_t end = 0;
+      unsigned long card = 0;
+      try {
+        card = std::stoul(name.substr(prefix.size()), &end);
+      }
+      catch ( std::exception& ) {
+        return -1;
+      }
+      if ( end != name.size()-prefix.size() || card >= nContexts-1 ) return -1;
+      return cardContext(card);
+    }
+
+    std::string
+    contextName(uint32_t context)
+    {
+      if ( context == processorsContext ) return "processors";
+      return "CTP7_Phi" + std::to_string(context-1);
+    }
+
+  }
+
+  namespace {
+    // Table sections are types 1..3
+    constexpr uint32_t nTableTypes = 3;
+    inline size_t tableSlot(SectionType type, uint32_t context, Side side) {
+      return ((static_cast<uint32_t>(type)-1)*nContexts + context)*2 + static_cast<uint32_t>(side);
+    }
+  }
+
+  void
+  LUTBinaryWriter::addSection(SectionType type, uint32_t context, uint32_t id, uint32_t elementSize, std::vector<unsigned char>&& data)
+  {
+    SectionEntry entry;
+    entry.type = static_cast<uint32_t>(type);
+    entry.context = context;
+    entry.id = id;
+    entry.elementSize = elementSize;
+    // offsets are filled in write()
+    entry.offset = 0;
+    entry.size = data.size();
+    sections_.push_back(entry);
+    data_.push_back(std::move(data));
+  }
+
+  bool
+  LUTBinaryWriter::addCaloLUT(SectionType type, uint32_t context, Side side, const CaloLUT& lut)
+  {
+    std::vector<uint16_t> words(caloPackedSize);
+    if ( !packCaloLUT(lut, firmwareVersion_, words.data()) ) {
+      error_ = "LUT word does not fit in 16 bits";
+      return false;
+    }
+
+    addCaloWords(type, context, side, words.data());
+    return true;
+  }
+
+  void
+  LUTBinaryWriter::addCaloWords(SectionType type, uint32_t context, Side side, const uint16_t * words)
+  {
+    std::vector<unsigned char> data;
+    data.reserve(caloLUTEntries*sizeof(uint16_t));
+    for(size_t i=0; i<caloLUTEntries; ++i) appendLE(data, words[i]);
+    addSection(type, context, static_cast<uint32_t>(side), sizeof(uint16_t), std::move(data));
+  }
+
+  bool
+  LUTBinaryWriter::addHFLUT(uint32_t context, Side side, const HFLUT& lut)
+  {
+    std::vector<uint16_t> words(hfPackedSize);
+    if ( !packHFLUT(lut, firmwareVersion_, words.data()) ) {
+      error_ = "HF LUT word does not fit in 16 bits";
+      return false;
+    }
+
+    addHFWords(context, side, words.data());
+    return true;
+  }
+
+  void
+  LUTBinaryWriter::addHFWords(uint32_t context, Side side, const uint16_t * words)
+  {
+    std::vector<unsigned char> data;
+    data.reserve(hfLUTEntries*sizeof(uint16_t));
+    for(size_t i=0; i<hfLUTEntries; ++i) appendLE(data, words[i]);
+    addSection(SectionType::HFLUT, context, static_cast<uint32_t>(side), sizeof(uint16_t), std::move(data));
+  }
+
+  void
+  LUTBinaryWriter::addHCALFBLUT(uint32_t context, Side side, const std::vector<unsigned long long int>& lut)
+  {
+    std::vector<unsigned char> data;
+    for(int iEta=0; iEta<28; ++iEta) {
+      appendLE(data, static_cast<uint64_t>(lut[iEta]));
+    }
+    addSection(SectionType::HCALFBLUT, context, static_cast<uint32_t>(side), sizeof(uint64_t), std::move(data));
+  }
+
+  void
+  LUTBinaryWriter::addSecondStageLUT(uint32_t context, const std::vector<uint32_t>& lut)
+  {
+    std::vector<unsigned char> data;
+    for(auto value : lut) appendLE(data, value);
+    addSection(SectionType::SecondStageLUT, context, 0, sizeof(uint32_t), std::move(data));
+  }
+
+  void
+  LUTBinaryWriter::addVector(uint32_t context, VectorId id, const std::vector<int>& vect)
+  {
+    std::vector<unsigned char> data;
+    for(auto value : vect) appendLE(data, static_cast<uint32_t>(value));
+    addSection(SectionType::Vector, context, static_cast<uint32_t>(id), sizeof(uint32_t), std::move(data));
+  }
+
+  void
+  LUTBinaryWriter::addVector(uint32_t context, VectorId id, const std::vector<unsigned int>& vect)
+  {
+    std::vector<unsigned char> data;
+    for(auto value : vect) appendLE(data, static_cast<uint32_t>(value));
+    addSection(SectionType::Vector, context, static_cast<uint32_t>(id), sizeof(uint32_t), std::move(data));
+  }
+
+  void
+  LUTBinaryWriter::addVector(uint32_t context, VectorId id, const std::vector<double>& vect)
+  {
+    std::vector<unsigned char> data;
+    for(auto value : vect) appendLE(data, value);
+    addSection(SectionType::Vector, context, static_cast<uint32_t>(id), sizeof(double), std::move(data));
+  }
+
+  void
+  LUTBinaryWriter::addVector(uint32_t context, VectorId id, const std::vector<unsigned long long int>& vect)
+  {
+    std::vector<unsigned char> data;
+    for(auto value : vect) appendLE(data, static_cast<uint64_t>(value));
+    addSection(SectionType::Vector, context, static_cast<uint32_t>(id), sizeof(uint64_t), std::move(data));
+  }
+
+  void
+  LUTBinaryWriter::addChecksum(uint32_t context, const std::string& md5checksum)
+  {
+    std::vector<unsigned char> data(md5checksum.begin(), md5checksum.end());
+    addSection(SectionType::Checksum, context, 0, 1, std::move(data));
+  }
+
+  bool
+  LUTBinaryWriter::write(const std::string& fileName)
+  {
+    if ( !error_.empty() ) return false;
+
+    auto aligned = [](uint64_t offset) { return (offset + sectionAlignment - 1) / sectionAlignment * sectionAlignment; };
+
+    const uint64_t indexOffset = headerSize;
+    uint64_t offset = aligned(indexOffset + sections_.size()*sectionEntrySize);
+    for(auto& entry : sections_) {
+      entry.offset = offset;
+      offset = aligned(offset + entry.size);
+    }
+
+    std::vector<unsigned char> out;
+    out.reserve(offset);
+    out.insert(out.end(), magic, magic+sizeof(magic));
+    appendLE(out, lutfile::formatVersion);
+    appendLE(out, static_cast<uint32_t>(firmwareVersion_));
+    appendLE(out, static_cast<uint32_t>(sections_.size()));
+    appendLE(out, static_cast<uint32_t>(0));
+    appendLE(out, indexOffset);
+    for(const auto& entry : sections_) {
+      appendLE(out, entry.type);
+      appendLE(out, entry.context);
+      appendLE(out, entry.id);
+      appendLE(out, entry.elementSize);
+      appendLE(out, entry.offset);
+      appendLE(out, entry.size);
+    }
+    for(size_t i=0; i<sections_.size(); ++i) {
+      out.resize(sections_[i].offset, 0);
+      out.insert(out.end(), data_[i].begin(), data_[i].end());
+    }
+    out.resize(offset, 0);
+
+    std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(out.data()), out.size());
+    file.close();
+    if ( !file ) {
+      error_ = "Could not write " + fileName;
+      return false;
+    }
+    return true;
+  }
+
+  bool
+  LUTBinaryReader::open(const std::string& fileName)
+  {
+    close();
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if ( fd < 0 ) {
+      error_ = "Could not open " + fileName;
+      return false;
+    }
+    struct stat st;
+    if ( fstat(fd, &st) != 0 || st.st_size == 0 ) {
+      ::close(fd);
+      error_ = "Could not read " + fileName;
+      return false;
+    }
+    void * mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+    if ( mapped == MAP_FAILED ) {
+      error_ = "Could not map " + fileName;
+      return false;
+    }
+    buffer_ = static_cast<const unsigned char *>(mapped);
+    size_ = st.st_size;
+
+    if ( size_ < headerSize || std::memcmp(buffer_, magic, sizeof(magic)) != 0 ) {
+      error_ = fileName + " is not a Layer1 binary LUT file";
+      close();
+      return false;
+    }
+    formatVersion_ = readLE<uint32_t>(buffer_+8);
+    if ( formatVersion_ != lutfile::formatVersion ) {
+      error_ = "Unsupported binary LUT format version " + std::to_string(formatVersion_);
+      close();
+      return false;
+    }
+    firmwareVersion_ = static_cast<int>(readLE<uint32_t>(buffer_+12));
+    uint32_t nSections = readLE<uint32_t>(buffer_+16);
+    uint64_t indexOffset = readLE<uint64_t>(buffer_+24);
+    // Compared so that offsets near 2^64 from a corrupt file cannot wrap around
+    if ( indexOffset > size_ || uint64_t(nSections)*sectionEntrySize > size_ - indexOffset ) {
+      error_ = "Truncated section index";
+      close();
+      return false;
+    }
+
+    sections_.reserve(nSections);
+    tables_.assign(nTableTypes*nContexts*2, nullptr);
+    for(uint32_t i=0; i<nSections; ++i) {
+      const unsigned char * p = buffer_ + indexOffset + i*sectionEntrySize;
+      SectionEntry entry;
+      entry.type = readLE<uint32_t>(p);
+      entry.context = readLE<uint32_t>(p+4);
+      entry.id = readLE<uint32_t>(p+8);
+      entry.elementSize = readLE<uint32_t>(p+12);
+      entry.offset = readLE<uint64_t>(p+16);
+      entry.size = readLE<uint64_t>(p+24);
+      if ( entry.offset > size_ || entry.size > size_ - entry.offset || entry.elementSize == 0 || entry.size % entry.elementSize != 0 ) {
+        error_ = "Corrupt section " + std::to_string(i);
+        close();
+        return false;
+      }
+      sections_.push_back(entry);
+
+      const SectionType type = static_cast<SectionType>(entry.type);
+      if ( (type == SectionType::ECALLUT || type == SectionType::HCALLUT || type == SectionType::HFLUT)
+           && entry.context < nContexts && entry.id < 2 ) {
+        const uint64_t expected = (type == SectionType::HFLUT ? hfLUTEntries : caloLUTEntries)*sizeof(uint16_t);
+        if ( entry.size != expected ) {
+          error_ = "Table section " + std::to_string(i) + " has the wrong size";
+          close();
+          return false;
+        }
+        tables_[tableSlot(type, entry.context, static_cast<Side>(entry.id))] = buffer_ + entry.offset;
+      }
+    }
+    return true;
+  }
+
+  void
+  LUTBinaryReader::close()
+  {
+    if ( buffer_ != nullptr ) {
+      munmap(const_cast<unsigned char *>(buffer_), size_);
+    }
+    buffer_ = nullptr;
+    size_ = 0;
+    sections_.clear();
+    tables_.clear();
+  }
+
+  const unsigned char *
+  LUTBinaryReader::tableData(SectionType type, uint32_t context, Side side) const
+  {
+    if ( context >= nContexts || static_cast<uint32_t>(side) > 1 ) {
+      throw std::out_of_range("No such LUT context or side");
+    }
+    const unsigned char * table = tables_[tableSlot(type, context, side)];
+    if ( table == nullptr ) {
+      table = tables_[tableSlot(type, processorsContext, side)];
+    }
+    if ( table == nullptr ) {
+      throw std::out_of_range("LUT missing from file");
+    }
+    return table;
+  }
+
+  uint16_t
+  LUTBinaryReader::ecal(uint32_t context, Side side, uint32_t iEta, uint32_t fb, uint32_t input) const
+  {
+    if ( iEta < 1 || iEta > 28 || fb > 1 || input > 0xFF ) throw std::out_of_range("ECAL LUT index");
+    const unsigned char * table = tableData(SectionType::ECALLUT, context, side);
+    return readLE<uint16_t>(table + 2*(((fb << 8) | input)*28 + iEta-1));
+  }
+
+  uint16_t
+  LUTBinaryReader::hcal(uint32_t context, Side side, uint32_t iEta, uint32_t fb, uint32_t input) const
+  {
+    if ( iEta < 1 || iEta > 28 || fb > 1 || input > 0xFF ) throw std::out_of_range("HCAL LUT index");
+    const unsigned char * table = tableData(SectionType::HCALLUT, context, side);
+    return readLE<uint16_t>(table + 2*(((fb << 8) | input)*28 + iEta-1));
+  }
+
+  uint16_t
+  LUTBinaryReader::hf(uint32_t context, Side side, uint32_t iEta, uint32_t fb, uint32_t input) const
+  {
+    if ( iEta < 30 || iEta > 41 || fb > 3 || input > 0xFF ) throw std::out_of_range("HF LUT index");
+    const unsigned char * table = tableData(SectionType::HFLUT, context, side);
+    return readLE<uint16_t>(table + 2*(((fb << 8) | input)*12 + iEta-30));
+  }
+
+  const SectionEntry *
+  LUTBinaryReader::find(SectionType type, uint32_t context, uint32_t id) const
+  {
+    for(const auto& entry : sections_) {
+      if ( entry.type == static_cast<uint32_t>(type) && entry.context == context && entry.id == id ) return &entry;
+    }
+    return nullptr;
+  }
+
+  std::vector<uint16_t>
+  LUTBinaryReader::table(const SectionEntry& section) const
+  {
+    std::vector<uint16_t> out(section.size / sizeof(uint16_t));
+    const unsigned char * p = data(section);
+    for(size_t i=0; i<out.size(); ++i) out[i] = readLE<uint16_t>(p + 2*i);
+    return out;
+  }
+
+  std::vector<unsigned long long int>
+  LUTBinaryReader::uint64Vector(const SectionEntry& section) const
+  {
+    std::vector<unsigned long long int> out(section.size / sizeof(uint64_t));
+    const unsigned char * p = data(section);
+    for(size_t i=0; i<out.size(); ++i) out[i] = readLE<uint64_t>(p + 8*i);
+    return out;
+  }
+
+  std::vector<double>
+  LUTBinaryReader::doubleVector(const SectionEntry& section) const
+  {
+    std::vector<double> out(section.size / sizeof(double));
+    const unsigned char * p = data(section);
+    for(size_t i=0; i<out.size(); ++i) out[i] = readDoubleLE(p + 8*i);
+    return out;
+  }
+
+  std::vector<uint32_t>
+  LUTBinaryReader::uint32Vector(const SectionEntry& section) const
+  {
+    std::vector<uint32_t> out(section.size / sizeof(uint32_t));
+    const unsigned char * p = data(section);
+    for(size_t i=0; i<out.size(); ++i) out[i] = readLE<uint32_t>(p + 4*i);
+    return out;
+  }
+
+  std::string
+  LUTBinaryReader::checksum(uint32_t context) const
+  {
+    const SectionEntry * section = find(SectionType::Checksum, context);
+    if ( section == nullptr ) return "";
+    return std::string(reinterpret_cast<const char *>(data(*section)), section->size);
+  }
+
+}
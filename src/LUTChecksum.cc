@@ -0,0 +1,198 @@
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTChecksum.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include <openssl/evp.h>
+
+namespace {
+
+  // XXH64 primes
+  constexpr uint64_t prime1 = 11400714785074694791ull;
+  constexpr uint64_t prime2 = 14029467366897019727ull;
+  constexpr uint64_t prime3 = 1609587929392839161ull;
+  constexpr uint64_t prime4 = 9650029242287828579ull;
+  constexpr uint64_t prime5 = 2870177450012600261ull;
+
+  inline uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64-r)); }
+
+  // Little endian, as XXH64 defines its input
+  inline uint64_t read64(const unsigned char * p)
+  {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+#else
+    uint64_t value{0};
+    for(int i=7; i>=0; --i) value = (value << 8) | p[i];
+    return value;
+#endif
+  }
+
+  inline uint32_t read32(const unsigned char * p)
+  {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+  }
+
+  inline uint64_t round(uint64_t acc, uint64_t input)
+  {
+    acc += input * prime2;
+    return rotl(acc, 31) * prime1;
+  }
+
+  inline uint64_t mergeRound(uint64_t acc, uint64_t value)
+  {
+    acc ^= round(0, value);
+    return acc * prime1 + prime4;
+  }
+
+  std::string hex(const unsigned char * digest, size_t size)
+  {
+    static constexpr char digits[] = "0123456789abcdef";
+    std::string text;
+    text.reserve(2*size);
+    for(size_t i=0; i<size; ++i) {
+      text.push_back(digits[digest[i] >> 4]);
+      text.push_back(digits[digest[i] & 0xf]);
+    }
+    return text;
+  }
+
+}
+
+namespace calol1 {
+
+  const char *
+  checksumAlgorithmName(ChecksumAlgorithm algorithm)
+  {
+    switch ( algorithm ) {
+      case ChecksumAlgorithm::SHA256: return "sha256";
+      case ChecksumAlgorithm::XXH64: return "xxh64";
+      default: return "md5";
+    }
+  }
+
+  bool
+  checksumAlgorithmFromName(const std::string& name, ChecksumAlgorithm& algorithm)
+  {
+    for(ChecksumAlgorithm candidate : checksumAlgorithms()) {
+      if ( name == checksumAlgorithmName(candidate) ) {
+        algorithm = candidate;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  const std::vector<ChecksumAlgorithm>&
+  checksumAlgorithms()
+  {
+    static const std::vector<ChecksumAlgorithm> all{ChecksumAlgorithm::MD5, ChecksumAlgorithm::SHA256, ChecksumAlgorithm::XXH64};
+    return all;
+  }
+
+  LUTChecksum::LUTChecksum(ChecksumAlgorithm algorithm) :
+    algorithm_(algorithm)
+  {
+    if ( algorithm_ == ChecksumAlgorithm::XXH64 ) {
+      xxh_.v[0] = prime1 + prime2;
+      xxh_.v[1] = prime2;
+      xxh_.v[2] = 0;
+      xxh_.v[3] = -prime1;
+      return;
+    }
+    evp_ = EVP_MD_CTX_new();
+    if ( evp_ == nullptr || EVP_DigestInit_ex(evp_, algorithm_ == ChecksumAlgorithm::SHA256 ? EVP_sha256() : EVP_md5(), nullptr) != 1 ) {
+      EVP_MD_CTX_free(evp_);
+      throw std::runtime_error(std::string("Could not initialize the ") + checksumAlgorithmName(algorithm_) + " digest");
+    }
+  }
+
+  LUTChecksum::~LUTChecksum()
+  {
+    EVP_MD_CTX_free(evp_);
+  }
+
+  void
+  LUTChecksum::update(const void * data, size_t size)
+  {
+    if ( evp_ != nullptr ) {
+      EVP_DigestUpdate(evp_, data, size);
+      return;
+    }
+
+    const unsigned char * p = static_cast<const unsigned char *>(data);
+    const unsigned char * end = p + size;
+    xxh_.total += size;
+    if ( xxh_.buffered + size < 32 ) {
+      std::memcpy(xxh_.buffer + xxh_.buffered, p, size);
+      xxh_.buffered += size;
+      return;
+    }
+    if ( xxh_.buffered > 0 ) {
+      const size_t fill = 32 - xxh_.buffered;
+      std::memcpy(xxh_.buffer + xxh_.buffered, p, fill);
+      for(int lane=0; lane<4; ++lane) xxh_.v[lane] = round(xxh_.v[lane], read64(xxh_.buffer + 8*lane));
+      p += fill;
+      xxh_.buffered = 0;
+    }
+    uint64_t v0 = xxh_.v[0], v1 = xxh_.v[1], v2 = xxh_.v[2], v3 = xxh_.v[3];
+    for(; p+32 <= end; p+=32) {
+      v0 = round(v0, read64(p));
+      v1 = round(v1, read64(p+8));
+      v2 = round(v2, read64(p+16));
+      v3 = round(v3, read64(p+24));
+    }
+    xxh_.v[0] = v0; xxh_.v[1] = v1; xxh_.v[2] = v2; xxh_.v[3] = v3;
+    xxh_.buffered = end - p;
+    std::memcpy(xxh_.buffer, p, xxh_.buffered);
+  }
+
+  std::string
+  LUTChecksum::digest()
+  {
+    if ( evp_ != nullptr ) {
+      unsigned char digest[EVP_MAX_MD_SIZE];
+      unsigned int size{0};
+      EVP_DigestFinal_ex(evp_, digest, &size);
+      return hex(digest, size);
+    }
+
+    uint64_t h;
+    if ( xxh_.total >= 32 ) {
+      h = rotl(xxh_.v[0], 1) + rotl(xxh_.v[1], 7) + rotl(xxh_.v[2], 12) + rotl(xxh_.v[3], 18);
+      for(int lane=0; lane<4; ++lane) h = mergeRound(h, xxh_.v[lane]);
+    }
+    else {
+      h = xxh_.v[2] + prime5;
+    }
+    h += xxh_.total;
+
+    const unsigned char * p = xxh_.buffer;
+    const unsigned char * end = p + xxh_.buffered;
+    for(; p+8 <= end; p+=8) {
+      h ^= round(0, read64(p));
+      h = rotl(h, 27) * prime1 + prime4;
+    }
+    if ( p+4 <= end ) {
+      h ^= read32(p) * prime1;
+      h = rotl(h, 23) * prime2 + prime3;
+      p += 4;
+    }
+    for(; p<end; ++p) {
+      h ^= *p * prime5;
+      h = rotl(h, 11) * prime1;
+    }
+    h ^= h >> 33;
+    h *= prime2;
+    h ^= h >> 29;
+    h *= prime3;
+    h ^= h >> 32;
+
+    unsigned char digest[8];
+    for(int i=0; i<8; ++i) digest[i] = h >> (56 - 8*i);
+    return hex(digest, sizeof(digest));
+  }
+
+}
@@ -0,0 +1,338 @@
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTDiff.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTBinaryFormat.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTDocument.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTXMLLoader.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include "tbb/parallel_for.h"
+#include "tbb/task_arena.h"
+
+namespace {
+
+  using namespace calol1;
+
+  // Document order of the table params within a context
+  const char * tableIds[] = {"ECALLUTMinus", "ECALLUTPlus", "HCALLUTMinus", "HCALLUTPlus", "layer1SecondStageLUT",
+                             "HFLUTMinus", "HFLUTPlus", "HCALFBLUTMinus", "HCALFBLUTPlus"};
+  constexpr size_t nTableIds = sizeof(tableIds)/sizeof(tableIds[0]);
+
+  std::pair<int, size_t> order(const std::pair<std::string, std::string>& key)
+  {
+    size_t id = std::find(tableIds, tableIds + nTableIds, key.second) - tableIds;
+    return {lutfile::contextIndex(key.first), id};
+  }
+
+  bool inOrder(const std::pair<std::string, std::string>& a, const std::pair<std::string, std::string>& b)
+  {
+    const auto oa = order(a), ob = order(b);
+    return oa != ob ? oa < ob : a < b;
+  }
+
+  std::string hex(uint64_t value)
+  {
+    std::ostringstream out;
+    out << "0x" << std::hex << value;
+    return out.str();
+  }
+
+  std::string quoted(const std::string& text)
+  {
+    return "\"" + text + "\"";
+  }
+
+  // fb 0 input 0x12 iEta 4, iEta 4 for one row tables, index 4 for the second stage LUT
+  std::string cellName(const LUTDiff::Cell& cell, bool rows, bool index)
+  {
+    std::ostringstream out;
+    if ( rows ) out << "fb " << (cell.row >> 8) << " input 0x" << std::hex << (cell.row & 0xff) << std::dec << " ";
+    out << (index ? "index " : "iEta ") << cell.iEta;
+    return out.str();
+  }
+
+  LUTTableSet::Table caloTable(const uint16_t * words, const CaloLUT& lut, int firmwareVersion)
+  {
+    LUTTableSet::Table table{2*256, 28, 1, {}};
+    if ( words != nullptr ) {
+      table.words.assign(words, words + table.rows*table.columns);
+      return table;
+    }
+    // Words above 16 bits, not in the store
+    for(uint32_t fb=0; fb<2; ++fb) {
+      for(uint32_t input=0; input<256; ++input) {
+        for(uint32_t iEta=0; iEta<28; ++iEta) table.words.push_back(caloLUTWord(lut[iEta][fb][input], firmwareVersion));
+      }
+    }
+    return table;
+  }
+
+  LUTTableSet::Table hfTable(const uint16_t * words, const HFLUT& lut, int firmwareVersion)
+  {
+    LUTTableSet::Table table{4*256, 12, 30, {}};
+    if ( words != nullptr ) {
+      table.words.assign(words, words + table.rows*table.columns);
+      return table;
+    }
+    for(uint32_t fb=0; fb<4; ++fb) {
+      for(uint32_t input=0; input<256; ++input) {
+        for(uint32_t hfEta=0; hfEta<12; ++hfEta) table.words.push_back(hfLUTWord(lut[hfEta][input], fb, firmwareVersion));
+      }
+    }
+    return table;
+  }
+
+}
+
+namespace calol1 {
+
+  bool
+  LUTTableSet::load(const std::string& fileName)
+  {
+    tables_.clear();
+    error_.clear();
+    const bool binary = fileName.size() > 4 && fileName.compare(fileName.size()-4, 4, ".bin") == 0;
+    return binary ? loadBinary(fileName) : loadXML(fileName);
+  }
+
+  void
+  LUTTableSet::load(const LUTDocument& document)
+  {
+    tables_.clear();
+    error_.clear();
+    const LUTStore& store = document.store();
+    const LUTArrays& luts = document.luts();
+    const int firmwareVersion = document.parameters().firmwareVersion;
+
+    for(const char * side : {"Minus", "Plus"}) {
+      tables_[{"processors", std::string("ECALLUT") + side}] = caloTable(store.ecal(0), luts.ecalLUT[0], firmwareVersion);
+      tables_[{"processors", std::string("HCALLUT") + side}] = caloTable(store.hcal(0), luts.hcalLUT[0], firmwareVersion);
+      tables_[{"processors", std::string("HFLUT") + side}] = hfTable(store.hf(0), luts.hfLUT[0], firmwareVersion);
+      Table hcalFB{1, 28, 1, {}};
+      hcalFB.words.assign(luts.hcalFBLUT.begin(), luts.hcalFBLUT.begin() + std::min<size_t>(28, luts.hcalFBLUT.size()));
+      hcalFB.columns = hcalFB.words.size();
+      tables_[{"processors", std::string("HCALFBLUT") + side}] = hcalFB;
+    }
+    if ( firmwareVersion > 1 ) {
+      const std::vector<uint32_t>& lut = document.parameters().secondStageLUT;
+      Table secondStage{1, static_cast<uint32_t>(lut.size()), 0, std::vector<uint64_t>(lut.begin(), lut.end())};
+      tables_[{"processors", "layer1SecondStageLUT"}] = secondStage;
+    }
+
+    for(const auto& context : document.cardContexts()) {
+      for(const auto& param : context.params) {
+        const LUTTableKey& key = param.second;
+        Table& table = tables_[{context.id, param.first}];
+        if ( key.kind == LUTKind::ECAL ) table = caloTable(store.ecal(key.index), luts.ecalLUT[key.index], firmwareVersion);
+        else if ( key.kind == LUTKind::HCAL ) table = caloTable(store.hcal(key.index), luts.hcalLUT[key.index], firmwareVersion);
+        else if ( key.kind == LUTKind::HF ) table = hfTable(store.hf(key.index), luts.hfLUT[key.index], firmwareVersion);
+      }
+    }
+  }
+
+  bool
+  LUTTableSet::loadXML(const std::string& fileName)
+  {
+    // One context at a time; the checksums are checked by the loader but
+    // are not what is compared here
+    LUTXMLLoader loader;
+    const bool loaded = loader.load(fileName, [this](const LUTXMLLoader::Context& context) {
+      auto words = [](const auto& table) { return std::vector<uint64_t>(table.begin(), table.end()); };
+      const char * sides[] = {"Minus", "Plus"};
+      for(size_t side=0; side<2; ++side) {
+        if ( !context.ecal[side].empty() ) tables_[{context.id, std::string("ECALLUT") + sides[side]}] = Table{2*256, 28, 1, words(context.ecal[side])};
+        if ( !context.hcal[side].empty() ) tables_[{context.id, std::string("HCALLUT") + sides[side]}] = Table{2*256, 28, 1, words(context.hcal[side])};
+        if ( !context.hf[side].empty() ) tables_[{context.id, std::string("HFLUT") + sides[side]}] = Table{4*256, 12, 30, words(context.hf[side])};
+        if ( !context.hcalFB[side].empty() ) tables_[{context.id, std::string("HCALFBLUT") + sides[side]}] = Table{1, 28, 1, context.hcalFB[side]};
+      }
+      if ( !context.secondStageLUT.empty() ) {
+        tables_[{context.id, "layer1SecondStageLUT"}] = Table{1, static_cast<uint32_t>(context.secondStageLUT.size()), 0, words(context.secondStageLUT)};
+      }
+      return true;
+    });
+    if ( !loaded ) error_ = loader.error();
+    return loaded;
+  }
+
+  bool
+  LUTTableSet::loadBinary(const std::string& fileName)
+  {
+    using namespace lutfile;
+    LUTBinaryReader reader;
+    if ( !reader.open(fileName) ) {
+      error_ = reader.error();
+      return false;
+    }
+    for(const auto& section : reader.sections()) {
+      const std::string context = contextName(section.context);
+      const char * side = ( section.id == static_cast<uint32_t>(Side::Plus) ) ? "Plus" : "Minus";
+      const SectionType type = static_cast<SectionType>(section.type);
+      Table table{0, 0, 0, {}};
+      std::string id;
+      if ( type == SectionType::ECALLUT || type == SectionType::HCALLUT || type == SectionType::HFLUT ) {
+        const bool hf = ( type == SectionType::HFLUT );
+        id = std::string(hf ? "HFLUT" : (type == SectionType::ECALLUT ? "ECALLUT" : "HCALLUT")) + side;
+        const std::vector<uint16_t> words = reader.table(section);
+        table = Table{hf ? 4*256u : 2*256u, hf ? 12u : 28u, hf ? 30u : 1u, std::vector<uint64_t>(words.begin(), words.end())};
+      }
+      else if ( type == SectionType::HCALFBLUT ) {
+        id = std::string("HCALFBLUT") + side;
+        const std::vector<unsigned long long int> words = reader.uint64Vector(section);
+        table = Table{1, static_cast<uint32_t>(words.size()), 1, std::vector<uint64_t>(words.begin(), words.end())};
+      }
+      else if ( type == SectionType::SecondStageLUT ) {
+        id = "layer1SecondStageLUT";
+        const std::vector<uint32_t> words = reader.uint32Vector(section);
+        table = Table{1, static_cast<uint32_t>(words.size()), 0, std::vector<uint64_t>(words.begin(), words.end())};
+      }
+      else continue;
+      tables_[{context, id}] = std::move(table);
+    }
+    return true;
+  }
+
+  const LUTTableSet::Table *
+  LUTTableSet::find(const std::string& context, const std::string& id) const
+  {
+    auto it = tables_.find({context, id});
+    if ( it == tables_.end() ) it = tables_.find({"processors", id});
+    return it == tables_.end() ? nullptr : &it->second;
+  }
+
+  std::vector< std::pair<std::string, std::string> >
+  LUTTableSet::keys() const
+  {
+    std::vector< std::pair<std::string, std::string> > keys;
+    for(const auto& entry : tables_) keys.push_back(entry.first);
+    std::sort(keys.begin(), keys.end(), inOrder);
+    return keys;
+  }
+
+  LUTDiff::LUTDiff(const LUTTableSet& before, const LUTTableSet& after, int numberOfThreads, size_t maxCells)
+  {
+    std::vector< std::pair<std::string, std::string> > keys = before.keys();
+    for(const auto& key : after.keys()) {
+      if ( std::find(keys.begin(), keys.end(), key) == keys.end() ) keys.push_back(key);
+    }
+    std::sort(keys.begin(), keys.end(), inOrder);
+    compared_ = keys.size();
+
+    // Each table into its own slot, kept if it differs
+    std::vector<TableDiff> diffs(keys.size());
+    auto compare = [&](size_t i) {
+      TableDiff& diff = diffs[i];
+      diff.context = keys[i].first;
+      diff.id = keys[i].second;
+      const LUTTableSet::Table * a = before.find(diff.context, diff.id);
+      const LUTTableSet::Table * b = after.find(diff.context, diff.id);
+      diff.missingBefore = ( a == nullptr );
+      diff.missingAfter = ( b == nullptr );
+      if ( a == nullptr || b == nullptr ) return;
+      if ( a->rows != b->rows || a->columns != b->columns || a->firstEta != b->firstEta ) {
+        diff.shapeChanged = true;
+        return;
+      }
+      diff.cells = a->words.size();
+      diff.firstEta = a->firstEta;
+      diff.changedPerEta.assign(a->columns, 0);
+      const uint64_t * wa = a->words.data();
+      const uint64_t * wb = b->words.data();
+      for(uint32_t row=0; row<a->rows; ++row) {
+        for(uint32_t column=0; column<a->columns; ++column, ++wa, ++wb) {
+          if ( *wa == *wb ) continue;
+          ++diff.changed;
+          ++diff.changedPerEta[column];
+          if ( diff.first.size() < maxCells ) diff.first.push_back({a->firstEta + column, row, *wa, *wb});
+        }
+      }
+    };
+    if ( numberOfThreads == 1 ) {
+      for(size_t i=0; i<keys.size(); ++i) compare(i);
+    }
+    else {
+      tbb::task_arena arena(numberOfThreads > 0 ? numberOfThreads : static_cast<int>(tbb::task_arena::automatic));
+      arena.execute([&]() { tbb::parallel_for(size_t(0), keys.size(), compare); });
+    }
+
+    for(auto& diff : diffs) {
+      if ( diff.missingBefore || diff.missingAfter || diff.shapeChanged || diff.changed > 0 ) tables_.push_back(std::move(diff));
+    }
+  }
+
+  uint64_t
+  LUTDiff::changedCells() const
+  {
+    uint64_t changed{0};
+    for(const auto& diff : tables_) changed += diff.changed;
+    return changed;
+  }
+
+  void
+  LUTDiff::print(std::ostream& out) const
+  {
+    for(const auto& diff : tables_) {
+      out << diff.context << " " << diff.id << ": ";
+      if ( diff.missingBefore || diff.missingAfter ) {
+        out << (diff.missingBefore ? "added" : "removed") << "\n";
+        continue;
+      }
+      if ( diff.shapeChanged ) {
+        out << "shape changed\n";
+        continue;
+      }
+      out << diff.changed << "/" << diff.cells << " cells, iEta";
+      for(size_t column=0; column<diff.changedPerEta.size(); ++column) {
+        if ( diff.changedPerEta[column] > 0 ) out << " " << diff.firstEta + column << ":" << diff.changedPerEta[column];
+      }
+      const bool rows = diff.cells > diff.changedPerEta.size();
+      for(size_t i=0; i<diff.first.size(); ++i) {
+        const Cell& cell = diff.first[i];
+        out << (i == 0 ? ", first " : "; ") << cellName(cell, rows, diff.firstEta == 0) << " " << hex(cell.before) << " -> " << hex(cell.after);
+      }
+      out << "\n";
+    }
+    out << tables_.size() << " of " << compared_ << " tables differ, " << changedCells() << " cells changed\n";
+  }
+
+  bool
+  LUTDiff::writeJSON(const std::string& fileName) const
+  {
+    std::ofstream out(fileName, std::ios::trunc);
+    out << "{\"compared\": " << compared_ << ", \"changedCells\": " << changedCells() << ", \"tables\": [";
+    for(size_t i=0; i<tables_.size(); ++i) {
+      const TableDiff& diff = tables_[i];
+      out << (i > 0 ? "," : "") << "\n  {\"context\": " << quoted(diff.context) << ", \"table\": " << quoted(diff.id);
+      if ( diff.missingBefore || diff.missingAfter ) {
+        out << ", \"missing\": " << quoted(diff.missingBefore ? "before" : "after") << "}";
+        continue;
+      }
+      if ( diff.shapeChanged ) {
+        out << ", \"shapeChanged\": true}";
+        continue;
+      }
+      out << ", \"cells\": " << diff.cells << ", \"changed\": " << diff.changed << ",\n   \"perEta\": {";
+      bool firstEta = true;
+      for(size_t column=0; column<diff.changedPerEta.size(); ++column) {
+        if ( diff.changedPerEta[column] == 0 ) continue;
+        out << (firstEta ? "" : ", ") << "\"" << diff.firstEta + column << "\": " << diff.changedPerEta[column];
+        firstEta = false;
+      }
+      out << "},\n   \"first\": [";
+      const bool rows = diff.cells > diff.changedPerEta.size();
+      for(size_t j=0; j<diff.first.size(); ++j) {
+        const Cell& cell = diff.first[j];
+        out << (j > 0 ? ", " : "") << "{";
+        if ( rows ) out << "\"fb\": " << (cell.row >> 8) << ", \"input\": " << (cell.row & 0xff) << ", ";
+        out << (diff.firstEta == 0 ? "\"index\": " : "\"iEta\": ") << cell.iEta
+            << ", \"before\": " << quoted(hex(cell.before)) << ", \"after\": " << quoted(hex(cell.after)) << "}";
+      }
+      out << "]}";
+    }
+    out << "\n]}\n";
+    out.close();
+    return static_cast<bool>(out);
+  }
+
+}
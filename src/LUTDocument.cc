@@ -0,0 +1,649 @@
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTDocument.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTBinaryFormat.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTPacking.h"
+
+#include <algorithm>
+
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+
+namespace calol1 {
+
+  LUTDocument::LUTDocument(const LUTParameters& parameters, const LUTArrays& luts) :
+    parameters_(parameters),
+    luts_(luts),
+    store_(luts, parameters.firmwareVersion),
+    cache_([this](const LUTTableKey& key, RenderedTable& table) { renderTable(key, table); })
+  {
+    // Now add phi dependent context for each ctp7
+    // map CTP7 0 1 ... 17 -> CTP7_Phi0 CTP7_Phi1 ... CTP7_Phi17
+    const std::vector<unsigned int>& ePhiBins  = parameters_.ecalScalePhiBins;
+    const std::vector<unsigned int>& hPhiBins  = parameters_.hcalScalePhiBins;
+    const std::vector<unsigned int>& hfPhiBins = parameters_.hfScalePhiBins;
+    const int firmwareVersion = parameters_.firmwareVersion;
+    for ( uint32_t card=0; card<18; card++ ){
+      // check which processors to write
+      if (!(
+           ( ePhiBins.size()==36 && ePhiBins[card] )
+           || ( ePhiBins.size()==36 && ePhiBins[18+card] )
+           || ( hPhiBins.size()==36 && hPhiBins[card] )
+           || ( hPhiBins.size()==36 && hPhiBins[18+card] )
+           || ( hfPhiBins.size()==36 && hfPhiBins[card] )
+           || ( hfPhiBins.size()==36 && hfPhiBins[18+card] )
+         ))
+        continue;
+
+      CardContext context{card, "CTP7_Phi" + std::to_string(card), {}};
+      ContextParams& params = context.params;
+
+      // if override ECAL LUT
+      if ( ePhiBins.size()==36 && ePhiBins[card] ) {
+        params.push_back({"ECALLUTMinus", {LUTKind::ECAL, ePhiBins[card], firmwareVersion}});
+      }
+      if ( ePhiBins.size()==36 && ePhiBins[18+card] ) {
+        params.push_back({"ECALLUTPlus", {LUTKind::ECAL, ePhiBins[18+card], firmwareVersion}});
+      }
+
+      // if override HCAL LUT
+      if ( hPhiBins.size()==36 && hPhiBins[card] ) {
+        params.push_back({"HCALLUTMinus", {LUTKind::HCAL, hPhiBins[card], firmwareVersion}});
+      }
+      // NB the HF size test has always guarded HCALLUTPlus
+      if ( hfPhiBins.size()==36 && hPhiBins[18+card] ) {
+        params.push_back({"HCALLUTPlus", {LUTKind::HCAL, hPhiBins[18+card], firmwareVersion}});
+      }
+
+      // if override HF LUT
+      if ( hfPhiBins.size()==36 && hfPhiBins[card] ) {
+        params.push_back({"HFLUTMinus", {LUTKind::HF, hfPhiBins[card], firmwareVersion}});
+      }
+      if ( hfPhiBins.size()==36 && hfPhiBins[18+card] ) {
+        params.push_back({"HFLUTPlus", {LUTKind::HF, hfPhiBins[18+card], firmwareVersion}});
+      }
+
+      cards_.push_back(std::move(context));
+    }
+  }
+
+  std::vector<LUTTableKey>
+  LUTDocument::tableKeys() const
+  {
+    const int firmwareVersion = parameters_.firmwareVersion;
+    std::vector<LUTTableKey> keys{
+      {LUTKind::ECAL, 0, firmwareVersion},
+      {LUTKind::HCAL, 0, firmwareVersion},
+      {LUTKind::HF, 0, firmwareVersion},
+      {LUTKind::HCALFB, 0, firmwareVersion}
+    };
+    for(const auto& context : cards_) {
+      for(const auto& param : context.params) keys.push_back(param.second);
+    }
+    return keys;
+  }
+
+  void
+  LUTDocument::prefetch(int numberOfThreads)
+  {
+    LUTMetrics::Timer timer(metrics_, "render tables");
+    cache_.prefetch(tableKeys(), numberOfThreads);
+  }
+
+  void
+  LUTDocument::computeChecksums(ChecksumAlgorithm algorithm)
+  {
+    LUTMetrics::Timer timer(metrics_, "hash");
+    const int firmwareVersion = parameters_.firmwareVersion;
+    LUTChecksum digest(algorithm);
+    auto update = [this, firmwareVersion, &digest](LUTKind kind) {
+      const std::vector<unsigned char>& payload = cache_.get({kind, 0, firmwareVersion}).payload;
+      // Minus and Plus
+      digest.update(payload.data(), payload.size());
+      digest.update(payload.data(), payload.size());
+    };
+
+    // Same order as the tables in the context
+    update(LUTKind::ECAL);
+    update(LUTKind::HCAL);
+    if ( firmwareVersion > 1 ) {
+      const std::vector<uint32_t>& lut = parameters_.secondStageLUT;
+      digest.update(lut.data(), lut.size()*sizeof(uint32_t));
+    }
+    update(LUTKind::HF);
+    update(LUTKind::HCALFB);
+    processorsChecksums_[algorithm] = digest.digest();
+
+    for(const auto& context : cards_) {
+      std::vector<LUTTableKey> keys;
+      for(const auto& param : context.params) keys.push_back(param.second);
+      contextChecksums_[{context.card, algorithm}] = cache_.checksum(keys, algorithm);
+    }
+  }
+
+  const std::string&
+  LUTDocument::processorsChecksum(ChecksumAlgorithm algorithm) const
+  {
+    static const std::string none;
+    auto it = processorsChecksums_.find(algorithm);
+    return it != processorsChecksums_.end() ? it->second : none;
+  }
+
+  const std::string&
+  LUTDocument::checksum(const CardContext& context, ChecksumAlgorithm algorithm) const
+  {
+    static const std::string none;
+    auto it = contextChecksums_.find({context.card, algorithm});
+    return it != contextChecksums_.end() ? it->second : none;
+  }
+
+  const std::vector<uint32_t> *
+  LUTDocument::deltaRows(const LUTTableKey& key) const
+  {
+    if ( !deltaContexts_ ) return nullptr;
+    auto it = deltaRows_.find(key);
+    return it != deltaRows_.end() ? &it->second : nullptr;
+  }
+
+  void
+  LUTDocument::computeDeltaRows()
+  {
+    if ( !deltaContexts_ || deltaRowsComputed_ ) return;
+    LUTMetrics::Timer timer(metrics_, "delta rows");
+    for(const auto& context : cards_) {
+      for(const auto& param : context.params) {
+        const LUTTableKey& key = param.second;
+        if ( deltaRows_.count(key) > 0 ) continue;
+        const uint16_t * base{nullptr};
+        const uint16_t * words{nullptr};
+        if ( key.kind == LUTKind::ECAL ) {
+          base = store_.ecal(0);
+          words = store_.ecal(key.index);
+        }
+        else if ( key.kind == LUTKind::HCAL ) {
+          base = store_.hcal(0);
+          words = store_.hcal(key.index);
+        }
+        else if ( key.kind == LUTKind::HF ) {
+          base = store_.hf(0);
+          words = store_.hf(key.index);
+        }
+        // Words above 16 bits are not in the store, those tables are written whole
+        if ( base == nullptr || words == nullptr ) continue;
+        std::vector<uint32_t>& rows = deltaRows_[key];
+        if ( key.kind == LUTKind::HF ) differingRows(base, words, hfTableRows, 12, rows);
+        else differingRows(base, words, caloTableRows, 28, rows);
+        if ( rows.empty() ) rows.push_back(0);
+        LUTMetrics::count(metrics_, "delta rows", rows.size());
+      }
+    }
+    deltaRowsComputed_ = true;
+  }
+
+  const char *
+  LUTDocument::tableStage(const std::string& id)
+  {
+    if ( id.compare(0, 6, "HCALFB") == 0 ) return "write HCALFBLUT";
+    if ( id.compare(0, 4, "HCAL") == 0 ) return "write HCALLUT";
+    if ( id.compare(0, 2, "HF") == 0 ) return "write HFLUT";
+    return "write ECALLUT";
+  }
+
+  bool
+  LUTDocument::rcWrap(int rc) const
+  {
+    if ( rc < 0 ) {
+      edm::LogError("L1TCaloLayer1LUTWriter") << "Error while processing an xmllib command :<";
+      return false;
+    }
+    return true;
+  }
+
+  bool
+  LUTDocument::checkPrepared() const
+  {
+    if ( !prepared_ ) {
+      edm::LogError("L1TCaloLayer1LUTWriter") << "LUT document written before prepare()";
+      return false;
+    }
+    return true;
+  }
+
+  bool
+  LUTDocument::writeXML(xmlTextWriterPtr writer) const
+  {
+    XMLOutput out;
+    out.writer = writer;
+    return writeDocument(out);
+  }
+
+  bool
+  LUTDocument::writeXML(SWATCHXMLEmitter& emitter) const
+  {
+    XMLOutput out;
+    out.emitter = &emitter;
+    return writeDocument(out);
+  }
+
+  bool
+  LUTDocument::writeDocument(XMLOutput& out) const
+  {
+    if ( !checkPrepared() ) return false;
+    if ( !startAlgo(out) ) return false;
+
+    if ( !writeProcessorsContext(out) ) return false;
+
+    for(const auto& context : cards_) {
+      if ( !writeContext(out, context) ) return false;
+    }
+
+    return endAlgo(out);
+  }
+
+  void
+  LUTDocument::prepare(int numberOfThreads)
+  {
+    prefetch(numberOfThreads);
+    computeDeltaRows();
+    computeChecksums(ChecksumAlgorithm::MD5);
+    for(ChecksumAlgorithm algorithm : extraChecksums_) {
+      if ( algorithm != ChecksumAlgorithm::MD5 ) computeChecksums(algorithm);
+    }
+    prepared_ = true;
+  }
+
+  bool
+  LUTDocument::writeContextXML(xmlTextWriterPtr writer, size_t context) const
+  {
+    XMLOutput out;
+    out.writer = writer;
+    return writeContextDocument(out, context);
+  }
+
+  bool
+  LUTDocument::writeContextXML(SWATCHXMLEmitter& emitter, size_t context) const
+  {
+    XMLOutput out;
+    out.emitter = &emitter;
+    return writeContextDocument(out, context);
+  }
+
+  bool
+  LUTDocument::writeContextDocument(XMLOutput& out, size_t context) const
+  {
+    if ( !checkPrepared() ) return false;
+    if ( !startAlgo(out) ) return false;
+    if ( context == 0 ) {
+      if ( !writeProcessorsContext(out) ) return false;
+    }
+    else {
+      if ( !writeContext(out, cards_.at(context-1)) ) return false;
+    }
+    return endAlgo(out);
+  }
+
+  bool
+  LUTDocument::startAlgo(XMLOutput& out) const
+  {
+    if ( out.emitter != nullptr ) return rcWrap(out.emitter->startAlgo("calol1"));
+
+    if ( !rcWrap(xmlTextWriterStartDocument(out.writer, NULL, NULL, NULL)) ) return false;
+
+    // Root node <algo>
+    if ( !rcWrap(xmlTextWriterStartElement(out.writer, BAD_CAST "algo")) ) return false;
+    return rcWrap(xmlTextWriterWriteAttribute(out.writer, BAD_CAST "id", BAD_CAST "calol1"));
+  }
+
+  bool
+  LUTDocument::endAlgo(XMLOutput& out) const
+  {
+    // The writer flushes what it still holds
+    LUTMetrics::Timer timer(metrics_, "end document");
+    if ( out.emitter != nullptr ) return rcWrap(out.emitter->endAlgo());
+
+    // Closes all open elements recursively for us
+    return rcWrap(xmlTextWriterEndDocument(out.writer));
+  }
+
+  bool
+  LUTDocument::startContext(XMLOutput& out, const std::string& id) const
+  {
+    LUTMetrics::count(metrics_, "contexts");
+    if ( out.emitter != nullptr ) return rcWrap(out.emitter->startContext(id.c_str()));
+
+    // <context>
+    if ( !rcWrap(xmlTextWriterStartElement(out.writer, BAD_CAST "context")) ) return false;
+    return rcWrap(xmlTextWriterWriteAttribute(out.writer, BAD_CAST "id", BAD_CAST id.c_str()));
+  }
+
+  bool
+  LUTDocument::endContext(XMLOutput& out) const
+  {
+    if ( out.emitter != nullptr ) return rcWrap(out.emitter->endContext());
+
+    // </context>
+    return rcWrap(xmlTextWriterEndElement(out.writer));
+  }
+
+  bool
+  LUTDocument::writeProcessorsContext(XMLOutput& out) const
+  {
+    const int firmwareVersion = parameters_.firmwareVersion;
+
+    if ( !writeProcessorsHeader(out) ) return false;
+
+    // ECAL and HCAL LUT -> Minus and Plus
+    const RenderedTable& ecal = preparedTable({LUTKind::ECAL, 0, firmwareVersion});
+    if ( !writeTable(out, "ECALLUTMinus", ecal) ) return false;
+    if ( !writeTable(out, "ECALLUTPlus", ecal) ) return false;
+    const RenderedTable& hcal = preparedTable({LUTKind::HCAL, 0, firmwareVersion});
+    if ( !writeTable(out, "HCALLUTMinus", hcal) ) return false;
+    if ( !writeTable(out, "HCALLUTPlus", hcal) ) return false;
+
+    if ( !writeSecondStageLUT(out) ) return false;
+
+    // HF and HCAL FB LUT -> Minus and Plus
+    const RenderedTable& hf = preparedTable({LUTKind::HF, 0, firmwareVersion});
+    if ( !writeTable(out, "HFLUTMinus", hf) ) return false;
+    if ( !writeTable(out, "HFLUTPlus", hf) ) return false;
+    // Not phi dependent
+    const RenderedTable& hcalFB = preparedTable({LUTKind::HCALFB, 0, firmwareVersion});
+    if ( !writeTable(out, "HCALFBLUTMinus", hcalFB) ) return false;
+    if ( !writeTable(out, "HCALFBLUTPlus", hcalFB) ) return false;
+
+    // Now to write the checksum
+    if ( !writeXMLParam(out, "md5checksum", "string", processorsChecksum()) ) return false;
+    if ( !writeExtraChecksums(out, [this](ChecksumAlgorithm algorithm) -> const std::string& { return processorsChecksum(algorithm); }) ) return false;
+
+    return endContext(out);
+  }
+
+  bool
+  LUTDocument::writeProcessorsHeader(XMLOutput& out) const
+  {
+    const LUTParameters& p = parameters_;
+
+    // SWATCH magic for all cards
+    // different LUTs are added via contexts at the end
+    if ( !startContext(out, "processors") ) return false;
+
+    // LUT generation parameters
+    // This is not needed for SWATCH
+    // but necessary for O2O, given the offline format
+    // NB "layer1SecondStageLUT" written later since it is same format as offline
+    if ( !writeSWATCHVector(out, "layer1ECalScaleETBins", p.ecalScaleETBins) ) return false;
+    if ( !writeSWATCHVector(out, "layer1ECalScalePhiBins", p.ecalScalePhiBins) ) return false;
+    if ( !writeSWATCHVector(out, "layer1ECalScaleFactors", p.ecalScaleFactors) ) return false;
+    if ( !writeSWATCHVector(out, "layer1HCalScaleETBins", p.hcalScaleETBins) ) return false;
+    if ( !writeSWATCHVector(out, "layer1HCalScalePhiBins", p.hcalScalePhiBins) ) return false;
+    if ( !writeSWATCHVector(out, "layer1HCalScaleFactors", p.hcalScaleFactors) ) return false;
+    if ( !writeSWATCHVector(out, "layer1HFScaleETBins", p.hfScaleETBins) ) return false;
+    if ( !writeSWATCHVector(out, "layer1HFScalePhiBins", p.hfScalePhiBins) ) return false;
+    if ( !writeSWATCHVector(out, "layer1HFScaleFactors", p.hfScaleFactors) ) return false;
+    if ( !writeSWATCHVector(out, "layer1HFScaleFactors", p.hfScaleFactors) ) return false;
+    if ( !writeSWATCHVector(out, "layer1HCalFBLUTUpper", p.hcalFBLUTUpper) ) return false;
+    if ( !writeSWATCHVector(out, "layer1HCalFBLUTLower", p.hcalFBLUTLower) ) return false;
+    if ( !writeXMLParam(out, "towerLsbSum", "float", std::to_string(p.towerLsbSum)) ) return false;
+    if ( !writeXMLParam(out, "useLSB", "bool", (p.useLSB) ? "true":"false") ) return false;
+    if ( !writeXMLParam(out, "useCalib", "bool", (p.useCalib) ? "true":"false") ) return false;
+    if ( !writeXMLParam(out, "useECALLUT", "bool", (p.useECALLUT) ? "true":"false") ) return false;
+    if ( !writeXMLParam(out, "useHCALLUT", "bool", (p.useHCALLUT) ? "true":"false") ) return false;
+    if ( !writeXMLParam(out, "useHFLUT", "bool", (p.useHFLUT) ? "true":"false") ) return false;
+    if ( !writeXMLParam(out, "useHCALFBLUT", "bool", (p.useHCALFBLUT) ? "true":"false") ) return false;
+    return true;
+  }
+
+  bool
+  LUTDocument::writeSecondStageLUT(XMLOutput& out) const
+  {
+    // Firmware version 2 has also second-stage LUT (aka HoverE LUT)
+    if ( parameters_.firmwareVersion > 1 ) {
+      const std::vector<uint32_t>& lut = parameters_.secondStageLUT;
+      if ( !writeXMLParam(out, "layer1SecondStageLUT", "vector:uint", out.formatter.formatHex(lut.data(), lut.size(), 10)) ) return false;
+    }
+    return true;
+  }
+
+  bool
+  LUTDocument::writeContext(XMLOutput& out, const CardContext& context) const
+  {
+    if ( !startContext(out, context.id) ) return false;
+
+    for(const auto& param : context.params) {
+      if ( !writeTable(out, param.first, preparedTable(param.second), deltaRows(param.second)) ) return false;
+    }
+
+    // write checksum
+    if ( !writeXMLParam(out, "md5checksum", "string", checksum(context)) ) return false;
+    if ( !writeExtraChecksums(out, [this, &context](ChecksumAlgorithm algorithm) -> const std::string& { return checksum(context, algorithm); }) ) return false;
+
+    return endContext(out);
+  }
+
+  bool
+  LUTDocument::writeExtraChecksums(XMLOutput& out, const std::function<const std::string&(ChecksumAlgorithm)>& checksum) const
+  {
+    for(ChecksumAlgorithm algorithm : extraChecksums_) {
+      if ( algorithm == ChecksumAlgorithm::MD5 ) continue;
+      const std::string id = std::string(checksumAlgorithmName(algorithm)) + "checksum";
+      if ( !writeXMLParam(out, id, "string", checksum(algorithm)) ) return false;
+    }
+    return true;
+  }
+
+  bool
+  LUTDocument::writeTable(XMLOutput& out, const std::string& id, const RenderedTable& table, const std::vector<uint32_t> * rows) const
+  {
+    LUTMetrics::Timer timer(metrics_, tableStage(id));
+    if ( !writeTableStart(out, id, table, rows != nullptr) ) return false;
+    if ( !writeTableRows(out, table, rows) ) return false;
+    return writeTableEnd(out);
+  }
+
+  bool
+  LUTDocument::writeTableStart(XMLOutput& out, const std::string& id, const RenderedTable& table, bool delta) const
+  {
+    const char * type = delta ? "table:delta" : "table";
+    if ( out.emitter != nullptr ) return rcWrap(out.emitter->startTable(id.c_str(), table.columns, table.types, type));
+
+    // <param id="ECALLUT" type="table">
+    if ( !rcWrap(xmlTextWriterStartElement(out.writer, BAD_CAST "param")) ) return false;
+    if ( !rcWrap(xmlTextWriterWriteAttribute(out.writer, BAD_CAST "id", BAD_CAST id.c_str())) ) return false;
+    if ( !rcWrap(xmlTextWriterWriteAttribute(out.writer, BAD_CAST "type", BAD_CAST type)) ) return false;
+
+    // <columns>
+    if ( !rcWrap(xmlTextWriterWriteElement(out.writer, BAD_CAST "columns", BAD_CAST table.columns)) ) return false;
+
+    // <types>
+    if ( !rcWrap(xmlTextWriterWriteElement(out.writer, BAD_CAST "types", BAD_CAST table.types)) ) return false;
+
+    // <rows>
+    return rcWrap(xmlTextWriterStartElement(out.writer, BAD_CAST "rows"));
+  }
+
+  bool
+  LUTDocument::writeTableRows(XMLOutput& out, const RenderedTable& table, const std::vector<uint32_t> * rows, uint32_t first) const
+  {
+    // Indices into table of the rows to write
+    std::vector<uint32_t> selected;
+    if ( rows != nullptr ) {
+      for(auto it=std::lower_bound(rows->begin(), rows->end(), first); it!=rows->end() && *it<first+table.nRows(); ++it) {
+        selected.push_back(*it - first);
+      }
+    }
+    const size_t n = ( rows != nullptr ) ? selected.size() : table.nRows();
+    auto row = [&table, &selected, rows](size_t i) { return table.row(rows != nullptr ? selected[i] : i); };
+
+    LUTMetrics::count(metrics_, "rows", n);
+    if ( out.emitter != nullptr ) {
+      for(size_t i=0; i<n; ++i) {
+        if ( !rcWrap(out.emitter->row(row(i))) ) return false;
+      }
+      return true;
+    }
+
+    for(size_t i=0; i<n; ++i) {
+      if ( !rcWrap(xmlTextWriterWriteElement(out.writer, BAD_CAST "row", BAD_CAST row(i))) ) return false;
+    }
+    return true;
+  }
+
+  bool
+  LUTDocument::writeTableEnd(XMLOutput& out) const
+  {
+    if ( out.emitter != nullptr ) return rcWrap(out.emitter->endTable());
+
+    // </rows>
+    if ( !rcWrap(xmlTextWriterEndElement(out.writer)) ) return false;
+    // </param>
+    if ( !rcWrap(xmlTextWriterEndElement(out.writer)) ) return false;
+
+    return true;
+  }
+
+  bool
+  LUTDocument::writeXMLParam(XMLOutput& out, const std::string& id, const std::string& type, const std::string& body) const
+  {
+    return writeXMLParam(out, id, type, body.c_str());
+  }
+
+  bool
+  LUTDocument::writeXMLParam(XMLOutput& out, const std::string& id, const std::string& type, const char * body) const
+  {
+    if ( out.emitter != nullptr ) return rcWrap(out.emitter->param(id.c_str(), type.c_str(), body));
+
+    if ( !rcWrap(xmlTextWriterStartElement(out.writer, BAD_CAST "param")) ) return false;
+    if ( !rcWrap(xmlTextWriterWriteAttribute(out.writer, BAD_CAST "id", BAD_CAST id.c_str())) ) return false;
+    if ( !rcWrap(xmlTextWriterWriteAttribute(out.writer, BAD_CAST "type", BAD_CAST type.c_str())) ) return false;
+    if ( !rcWrap(xmlTextWriterWriteString(out.writer, BAD_CAST body)) ) return false;
+    if ( !rcWrap(xmlTextWriterEndElement(out.writer)) ) return false;
+
+    // Success!
+    return true;
+  }
+
+  bool
+  LUTDocument::writeSWATCHVector(XMLOutput& out, const std::string& id, const std::vector<int>& vect) const
+  {
+    return writeXMLParam(out, id, "vector:int", out.formatter.formatList(vect));
+  }
+
+  bool
+  LUTDocument::writeSWATCHVector(XMLOutput& out, const std::string& id, const std::vector<unsigned int>& vect) const
+  {
+    return writeXMLParam(out, id, "vector:uint", out.formatter.formatList(vect));
+  }
+
+  bool
+  LUTDocument::writeSWATCHVector(XMLOutput& out, const std::string& id, const std::vector<double>& vect) const
+  {
+    return writeXMLParam(out, id, "vector:float", out.formatter.formatList(vect));
+  }
+
+  bool
+  LUTDocument::writeSWATCHVector(XMLOutput& out, const std::string& id, const std::vector<unsigned long long int>& vect) const
+  {
+    return writeXMLParam(out, id, "vector:uint64", out.formatter.formatList(vect));
+  }
+
+  void
+  LUTDocument::renderTable(const LUTTableKey& key, RenderedTable& table) const
+  {
+    switch ( key.kind ) {
+      // Words above 16 bits cannot come from the store, those
+      // tables are rendered from the arrays as before
+      case LUTKind::ECAL:
+        if ( const uint16_t * words = store_.ecal(key.index) ) renderCaloWords(words, table);
+        else renderCaloLUT(luts_.ecalLUT[key.index], key.firmwareVersion, table);
+        break;
+      case LUTKind::HCAL:
+        if ( const uint16_t * words = store_.hcal(key.index) ) renderCaloWords(words, table);
+        else renderCaloLUT(luts_.hcalLUT[key.index], key.firmwareVersion, table);
+        break;
+      case LUTKind::HF:
+        if ( const uint16_t * words = store_.hf(key.index) ) renderHFWords(words, table);
+        else renderHFLUT(luts_.hfLUT[key.index], key.firmwareVersion, table);
+        break;
+      case LUTKind::HCALFB:
+        renderHCALFBLUT(luts_.hcalFBLUT, table);
+        break;
+    }
+  }
+
+  bool
+  LUTDocument::writeBinary(const std::string& fileName) const
+  {
+    using namespace lutfile;
+    if ( processorsChecksum().empty() ) {
+      edm::LogError("L1TCaloLayer1LUTWriter") << "Binary LUT file " << fileName << " written before the checksums were computed";
+      return false;
+    }
+    const LUTParameters& p = parameters_;
+    LUTBinaryWriter binary(p.firmwareVersion);
+    // The store is only nullptr for words above 16 bits, the array
+    // version then fails with the same error as it always did
+    auto addCaloLUT = [this, &binary](SectionType type, uint32_t context, Side side, uint32_t index) {
+      const bool ecal = ( type == SectionType::ECALLUT );
+      if ( const uint16_t * words = ecal ? store_.ecal(index) : store_.hcal(index) ) {
+        binary.addCaloWords(type, context, side, words);
+      }
+      else {
+        binary.addCaloLUT(type, context, side, ecal ? luts_.ecalLUT[index] : luts_.hcalLUT[index]);
+      }
+    };
+    auto addHFLUT = [this, &binary](uint32_t context, Side side, uint32_t index) {
+      if ( const uint16_t * words = store_.hf(index) ) binary.addHFWords(context, side, words);
+      else binary.addHFLUT(context, side, luts_.hfLUT[index]);
+    };
+
+    // Same order as the processors context in the XML
+    binary.addVector(processorsContext, VectorId::ECalScaleETBins, p.ecalScaleETBins);
+    binary.addVector(processorsContext, VectorId::ECalScalePhiBins, p.ecalScalePhiBins);
+    binary.addVector(processorsContext, VectorId::ECalScaleFactors, p.ecalScaleFactors);
+    binary.addVector(processorsContext, VectorId::HCalScaleETBins, p.hcalScaleETBins);
+    binary.addVector(processorsContext, VectorId::HCalScalePhiBins, p.hcalScalePhiBins);
+    binary.addVector(processorsContext, VectorId::HCalScaleFactors, p.hcalScaleFactors);
+    binary.addVector(processorsContext, VectorId::HFScaleETBins, p.hfScaleETBins);
+    binary.addVector(processorsContext, VectorId::HFScalePhiBins, p.hfScalePhiBins);
+    binary.addVector(processorsContext, VectorId::HFScaleFactors, p.hfScaleFactors);
+    binary.addVector(processorsContext, VectorId::HCalFBLUTUpper, p.hcalFBLUTUpper);
+    binary.addVector(processorsContext, VectorId::HCalFBLUTLower, p.hcalFBLUTLower);
+    binary.addVector(processorsContext, VectorId::TowerLsbSum, std::vector<double>{p.towerLsbSum});
+
+    addCaloLUT(SectionType::ECALLUT, processorsContext, Side::Minus, 0);
+    addCaloLUT(SectionType::ECALLUT, processorsContext, Side::Plus, 0);
+    addCaloLUT(SectionType::HCALLUT, processorsContext, Side::Minus, 0);
+    addCaloLUT(SectionType::HCALLUT, processorsContext, Side::Plus, 0);
+    if ( p.firmwareVersion > 1 ) {
+      binary.addSecondStageLUT(processorsContext, p.secondStageLUT);
+    }
+    addHFLUT(processorsContext, Side::Minus, 0);
+    addHFLUT(processorsContext, Side::Plus, 0);
+    binary.addHCALFBLUT(processorsContext, Side::Minus, luts_.hcalFBLUT);
+    binary.addHCALFBLUT(processorsContext, Side::Plus, luts_.hcalFBLUT);
+    binary.addChecksum(processorsContext, processorsChecksum());
+
+    for(const auto& card : cards_) {
+      const uint32_t context = cardContext(card.card);
+      for(const auto& param : card.params) {
+        const std::string& id = param.first;
+        const LUTTableKey& key = param.second;
+        const Side side = ( id.size() > 4 && id.compare(id.size()-4, 4, "Plus") == 0 ) ? Side::Plus : Side::Minus;
+        if ( key.kind == LUTKind::ECAL ) {
+          addCaloLUT(SectionType::ECALLUT, context, side, key.index);
+        }
+        else if ( key.kind == LUTKind::HCAL ) {
+          addCaloLUT(SectionType::HCALLUT, context, side, key.index);
+        }
+        else if ( key.kind == LUTKind::HF ) {
+          addHFLUT(context, side, key.index);
+        }
+      }
+      binary.addChecksum(context, checksum(card));
+    }
+
+    if ( !binary.write(fileName) ) {
+      edm::LogError("L1TCaloLayer1LUTWriter") << "Failed to write binary LUT file " << fileName << ": " << binary.error();
+      return false;
+    }
+    return true;
+  }
+
+}
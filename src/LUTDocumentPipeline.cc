@@ -0,0 +1,262 @@
+// LUTDocument::writeXML (xmlTextWriter or SWATCHXMLEmitter) streamed through a tbb::parallel_pipeline:
+//   plan    serial in order, hands out the document one step at a time
+//   format  parallel, renders the rows of a table chunk from the LUTStore
+//   hash    serial in order, feeds the chunks to the context digests
+//   write   serial in order, the only stage touching the writer or emitter
+// The pipeline keeps at most 'depth' steps alive, so the producer stalls
+// when the writer falls behind and memory stays at depth chunks however
+// large the document.  Tables are not cached in this mode, a table used
+// by several contexts is formatted again for each of them.
+
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTDocument.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+#include "tbb/parallel_pipeline.h"
+#include "tbb/task_arena.h"
+
+namespace {
+
+  using namespace calol1;
+
+  struct Step {
+    enum class Kind { Write, Rows, Checksum };
+    explicit Step(Kind k) : kind(k) {}
+    Kind kind;
+    // Write: XML that is not a table, run by the write stage
+    std::function<bool()> write;
+    // The hash stage starts new digests here
+    bool startContext{false};
+    // Extra bytes hashed in order (second stage LUT)
+    const void * hashData{nullptr};
+    size_t hashSize{0};
+    // Rows: chunk [first, last) of a table of nRows rows
+    std::string id;
+    LUTTableKey key{LUTKind::ECAL, 0, 0};
+    uint32_t first{0}, last{0}, nRows{0};
+    // Delta context table: the rows written, the chunk is hashed whole
+    const std::vector<uint32_t> * delta{nullptr};
+    // Checksum: the card context it closes, nullptr for processors
+    const CardContext * context{nullptr};
+
+    // Filled by the format and hash stages, released once written
+    RenderedTable rows;
+    std::vector<std::string> digests;
+  };
+
+  uint32_t tableRows(LUTKind kind)
+  {
+    switch ( kind ) {
+      case LUTKind::HF: return hfTableRows;
+      case LUTKind::HCALFB: return 1;
+      default: return caloTableRows;
+    }
+  }
+
+}
+
+namespace calol1 {
+
+  void
+  LUTDocument::renderRows(const LUTTableKey& key, uint32_t first, uint32_t last, RenderedTable& table) const
+  {
+    const uint16_t * words{nullptr};
+    if ( key.kind == LUTKind::ECAL ) words = store_.ecal(key.index);
+    else if ( key.kind == LUTKind::HCAL ) words = store_.hcal(key.index);
+    else if ( key.kind == LUTKind::HF ) words = store_.hf(key.index);
+
+    if ( words != nullptr ) {
+      if ( key.kind == LUTKind::HF ) renderHFRows(words, first, last, table);
+      else renderCaloRows(words, first, last, table);
+      return;
+    }
+
+    // HCAL FB, or words the store cannot hold: slice the whole table
+    RenderedTable whole;
+    renderTable(key, whole);
+    const size_t rowPayload = whole.payload.size()/whole.nRows();
+    table.columns = whole.columns;
+    table.types = whole.types;
+    table.clear();
+    for(uint32_t i=first; i<last; ++i) table.addRow(whole.row(i));
+    table.payload.assign(whole.payload.begin() + first*rowPayload, whole.payload.begin() + last*rowPayload);
+  }
+
+  bool
+  LUTDocument::writeXML(xmlTextWriterPtr writer, int numberOfThreads, unsigned int chunkRows, unsigned int depth)
+  {
+    XMLOutput out;
+    out.writer = writer;
+    return streamXML(out, numberOfThreads, chunkRows, depth);
+  }
+
+  bool
+  LUTDocument::writeXML(SWATCHXMLEmitter& emitter, int numberOfThreads, unsigned int chunkRows, unsigned int depth)
+  {
+    XMLOutput out;
+    out.emitter = &emitter;
+    return streamXML(out, numberOfThreads, chunkRows, depth);
+  }
+
+  bool
+  LUTDocument::streamXML(XMLOutput& out, int numberOfThreads, unsigned int chunkRows, unsigned int depth)
+  {
+    computeDeltaRows();
+    ProcessorsChecksums processors;
+    ContextChecksums contexts;
+    if ( !streamDocument(out, numberOfThreads, chunkRows, depth, processors, contexts) ) return false;
+    // Kept for writeBinary and the callers, as if computed by prepare()
+    for(auto& digest : processors) processorsChecksums_[digest.first] = std::move(digest.second);
+    for(auto& digest : contexts) contextChecksums_[digest.first] = std::move(digest.second);
+    return true;
+  }
+
+  bool
+  LUTDocument::streamDocument(XMLOutput& out, int numberOfThreads, unsigned int chunkRows, unsigned int depth,
+                              ProcessorsChecksums& processors, ContextChecksums& contexts) const
+  {
+    chunkRows = std::max(1u, chunkRows);
+    depth = std::max(1u, depth);
+    const int firmwareVersion = parameters_.firmwareVersion;
+
+    // The whole document as steps, nothing rendered yet
+    std::vector<Step> plan;
+    auto addWrite = [&plan](std::function<bool()> action, bool startContext=false) {
+      Step step(Step::Kind::Write);
+      step.write = std::move(action);
+      step.startContext = startContext;
+      plan.push_back(std::move(step));
+    };
+    auto addTable = [&plan, chunkRows](const std::string& id, const LUTTableKey& key, const std::vector<uint32_t> * delta = nullptr) {
+      const uint32_t nRows = tableRows(key.kind);
+      for(uint32_t first=0; first<nRows; first+=chunkRows) {
+        Step step(Step::Kind::Rows);
+        step.id = id;
+        step.key = key;
+        step.first = first;
+        step.last = std::min(nRows, first+chunkRows);
+        step.nRows = nRows;
+        step.delta = delta;
+        plan.push_back(std::move(step));
+      }
+    };
+    auto addChecksum = [&plan](const CardContext * context) {
+      Step step(Step::Kind::Checksum);
+      step.context = context;
+      plan.push_back(std::move(step));
+    };
+
+    addWrite([this, &out]() { return startAlgo(out); });
+
+    // Same order as writeProcessorsContext
+    addWrite([this, &out]() { return writeProcessorsHeader(out); }, true);
+    addTable("ECALLUTMinus", {LUTKind::ECAL, 0, firmwareVersion});
+    addTable("ECALLUTPlus", {LUTKind::ECAL, 0, firmwareVersion});
+    addTable("HCALLUTMinus", {LUTKind::HCAL, 0, firmwareVersion});
+    addTable("HCALLUTPlus", {LUTKind::HCAL, 0, firmwareVersion});
+    addWrite([this, &out]() { return writeSecondStageLUT(out); });
+    if ( firmwareVersion > 1 ) {
+      plan.back().hashData = parameters_.secondStageLUT.data();
+      plan.back().hashSize = parameters_.secondStageLUT.size()*sizeof(uint32_t);
+    }
+    addTable("HFLUTMinus", {LUTKind::HF, 0, firmwareVersion});
+    addTable("HFLUTPlus", {LUTKind::HF, 0, firmwareVersion});
+    addTable("HCALFBLUTMinus", {LUTKind::HCALFB, 0, firmwareVersion});
+    addTable("HCALFBLUTPlus", {LUTKind::HCALFB, 0, firmwareVersion});
+    addChecksum(nullptr);
+
+    for(const auto& context : cards_) {
+      addWrite([this, &out, &context]() { return startContext(out, context.id); }, true);
+      for(const auto& param : context.params) addTable(param.first, param.second, deltaRows(param.second));
+      addChecksum(&context);
+    }
+
+    addWrite([this, &out]() { return endAlgo(out); });
+
+    std::vector<ChecksumAlgorithm> algorithms{ChecksumAlgorithm::MD5};
+    for(ChecksumAlgorithm algorithm : extraChecksums_) {
+      if ( std::find(algorithms.begin(), algorithms.end(), algorithm) == algorithms.end() ) algorithms.push_back(algorithm);
+    }
+
+    size_t next{0};
+    // Written by the write stage, read by the plan stage to stop early
+    std::atomic<bool> ok{true};
+    std::vector<std::unique_ptr<LUTChecksum>> digests;
+
+    auto plan_stage = [&](tbb::flow_control& control) -> Step * {
+      if ( next == plan.size() || !ok ) {
+        control.stop();
+        return nullptr;
+      }
+      return &plan[next++];
+    };
+
+    auto format_stage = [this](Step * step) -> Step * {
+      LUTMetrics::Timer timer(step->kind == Step::Kind::Rows ? metrics_ : nullptr, "format chunks");
+      if ( step->kind == Step::Kind::Rows ) renderRows(step->key, step->first, step->last, step->rows);
+      return step;
+    };
+
+    auto hash_stage = [&](Step * step) -> Step * {
+      LUTMetrics::Timer timer(metrics_, "hash");
+      if ( step->startContext ) {
+        digests.clear();
+        for(ChecksumAlgorithm algorithm : algorithms) digests.push_back(std::make_unique<LUTChecksum>(algorithm));
+      }
+      for(auto& digest : digests) {
+        if ( step->kind == Step::Kind::Rows ) digest->update(step->rows.payload.data(), step->rows.payload.size());
+        if ( step->hashSize > 0 ) digest->update(step->hashData, step->hashSize);
+        if ( step->kind == Step::Kind::Checksum ) step->digests.push_back(digest->digest());
+      }
+      return step;
+    };
+
+    auto write_stage = [&](Step * step) {
+      if ( !ok ) return;
+      switch ( step->kind ) {
+        case Step::Kind::Write:
+          ok = step->write();
+          break;
+        case Step::Kind::Rows: {
+          LUTMetrics::Timer timer(metrics_, tableStage(step->id));
+          ok = ( step->first > 0 || writeTableStart(out, step->id, step->rows, step->delta != nullptr) )
+            && writeTableRows(out, step->rows, step->delta, step->first)
+            && ( step->last < step->nRows || writeTableEnd(out) );
+          break;
+        }
+        case Step::Kind::Checksum:
+          for(size_t i=0; i<algorithms.size(); ++i) {
+            if ( step->context == nullptr ) processors[algorithms[i]] = step->digests[i];
+            else contexts[{step->context->card, algorithms[i]}] = step->digests[i];
+          }
+          if ( step->context == nullptr ) {
+            ok = writeXMLParam(out, "md5checksum", "string", processors[ChecksumAlgorithm::MD5])
+              && writeExtraChecksums(out, [&processors](ChecksumAlgorithm algorithm) -> const std::string& { return processors[algorithm]; });
+          }
+          else {
+            const uint32_t card = step->context->card;
+            ok = writeXMLParam(out, "md5checksum", "string", contexts[{card, ChecksumAlgorithm::MD5}])
+              && writeExtraChecksums(out, [&contexts, card](ChecksumAlgorithm algorithm) -> const std::string& { return contexts[{card, algorithm}]; });
+          }
+          ok = ok && endContext(out);
+          break;
+      }
+      // Done with this chunk
+      step->rows = RenderedTable();
+    };
+
+    tbb::task_arena arena(numberOfThreads > 0 ? numberOfThreads : static_cast<int>(tbb::task_arena::automatic));
+    arena.execute([&]() {
+      tbb::parallel_pipeline(depth,
+        tbb::make_filter<void, Step *>(tbb::filter_mode::serial_in_order, plan_stage) &
+        tbb::make_filter<Step *, Step *>(tbb::filter_mode::parallel, format_stage) &
+        tbb::make_filter<Step *, Step *>(tbb::filter_mode::serial_in_order, hash_stage) &
+        tbb::make_filter<Step *, void>(tbb::filter_mode::serial_in_order, write_stage));
+    });
+
+    return ok;
+  }
+
+}
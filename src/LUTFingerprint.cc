@@ -0,0 +1,105 @@
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTFingerprint.h"
+
+#include <fstream>
+#include <sstream>
+
+namespace calol1 {
+
+  LUTFingerprint::LUTFingerprint()
+  {
+    // Bump when the meaning of the inputs changes
+    add(std::string("calol1 LUT fingerprint v2"));
+  }
+
+  void
+  LUTFingerprint::add(const LUTParameters& parameters)
+  {
+    addVector(parameters.ecalScaleETBins);
+    addVector(parameters.ecalScalePhiBins);
+    addVector(parameters.ecalScaleFactors);
+    addVector(parameters.hcalScaleETBins);
+    addVector(parameters.hcalScalePhiBins);
+    addVector(parameters.hcalScaleFactors);
+    addVector(parameters.hfScaleETBins);
+    addVector(parameters.hfScalePhiBins);
+    addVector(parameters.hfScaleFactors);
+    addVector(parameters.hcalFBLUTUpper);
+    addVector(parameters.hcalFBLUTLower);
+    addVector(parameters.secondStageLUT);
+    add(&parameters.towerLsbSum, 1);
+    add(static_cast<int64_t>(parameters.useLSB));
+    add(static_cast<int64_t>(parameters.useCalib));
+    add(static_cast<int64_t>(parameters.useECALLUT));
+    add(static_cast<int64_t>(parameters.useHCALLUT));
+    add(static_cast<int64_t>(parameters.useHFLUT));
+    add(static_cast<int64_t>(parameters.useHCALFBLUT));
+    add(static_cast<int64_t>(parameters.firmwareVersion));
+  }
+
+  void
+  LUTFingerprint::add(const std::string& text)
+  {
+    add(static_cast<int64_t>(text.size()));
+    digest_.update(text.data(), text.size());
+  }
+
+  void
+  LUTFingerprint::add(const double * values, size_t size)
+  {
+    add(static_cast<int64_t>(size));
+    digest_.update(values, size*sizeof(double));
+  }
+
+  void
+  LUTFingerprint::add(int64_t value)
+  {
+    digest_.update(&value, sizeof(value));
+  }
+
+  void
+  LUTFingerprint::add(const std::vector<CaloLUT>& luts)
+  {
+    addVector(luts);
+  }
+
+  void
+  LUTFingerprint::add(const std::vector<HFLUT>& luts)
+  {
+    addVector(luts);
+  }
+
+  std::string
+  LUTFingerprint::digest()
+  {
+    return digest_.digest();
+  }
+
+  bool
+  LUTSidecar::read(const std::string& fileName)
+  {
+    std::ifstream in(fileName);
+    if ( !std::getline(in, fingerprint) || fingerprint.empty() ) return false;
+    checksums.clear();
+    std::string line;
+    while ( std::getline(in, line) ) {
+      std::istringstream fields(line);
+      std::string id, checksum;
+      if ( !(fields >> id >> checksum) ) return false;
+      checksums.push_back({id, checksum});
+    }
+    return true;
+  }
+
+  bool
+  LUTSidecar::write(const std::string& fileName) const
+  {
+    std::ofstream out(fileName, std::ios::trunc);
+    out << fingerprint << "\n";
+    for(const auto& checksum : checksums) {
+      out << checksum.first << " " << checksum.second << "\n";
+    }
+    out.close();
+    return static_cast<bool>(out);
+  }
+
+}
@@ -0,0 +1,44 @@
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTManifest.h"
+
+#include <fstream>
+
+namespace {
+
+  std::string quoted(const std::string& text)
+  {
+    std::string out{"\""};
+    for(char c : text) {
+      if ( c == '"' || c == '\\' ) out.push_back('\\');
+      out.push_back(c);
+    }
+    out.push_back('"');
+    return out;
+  }
+
+}
+
+namespace calol1 {
+
+  bool
+  LUTManifest::write(const std::string& fileName) const
+  {
+    std::ofstream out(fileName, std::ios::trunc);
+    out << "{\"files\": [";
+    for(size_t i=0; i<entries_.size(); ++i) {
+      const Entry& entry = entries_[i];
+      out << (i > 0 ? "," : "") << "\n  {\"file\": " << quoted(entry.fileName) << ", \"runs\": [";
+      for(size_t j=0; j<entry.runs.size(); ++j) {
+        out << (j > 0 ? ", " : "") << entry.runs[j];
+      }
+      out << "],\n   \"checksums\": {";
+      for(size_t j=0; j<entry.checksums.size(); ++j) {
+        out << (j > 0 ? ", " : "") << quoted(entry.checksums[j].first) << ": " << quoted(entry.checksums[j].second);
+      }
+      out << "}}";
+    }
+    out << "\n]}\n";
+    out.close();
+    return static_cast<bool>(out);
+  }
+
+}
@@ -0,0 +1,82 @@
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTMetrics.h"
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace calol1 {
+
+  void
+  LUTMetrics::addTime(const char * stage, double ms)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for(auto& entry : stages_) {
+      if ( entry.name == stage ) {
+        ++entry.calls;
+        entry.ms += ms;
+        return;
+      }
+    }
+    stages_.push_back({stage, 1, ms});
+  }
+
+  void
+  LUTMetrics::count(const char * counter, uint64_t n)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for(auto& entry : counters_) {
+      if ( entry.name == counter ) {
+        entry.value += n;
+        return;
+      }
+    }
+    counters_.push_back({counter, n});
+  }
+
+  std::string
+  LUTMetrics::summary() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2);
+    out << std::left << std::setw(24) << "stage" << std::right << std::setw(8) << "calls"
+        << std::setw(12) << "total ms" << std::setw(12) << "mean ms" << "\n";
+    for(const auto& stage : stages_) {
+      out << std::left << std::setw(24) << stage.name << std::right << std::setw(8) << stage.calls
+          << std::setw(12) << stage.ms << std::setw(12) << stage.ms/stage.calls << "\n";
+    }
+    for(const auto& counter : counters_) {
+      out << std::left << std::setw(24) << counter.name << std::right << std::setw(8) << counter.value << "\n";
+    }
+    return out.str();
+  }
+
+  bool
+  LUTMetrics::writeJSON(const std::string& fileName) const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::ofstream out(fileName, std::ios::trunc);
+    out << std::fixed << std::setprecision(3);
+    out << "{\"stages\": {";
+    for(size_t i=0; i<stages_.size(); ++i) {
+      out << (i > 0 ? "," : "") << "\n  \"" << stages_[i].name << "\": {\"calls\": " << stages_[i].calls
+          << ", \"ms\": " << stages_[i].ms << "}";
+    }
+    out << "\n },\n \"counters\": {";
+    for(size_t i=0; i<counters_.size(); ++i) {
+      out << (i > 0 ? "," : "") << "\n  \"" << counters_[i].name << "\": " << counters_[i].value;
+    }
+    out << "\n }}\n";
+    out.close();
+    return static_cast<bool>(out);
+  }
+
+  void
+  LUTMetrics::clear()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stages_.clear();
+    counters_.clear();
+  }
+
+}
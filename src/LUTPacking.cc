@@ -0,0 +1,385 @@
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTPacking.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CALOL1_PACK_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+  using namespace calol1;
+
+  constexpr uint32_t caloColumns = 28;
+  constexpr uint32_t hfColumns = 12;
+
+  template<int FirmwareVersion>
+  bool packCaloScalar(const CaloLUT& lut, uint16_t * words)
+  {
+    uint32_t overflow{0};
+    for(uint32_t iEta=0; iEta<caloColumns; ++iEta) {
+      for(uint32_t fb=0; fb<2; ++fb) {
+        const uint32_t * in = lut[iEta][fb].data();
+        uint16_t * out = words + (fb << 8)*caloColumns + iEta;
+        for(uint32_t input=0; input<256; ++input) {
+          uint32_t word = caloLUTWord<FirmwareVersion>(in[input]);
+          overflow |= word;
+          out[input*caloColumns] = word;
+        }
+      }
+    }
+    return (overflow >> 16) == 0;
+  }
+
+  template<int FirmwareVersion>
+  bool packHFScalar(const HFLUT& lut, uint16_t * words)
+  {
+    uint32_t overflow{0};
+    for(uint32_t fb=0; fb<4; ++fb) {
+      for(uint32_t hfEta=0; hfEta<hfColumns; ++hfEta) {
+        const uint32_t * in = lut[hfEta].data();
+        uint16_t * out = words + (fb << 8)*hfColumns + hfEta;
+        for(uint32_t input=0; input<256; ++input) {
+          uint32_t word = hfLUTWord<FirmwareVersion>(in[input], fb);
+          overflow |= word;
+          out[input*hfColumns] = word;
+        }
+      }
+    }
+    return (overflow >> 16) == 0;
+  }
+
+  void differingRowsScalar(const uint16_t * a, const uint16_t * b, uint32_t nRows, uint32_t columns, std::vector<uint32_t>& rows)
+  {
+    for(uint32_t row=0; row<nRows; ++row, a+=columns, b+=columns) {
+      for(uint32_t column=0; column<columns; ++column) {
+        if ( a[column] != b[column] ) {
+          rows.push_back(row);
+          break;
+        }
+      }
+    }
+  }
+
+#ifdef CALOL1_PACK_X86
+
+  __attribute__((target("sse4.1"))) void differingRowsSSE41(const uint16_t * a, const uint16_t * b, uint32_t nRows, uint32_t columns, std::vector<uint32_t>& rows)
+  {
+    const size_t n = size_t(nRows)*columns;
+    size_t i = 0;
+    // Row of i and where it ends, kept up to date without a division
+    uint32_t row = 0;
+    size_t rowEnd = columns;
+    while ( i < n ) {
+      // 8 words at a time across rows, the rest word by word
+      size_t word = n;
+      if ( i+8 <= n ) {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a+i));
+        const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b+i));
+        const uint32_t diff = ~static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi16(x, y))) & 0xffff;
+        if ( diff == 0 ) {
+          i += 8;
+          continue;
+        }
+        word = i + __builtin_ctz(diff)/2;
+      }
+      else {
+        for(; i<n && word==n; ++i) {
+          if ( a[i] != b[i] ) word = i;
+        }
+        if ( word == n ) break;
+      }
+      while ( word >= rowEnd ) {
+        rowEnd += columns;
+        ++row;
+      }
+      rows.push_back(row);
+      // Nothing more to learn about this row
+      i = rowEnd;
+      rowEnd += columns;
+      ++row;
+    }
+  }
+
+  __attribute__((target("avx2"))) void differingRowsAVX2(const uint16_t * a, const uint16_t * b, uint32_t nRows, uint32_t columns, std::vector<uint32_t>& rows)
+  {
+    const size_t n = size_t(nRows)*columns;
+    size_t i = 0;
+    // Row of i and where it ends, kept up to date without a division
+    uint32_t row = 0;
+    size_t rowEnd = columns;
+    while ( i < n ) {
+      // 16 words at a time across rows, the rest word by word
+      size_t word = n;
+      if ( i+16 <= n ) {
+        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a+i));
+        const __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b+i));
+        const uint32_t diff = ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi16(x, y)));
+        if ( diff == 0 ) {
+          i += 16;
+          continue;
+        }
+        word = i + __builtin_ctz(diff)/2;
+      }
+      else {
+        for(; i<n && word==n; ++i) {
+          if ( a[i] != b[i] ) word = i;
+        }
+        if ( word == n ) break;
+      }
+      while ( word >= rowEnd ) {
+        rowEnd += columns;
+        ++row;
+      }
+      rows.push_back(row);
+      // Nothing more to learn about this row
+      i = rowEnd;
+      rowEnd += columns;
+      ++row;
+    }
+  }
+
+  // Bits From..From+width of v moved to To, everything else cleared
+  template<uint32_t From, uint32_t To, uint32_t Mask>
+  __attribute__((target("sse4.1"))) inline __m128i moveField(__m128i v)
+  {
+    __m128i shifted;
+    if constexpr ( To >= From ) shifted = _mm_slli_epi32(v, To-From);
+    else shifted = _mm_srli_epi32(v, From-To);
+    return _mm_and_si128(shifted, _mm_set1_epi32(Mask << To));
+  }
+
+  template<uint32_t From, uint32_t To, uint32_t Mask>
+  __attribute__((target("avx2"))) inline __m256i moveField(__m256i v)
+  {
+    __m256i shifted;
+    if constexpr ( To >= From ) shifted = _mm256_slli_epi32(v, To-From);
+    else shifted = _mm256_srli_epi32(v, From-To);
+    return _mm256_and_si256(shifted, _mm256_set1_epi32(Mask << To));
+  }
+
+  // Vector versions of caloLUTWord<FirmwareVersion>
+  template<int FirmwareVersion>
+  __attribute__((target("sse4.1"))) inline __m128i caloWords(__m128i v)
+  {
+    constexpr FirmwareLayout layout = firmwareLayout(FirmwareVersion);
+    if constexpr ( layout.caloPassThrough ) {
+      return v;
+    }
+    else {
+      __m128i w = _mm_and_si128(v, _mm_set1_epi32(layout.etMask));
+      w = _mm_or_si128(w, moveField<fetchlayout::log2Shift, layout.log2Shift, fetchlayout::log2Mask>(v));
+      w = _mm_or_si128(w, moveField<fetchlayout::zeroFlagShift, layout.zeroFlagShift, 1>(v));
+      w = _mm_or_si128(w, moveField<fetchlayout::fgShift, layout.fgShift, 1>(v));
+      return w;
+    }
+  }
+
+  template<int FirmwareVersion>
+  __attribute__((target("avx2"))) inline __m256i caloWords(__m256i v)
+  {
+    constexpr FirmwareLayout layout = firmwareLayout(FirmwareVersion);
+    if constexpr ( layout.caloPassThrough ) {
+      return v;
+    }
+    else {
+      __m256i w = _mm256_and_si256(v, _mm256_set1_epi32(layout.etMask));
+      w = _mm256_or_si256(w, moveField<fetchlayout::log2Shift, layout.log2Shift, fetchlayout::log2Mask>(v));
+      w = _mm256_or_si256(w, moveField<fetchlayout::zeroFlagShift, layout.zeroFlagShift, 1>(v));
+      w = _mm256_or_si256(w, moveField<fetchlayout::fgShift, layout.fgShift, 1>(v));
+      return w;
+    }
+  }
+
+  // 8 words to 16 bits (high halves are checked separately), then into rows
+  __attribute__((target("sse4.1"))) inline void storeColumn(__m128i a, __m128i b, uint16_t * out, uint32_t stride)
+  {
+    const __m128i low = _mm_set1_epi32(0xffff);
+    alignas(16) uint16_t narrow[8];
+    _mm_store_si128(reinterpret_cast<__m128i *>(narrow), _mm_packus_epi32(_mm_and_si128(a, low), _mm_and_si128(b, low)));
+    for(uint32_t k=0; k<8; ++k) out[k*stride] = narrow[k];
+  }
+
+  // Same for 16 words; packus works per 128 bit lane, permute restores the order
+  __attribute__((target("avx2"))) inline void storeColumn(__m256i a, __m256i b, uint16_t * out, uint32_t stride)
+  {
+    const __m256i low = _mm256_set1_epi32(0xffff);
+    __m256i packed = _mm256_packus_epi32(_mm256_and_si256(a, low), _mm256_and_si256(b, low));
+    alignas(32) uint16_t narrow[16];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(narrow), _mm256_permute4x64_epi64(packed, 0xD8));
+    for(uint32_t k=0; k<16; ++k) out[k*stride] = narrow[k];
+  }
+
+  template<int FirmwareVersion>
+  __attribute__((target("sse4.1"))) bool packCaloSSE41(const CaloLUT& lut, uint16_t * words)
+  {
+    __m128i overflow = _mm_setzero_si128();
+    for(uint32_t iEta=0; iEta<caloColumns; ++iEta) {
+      for(uint32_t fb=0; fb<2; ++fb) {
+        const uint32_t * in = lut[iEta][fb].data();
+        uint16_t * out = words + (fb << 8)*caloColumns + iEta;
+        for(uint32_t input=0; input<256; input+=8) {
+          __m128i a = caloWords<FirmwareVersion>(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in+input)));
+          __m128i b = caloWords<FirmwareVersion>(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in+input+4)));
+          overflow = _mm_or_si128(overflow, _mm_or_si128(a, b));
+          storeColumn(a, b, out + input*caloColumns, caloColumns);
+        }
+      }
+    }
+    return _mm_testz_si128(overflow, _mm_set1_epi32(0xffff0000));
+  }
+
+  template<int FirmwareVersion>
+  __attribute__((target("avx2"))) bool packCaloAVX2(const CaloLUT& lut, uint16_t * words)
+  {
+    __m256i overflow = _mm256_setzero_si256();
+    for(uint32_t iEta=0; iEta<caloColumns; ++iEta) {
+      for(uint32_t fb=0; fb<2; ++fb) {
+        const uint32_t * in = lut[iEta][fb].data();
+        uint16_t * out = words + (fb << 8)*caloColumns + iEta;
+        for(uint32_t input=0; input<256; input+=16) {
+          __m256i a = caloWords<FirmwareVersion>(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(in+input)));
+          __m256i b = caloWords<FirmwareVersion>(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(in+input+8)));
+          overflow = _mm256_or_si256(overflow, _mm256_or_si256(a, b));
+          storeColumn(a, b, out + input*caloColumns, caloColumns);
+        }
+      }
+    }
+    return _mm256_testz_si256(overflow, _mm256_set1_epi32(0xffff0000));
+  }
+
+  template<int FirmwareVersion>
+  __attribute__((target("sse4.1"))) bool packHFSSE41(const HFLUT& lut, uint16_t * words)
+  {
+    __m128i overflow = _mm_setzero_si128();
+    for(uint32_t fb=0; fb<4; ++fb) {
+      const __m128i featureBits = _mm_set1_epi32(hfLUTWord<FirmwareVersion>(0, fb));
+      for(uint32_t hfEta=0; hfEta<hfColumns; ++hfEta) {
+        const uint32_t * in = lut[hfEta].data();
+        uint16_t * out = words + (fb << 8)*hfColumns + hfEta;
+        for(uint32_t input=0; input<256; input+=8) {
+          __m128i a = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in+input)), featureBits);
+          __m128i b = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in+input+4)), featureBits);
+          overflow = _mm_or_si128(overflow, _mm_or_si128(a, b));
+          storeColumn(a, b, out + input*hfColumns, hfColumns);
+        }
+      }
+    }
+    return _mm_testz_si128(overflow, _mm_set1_epi32(0xffff0000));
+  }
+
+  template<int FirmwareVersion>
+  __attribute__((target("avx2"))) bool packHFAVX2(const HFLUT& lut, uint16_t * words)
+  {
+    __m256i overflow = _mm256_setzero_si256();
+    for(uint32_t fb=0; fb<4; ++fb) {
+      const __m256i featureBits = _mm256_set1_epi32(hfLUTWord<FirmwareVersion>(0, fb));
+      for(uint32_t hfEta=0; hfEta<hfColumns; ++hfEta) {
+        const uint32_t * in = lut[hfEta].data();
+        uint16_t * out = words + (fb << 8)*hfColumns + hfEta;
+        for(uint32_t input=0; input<256; input+=16) {
+          __m256i a = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(in+input)), featureBits);
+          __m256i b = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(in+input+8)), featureBits);
+          overflow = _mm256_or_si256(overflow, _mm256_or_si256(a, b));
+          storeColumn(a, b, out + input*hfColumns, hfColumns);
+        }
+      }
+    }
+    return _mm256_testz_si256(overflow, _mm256_set1_epi32(0xffff0000));
+  }
+
+#endif
+
+  template<int FirmwareVersion>
+  bool packCalo(const CaloLUT& lut, uint16_t * words, PackKernel kernel)
+  {
+#ifdef CALOL1_PACK_X86
+    if ( kernel == PackKernel::AVX2 ) return packCaloAVX2<FirmwareVersion>(lut, words);
+    if ( kernel == PackKernel::SSE41 ) return packCaloSSE41<FirmwareVersion>(lut, words);
+#endif
+    return packCaloScalar<FirmwareVersion>(lut, words);
+  }
+
+  template<int FirmwareVersion>
+  bool packHF(const HFLUT& lut, uint16_t * words, PackKernel kernel)
+  {
+#ifdef CALOL1_PACK_X86
+    if ( kernel == PackKernel::AVX2 ) return packHFAVX2<FirmwareVersion>(lut, words);
+    if ( kernel == PackKernel::SSE41 ) return packHFSSE41<FirmwareVersion>(lut, words);
+#endif
+    return packHFScalar<FirmwareVersion>(lut, words);
+  }
+
+}
+
+namespace calol1 {
+
+  bool
+  packKernelSupported(PackKernel kernel)
+  {
+    switch ( kernel ) {
+      case PackKernel::Scalar:
+        return true;
+#ifdef CALOL1_PACK_X86
+      case PackKernel::SSE41:
+        return __builtin_cpu_supports("sse4.1");
+      case PackKernel::AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+      default:
+        return false;
+    }
+  }
+
+  PackKernel
+  bestPackKernel()
+  {
+    static const PackKernel best = packKernelSupported(PackKernel::AVX2) ? PackKernel::AVX2 :
+                                   packKernelSupported(PackKernel::SSE41) ? PackKernel::SSE41 : PackKernel::Scalar;
+    return best;
+  }
+
+  const char *
+  packKernelName(PackKernel kernel)
+  {
+    switch ( kernel ) {
+      case PackKernel::SSE41: return "sse4.1";
+      case PackKernel::AVX2: return "avx2";
+      default: return "scalar";
+    }
+  }
+
+  void
+  differingRows(const uint16_t * a, const uint16_t * b, uint32_t nRows, uint32_t columns, std::vector<uint32_t>& rows, PackKernel kernel)
+  {
+    rows.clear();
+    if ( !packKernelSupported(kernel) ) kernel = PackKernel::Scalar;
+#ifdef CALOL1_PACK_X86
+    if ( kernel == PackKernel::AVX2 ) return differingRowsAVX2(a, b, nRows, columns, rows);
+    if ( kernel == PackKernel::SSE41 ) return differingRowsSSE41(a, b, nRows, columns, rows);
+#endif
+    differingRowsScalar(a, b, nRows, columns, rows);
+  }
+
+  bool
+  packCaloLUT(const CaloLUT& lut, int firmwareVersion, uint16_t * words, PackKernel kernel)
+  {
+    if ( !packKernelSupported(kernel) ) kernel = PackKernel::Scalar;
+    switch ( layoutVersion(firmwareVersion) ) {
+      case 1: return packCalo<1>(lut, words, kernel);
+      case 2: return packCalo<2>(lut, words, kernel);
+      default: return packCalo<3>(lut, words, kernel);
+    }
+  }
+
+  bool
+  packHFLUT(const HFLUT& lut, int firmwareVersion, uint16_t * words, PackKernel kernel)
+  {
+    if ( !packKernelSupported(kernel) ) kernel = PackKernel::Scalar;
+    switch ( layoutVersion(firmwareVersion) ) {
+      case 1: return packHF<1>(lut, words, kernel);
+      case 2: return packHF<2>(lut, words, kernel);
+      default: return packHF<3>(lut, words, kernel);
+    }
+  }
+
+}
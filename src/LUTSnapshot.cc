@@ -0,0 +1,313 @@
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTSnapshot.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTBinaryFormat.h"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <type_traits>
+
+#include <zstd.h>
+
+namespace {
+
+  using calol1::lutfile::appendLE;
+  using calol1::lutfile::readLE;
+
+  // -41..-1 then 1..41, as HcalScaleTable writes them
+  template<typename F>
+  void forEachTower(F&& body)
+  {
+    using namespace calol1::hcalscale;
+    for(int iEta=-maxEta; iEta<=maxEta; ++iEta) {
+      if ( iEta == 0 ) continue;
+      for(uint32_t iPhi=1; iPhi<=nPhi; ++iPhi) body(iEta, iPhi);
+    }
+  }
+
+  template<typename T>
+  void appendVector(std::vector<unsigned char>& out, const std::vector<T>& vect)
+  {
+    appendLE(out, static_cast<uint32_t>(vect.size()));
+    for(const auto& value : vect) appendLE(out, value);
+  }
+
+  void appendVector(std::vector<unsigned char>& out, const std::vector<int>& vect)
+  {
+    appendLE(out, static_cast<uint32_t>(vect.size()));
+    for(int value : vect) appendLE(out, static_cast<uint32_t>(value));
+  }
+
+  template<typename Table>
+  void appendTables(std::vector<unsigned char>& out, const std::vector<Table>& tables)
+  {
+    constexpr size_t size = sizeof(Table)/sizeof(uint32_t);
+    appendLE(out, static_cast<uint32_t>(tables.size()));
+    for(const auto& table : tables) {
+      // Contiguous, see FirmwareLayout.h
+      const uint32_t * words = reinterpret_cast<const uint32_t *>(&table);
+      for(size_t i=0; i<size; ++i) appendLE(out, words[i]);
+    }
+  }
+
+  // Bounds checked reads of the decompressed body
+  class Reader {
+  public:
+    Reader(const std::vector<unsigned char>& data) : data_(data) {}
+    bool ok() const { return ok_; }
+    bool atEnd() const { return pos_ == data_.size(); }
+
+    template<typename T>
+    T get() {
+      if ( !ok_ || data_.size()-pos_ < sizeof(T) ) {
+        ok_ = false;
+        return T{0};
+      }
+      T value = readLE<T>(&data_[pos_]);
+      pos_ += sizeof(T);
+      return value;
+    }
+    double getDouble() {
+      uint64_t bits = get<uint64_t>();
+      double value;
+      std::memcpy(&value, &bits, sizeof(value));
+      return value;
+    }
+    // A count of elements of elementSize bytes that has to fit in what is left
+    uint32_t count(size_t elementSize) {
+      uint32_t n = get<uint32_t>();
+      if ( ok_ && n > (data_.size()-pos_)/elementSize ) ok_ = false;
+      return ok_ ? n : 0;
+    }
+
+    // int is stored as its two's complement
+    template<typename T>
+    void vector(std::vector<T>& vect) {
+      typedef typename std::conditional<sizeof(T) == 8, uint64_t, uint32_t>::type Stored;
+      vect.resize(count(sizeof(Stored)));
+      for(auto& value : vect) value = static_cast<T>(get<Stored>());
+    }
+    void vector(std::vector<double>& vect) {
+      vect.resize(count(sizeof(double)));
+      for(auto& value : vect) value = getDouble();
+    }
+    std::string string() {
+      std::string s(count(1), '\0');
+      for(auto& c : s) c = static_cast<char>(get<uint8_t>());
+      return s;
+    }
+    template<typename Table>
+    void tables(std::vector<Table>& tables) {
+      constexpr size_t size = sizeof(Table)/sizeof(uint32_t);
+      tables.resize(count(size*sizeof(uint32_t)));
+      for(auto& table : tables) {
+        uint32_t * words = reinterpret_cast<uint32_t *>(&table);
+        for(size_t i=0; i<size; ++i) words[i] = get<uint32_t>();
+      }
+    }
+
+  private:
+    const std::vector<unsigned char>& data_;
+    size_t pos_{0};
+    bool ok_{true};
+  };
+
+}
+
+namespace calol1 {
+
+  using namespace lutsnapshot;
+
+  bool
+  LUTSnapshot::write(const std::string& fileName, uint32_t run, const LUTParameters& parameters, const LUTArrays& luts,
+                     const std::vector<ChecksumAlgorithm>& extraChecksums, const HcalScaleTable& hcalScale,
+                     int compressionLevel, std::string& error)
+  {
+    std::vector<unsigned char> body;
+    body.reserve((luts.ecalLUT.size() + luts.hcalLUT.size())*caloLUTSize*4 + luts.hfLUT.size()*hfLUTSize*4
+                 + (hcalScale.empty() ? 0 : hcalscale::nEta*hcalscale::nPhi*hcalscale::nEt*8) + 4096);
+
+    appendVector(body, parameters.ecalScaleETBins);
+    appendVector(body, parameters.ecalScalePhiBins);
+    appendVector(body, parameters.ecalScaleFactors);
+    appendVector(body, parameters.hcalScaleETBins);
+    appendVector(body, parameters.hcalScalePhiBins);
+    appendVector(body, parameters.hcalScaleFactors);
+    appendVector(body, parameters.hfScaleETBins);
+    appendVector(body, parameters.hfScalePhiBins);
+    appendVector(body, parameters.hfScaleFactors);
+    appendVector(body, parameters.hcalFBLUTUpper);
+    appendVector(body, parameters.hcalFBLUTLower);
+    appendVector(body, parameters.secondStageLUT);
+    appendLE(body, parameters.towerLsbSum);
+    const uint32_t flags = (parameters.useLSB ? 1 : 0) | (parameters.useCalib ? 2 : 0) | (parameters.useECALLUT ? 4 : 0)
+      | (parameters.useHCALLUT ? 8 : 0) | (parameters.useHFLUT ? 16 : 0) | (parameters.useHCALFBLUT ? 32 : 0);
+    appendLE(body, flags);
+    appendLE(body, static_cast<uint32_t>(parameters.firmwareVersion));
+
+    appendLE(body, static_cast<uint32_t>(extraChecksums.size()));
+    for(auto algorithm : extraChecksums) {
+      const std::string name = checksumAlgorithmName(algorithm);
+      appendLE(body, static_cast<uint32_t>(name.size()));
+      body.insert(body.end(), name.begin(), name.end());
+    }
+
+    appendTables(body, luts.ecalLUT);
+    appendTables(body, luts.hcalLUT);
+    appendTables(body, luts.hfLUT);
+    appendVector(body, luts.hcalFBLUT);
+
+    // Towers of a ring mostly decode alike, each distinct scale is kept once
+    std::vector<uint32_t> towerScale;
+    std::vector<const std::string *> scales;
+    std::map<std::string, uint32_t> distinct;
+    if ( !hcalScale.empty() ) {
+      forEachTower([&](int iEta, uint32_t iPhi) {
+        std::string bits(hcalscale::nEt*sizeof(double), '\0');
+        for(uint32_t et=0; et<hcalscale::nEt; ++et) {
+          const double value = hcalScale.value(iEta, iPhi, et);
+          std::memcpy(&bits[et*sizeof(double)], &value, sizeof(double));
+        }
+        auto inserted = distinct.emplace(std::move(bits), static_cast<uint32_t>(scales.size()));
+        if ( inserted.second ) scales.push_back(&inserted.first->first);
+        towerScale.push_back(inserted.first->second);
+      });
+    }
+    appendLE(body, static_cast<uint32_t>(scales.size()));
+    for(const std::string * bits : scales) {
+      for(uint32_t et=0; et<hcalscale::nEt; ++et) {
+        uint64_t word;
+        std::memcpy(&word, bits->data() + et*sizeof(double), sizeof(word));
+        appendLE(body, word);
+      }
+    }
+    for(uint32_t index : towerScale) appendLE(body, index);
+
+    std::vector<unsigned char> out;
+    out.reserve(headerSize + ZSTD_compressBound(body.size()));
+    out.insert(out.end(), magic, magic+sizeof(magic));
+    appendLE(out, formatVersion);
+    appendLE(out, run);
+    appendLE(out, static_cast<uint64_t>(body.size()));
+    out.resize(headerSize + ZSTD_compressBound(body.size()));
+    const size_t compressed = ZSTD_compress(out.data()+headerSize, out.size()-headerSize, body.data(), body.size(),
+                                            compressionLevel != 0 ? compressionLevel : ZSTD_CLEVEL_DEFAULT);
+    if ( ZSTD_isError(compressed) ) {
+      error = std::string("zstd: ") + ZSTD_getErrorName(compressed);
+      return false;
+    }
+    out.resize(headerSize + compressed);
+
+    std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(out.data()), out.size());
+    file.close();
+    if ( !file ) {
+      error = "cannot write " + fileName;
+      return false;
+    }
+    return true;
+  }
+
+  bool
+  LUTSnapshot::read(const std::string& fileName, int numberOfThreads)
+  {
+    std::ifstream file(fileName, std::ios::binary);
+    if ( !file ) {
+      error_ = "cannot open " + fileName;
+      return false;
+    }
+    std::vector<unsigned char> in((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if ( in.size() < headerSize || std::memcmp(in.data(), magic, sizeof(magic)) != 0 ) {
+      error_ = fileName + " is not a LUT snapshot";
+      return false;
+    }
+    if ( readLE<uint32_t>(&in[8]) != formatVersion ) {
+      error_ = fileName + ": unsupported snapshot format version " + std::to_string(readLE<uint32_t>(&in[8]));
+      return false;
+    }
+    run_ = readLE<uint32_t>(&in[12]);
+    const uint64_t bodySize = readLE<uint64_t>(&in[16]);
+    const unsigned long long frameSize = ZSTD_getFrameContentSize(in.data()+headerSize, in.size()-headerSize);
+    if ( frameSize != bodySize ) {
+      error_ = fileName + ": corrupt snapshot body";
+      return false;
+    }
+    std::vector<unsigned char> body(bodySize);
+    const size_t decompressed = ZSTD_decompress(body.data(), body.size(), in.data()+headerSize, in.size()-headerSize);
+    if ( ZSTD_isError(decompressed) || decompressed != bodySize ) {
+      error_ = fileName + ": corrupt snapshot body";
+      return false;
+    }
+    in.clear();
+
+    Reader reader(body);
+    reader.vector(parameters_.ecalScaleETBins);
+    reader.vector(parameters_.ecalScalePhiBins);
+    reader.vector(parameters_.ecalScaleFactors);
+    reader.vector(parameters_.hcalScaleETBins);
+    reader.vector(parameters_.hcalScalePhiBins);
+    reader.vector(parameters_.hcalScaleFactors);
+    reader.vector(parameters_.hfScaleETBins);
+    reader.vector(parameters_.hfScalePhiBins);
+    reader.vector(parameters_.hfScaleFactors);
+    reader.vector(parameters_.hcalFBLUTUpper);
+    reader.vector(parameters_.hcalFBLUTLower);
+    reader.vector(parameters_.secondStageLUT);
+    parameters_.towerLsbSum = reader.getDouble();
+    const uint32_t flags = reader.get<uint32_t>();
+    parameters_.useLSB = flags & 1;
+    parameters_.useCalib = flags & 2;
+    parameters_.useECALLUT = flags & 4;
+    parameters_.useHCALLUT = flags & 8;
+    parameters_.useHFLUT = flags & 16;
+    parameters_.useHCALFBLUT = flags & 32;
+    parameters_.firmwareVersion = static_cast<int32_t>(reader.get<uint32_t>());
+
+    extraChecksums_.clear();
+    for(uint32_t i=0, n=reader.count(4); i<n; ++i) {
+      const std::string name = reader.string();
+      if ( !reader.ok() ) {
+        error_ = fileName + ": truncated or corrupt snapshot";
+        return false;
+      }
+      ChecksumAlgorithm algorithm;
+      if ( !checksumAlgorithmFromName(name, algorithm) ) {
+        error_ = fileName + ": unknown checksum " + name;
+        return false;
+      }
+      extraChecksums_.push_back(algorithm);
+    }
+
+    reader.tables(luts_.ecalLUT);
+    reader.tables(luts_.hcalLUT);
+    reader.tables(luts_.hfLUT);
+    reader.vector(luts_.hcalFBLUT);
+
+    hcalScale_.clear();
+    const uint32_t nScales = reader.count(hcalscale::nEt*sizeof(double));
+    if ( nScales > 0 ) {
+      std::vector<double> scales(size_t(nScales)*hcalscale::nEt);
+      for(auto& value : scales) value = reader.getDouble();
+      std::vector<uint32_t> towerScale(hcalscale::nEta*hcalscale::nPhi);
+      for(auto& index : towerScale) {
+        index = reader.get<uint32_t>();
+        if ( index >= nScales ) index = 0;
+      }
+      if ( reader.ok() ) {
+        // Same tower order as written
+        hcalScale_.fill([&](int iEta, uint32_t iPhi, double * out) {
+          const uint32_t ring = iEta < 0 ? iEta + hcalscale::maxEta : iEta + hcalscale::maxEta - 1;
+          const uint32_t index = towerScale[ring*hcalscale::nPhi + iPhi-1];
+          std::memcpy(out, &scales[size_t(index)*hcalscale::nEt], hcalscale::nEt*sizeof(double));
+        }, numberOfThreads);
+      }
+    }
+
+    if ( !reader.ok() || !reader.atEnd() ) {
+      error_ = fileName + ": truncated or corrupt snapshot";
+      return false;
+    }
+    return true;
+  }
+
+}
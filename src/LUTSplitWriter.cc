@@ -0,0 +1,183 @@
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTSplitWriter.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/CompressedXMLOutput.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTDocument.h"
+
+#include <fstream>
+
+#include "tbb/parallel_for.h"
+#include "tbb/task_arena.h"
+
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+
+namespace {
+
+  std::string quoted(const std::string& text)
+  {
+    std::string out{"\""};
+    for(char c : text) {
+      if ( c == '"' || c == '\\' ) out.push_back('\\');
+      out.push_back(c);
+    }
+    out.push_back('"');
+    return out;
+  }
+
+  // Position of the first dot of the base name, where the suffix goes
+  size_t suffixPosition(const std::string& name)
+  {
+    size_t base = name.rfind('/');
+    base = (base == std::string::npos) ? 0 : base+1;
+    size_t dot = name.find('.', base);
+    return (dot == std::string::npos) ? name.size() : dot;
+  }
+
+  std::string baseName(const std::string& name)
+  {
+    size_t base = name.rfind('/');
+    return (base == std::string::npos) ? name : name.substr(base+1);
+  }
+
+}
+
+namespace calol1 {
+
+  LUTSplitWriter::LUTSplitWriter(const std::string& fileName, const std::string& compression, int level, bool direct) :
+    fileName_(fileName),
+    compression_(compression),
+    level_(level),
+    direct_(direct)
+  {
+  }
+
+  std::string
+  LUTSplitWriter::contextFileName(const std::string& fileName, const std::string& context)
+  {
+    const size_t dot = suffixPosition(fileName);
+    return fileName.substr(0, dot) + "_" + context + fileName.substr(dot);
+  }
+
+  std::string
+  LUTSplitWriter::indexFileName(const std::string& fileName)
+  {
+    return fileName.substr(0, suffixPosition(fileName)) + "_index.json";
+  }
+
+  bool
+  LUTSplitWriter::write(const LUTDocument& document, int numberOfThreads)
+  {
+    if ( !document.prepared() ) {
+      edm::LogError("L1TCaloLayer1LUTWriter") << "LUT document split into " << indexFileName(fileName_) << " before prepare()";
+      return false;
+    }
+    // Checked once here, so that a file failing below is its own error
+    if ( compression_ != "none" && compression_ != "gzip" && compression_ != "zstd" ) {
+      edm::LogError("L1TCaloLayer1LUTWriter") << "Unknown compression '" << compression_ << "' for " << indexFileName(fileName_)
+                                              << ", should be none, gzip or zstd";
+      return false;
+    }
+
+    files_.assign(document.nContexts(), File{});
+    for(size_t i=0; i<files_.size(); ++i) {
+      files_[i].context = document.contextId(i);
+      files_[i].fileName = contextFileName(fileName_, files_[i].context);
+    }
+
+    // One task per file, each with its own writer and digest
+    std::vector<char> written(files_.size(), 0);
+    std::vector<std::string> errors(files_.size());
+    auto writeOne = [&](size_t i) { written[i] = writeFile(document, i, files_[i], errors[i]); };
+    if ( numberOfThreads == 1 ) {
+      for(size_t i=0; i<files_.size(); ++i) writeOne(i);
+    }
+    else {
+      tbb::task_arena arena(numberOfThreads > 0 ? numberOfThreads : static_cast<int>(tbb::task_arena::automatic));
+      arena.execute([&]() { tbb::parallel_for(size_t(0), files_.size(), writeOne); });
+    }
+
+    for(size_t i=0; i<files_.size(); ++i) {
+      if ( !written[i] ) {
+        edm::LogError("L1TCaloLayer1LUTWriter") << "Failed to write " << files_[i].fileName << ": " << errors[i];
+        return false;
+      }
+    }
+
+    if ( !writeIndex() ) {
+      edm::LogError("L1TCaloLayer1LUTWriter") << "Failed to write " << indexFileName(fileName_);
+      return false;
+    }
+    return true;
+  }
+
+  bool
+  LUTSplitWriter::writeFile(const LUTDocument& document, size_t context, File& file, std::string& error) const
+  {
+    bool written;
+    if ( direct_ ) {
+      xmlOutputBufferPtr out = newXMLOutputBuffer(file.fileName, compression_, level_);
+      if ( out == NULL ) {
+        error = "could not open the file";
+        return false;
+      }
+      SWATCHXMLEmitter emitter(out);
+      written = document.writeContextXML(emitter, context);
+      // Flushes and closes the file
+      if ( emitter.close() < 0 && written ) {
+        error = "could not flush and close the file";
+        return false;
+      }
+    }
+    else {
+      xmlTextWriterPtr writer = newXMLTextWriter(file.fileName, compression_, level_);
+      if ( writer == NULL ) {
+        error = "could not open the file";
+        return false;
+      }
+      // Same layout as the single file
+      xmlTextWriterSetIndent(writer, 1);
+      xmlTextWriterSetIndentString(writer, BAD_CAST "  ");
+      written = document.writeContextXML(writer, context);
+      // Flushes and closes the file
+      xmlFreeTextWriter(writer);
+    }
+    if ( !written ) {
+      error = "could not write context " + file.context;
+      return false;
+    }
+
+    file.md5checksum = (context == 0) ? document.processorsChecksum() : document.checksum(document.cardContexts()[context-1]);
+
+    // Digest of the file as it will be shipped
+    std::ifstream in(file.fileName, std::ios::binary);
+    if ( !in ) {
+      error = "could not read the file back for its md5";
+      return false;
+    }
+    LUTChecksum digest(ChecksumAlgorithm::MD5);
+    std::vector<char> buffer(1 << 20);
+    file.bytes = 0;
+    while ( in ) {
+      in.read(buffer.data(), buffer.size());
+      digest.update(buffer.data(), in.gcount());
+      file.bytes += in.gcount();
+    }
+    file.md5 = digest.digest();
+    return true;
+  }
+
+  bool
+  LUTSplitWriter::writeIndex() const
+  {
+    std::ofstream out(indexFileName(fileName_), std::ios::trunc);
+    out << "{\"files\": [";
+    for(size_t i=0; i<files_.size(); ++i) {
+      const File& file = files_[i];
+      out << (i > 0 ? "," : "") << "\n  {\"context\": " << quoted(file.context)
+          << ", \"file\": " << quoted(baseName(file.fileName)) << ", \"bytes\": " << file.bytes
+          << ",\n   \"md5\": " << quoted(file.md5) << ", \"md5checksum\": " << quoted(file.md5checksum) << "}";
+    }
+    out << "\n]}\n";
+    out.close();
+    return static_cast<bool>(out);
+  }
+
+}
@@ -0,0 +1,82 @@
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTStore.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTPacking.h"
+
+#include <sstream>
+
+namespace calol1 {
+
+  LUTStore::Detector::Detector(size_t nTables, size_t tableSize) :
+    nTables(nTables),
+    tableSize(tableSize),
+    // Left uninitialized on purpose, see the class description
+    cells(new uint16_t[nTables*tableSize]),
+    once(new std::once_flag[nTables]),
+    fits(new bool[nTables]())
+  {
+  }
+
+  LUTStore::LUTStore(const LUTArrays& luts, int firmwareVersion) :
+    luts_(luts),
+    firmwareVersion_(firmwareVersion),
+    ecal_(luts.ecalLUT.size(), caloPackedSize),
+    hcal_(luts.hcalLUT.size(), caloPackedSize),
+    hf_(luts.hfLUT.size(), hfPackedSize)
+  {
+  }
+
+  const uint16_t *
+  LUTStore::slot(Detector& detector, uint32_t index) const
+  {
+    std::call_once(detector.once[index], [this, &detector, index]() { pack(detector, index); });
+    return detector.fits[index] ? detector.cells.get() + index*detector.tableSize : nullptr;
+  }
+
+  void
+  LUTStore::pack(Detector& detector, uint32_t index) const
+  {
+    uint16_t * words = detector.cells.get() + index*detector.tableSize;
+    if ( &detector == &ecal_ ) {
+      detector.fits[index] = packCaloLUT(luts_.ecalLUT[index], firmwareVersion_, words);
+    }
+    else if ( &detector == &hcal_ ) {
+      detector.fits[index] = packCaloLUT(luts_.hcalLUT[index], firmwareVersion_, words);
+    }
+    else {
+      detector.fits[index] = packHFLUT(luts_.hfLUT[index], firmwareVersion_, words);
+    }
+    ++detector.materialized;
+  }
+
+  size_t
+  LUTStore::materialized() const
+  {
+    return ecal_.materialized + hcal_.materialized + hf_.materialized;
+  }
+
+  size_t
+  LUTStore::materializedBytes() const
+  {
+    return (ecal_.materialized + hcal_.materialized)*caloPackedSize*sizeof(uint16_t)
+      + hf_.materialized*hfPackedSize*sizeof(uint16_t);
+  }
+
+  size_t
+  LUTStore::nestedBytes() const
+  {
+    return (luts_.ecalLUT.size() + luts_.hcalLUT.size())*sizeof(CaloLUT) + luts_.hfLUT.size()*sizeof(HFLUT);
+  }
+
+  std::string
+  LUTStore::memoryReport() const
+  {
+    std::ostringstream report;
+    report << "LUT store: " << materialized() << " of " << ecal_.nTables + hcal_.nTables + hf_.nTables
+           << " tables materialized (ECAL " << ecal_.materialized << "/" << ecal_.nTables
+           << ", HCAL " << hcal_.materialized << "/" << hcal_.nTables
+           << ", HF " << hf_.materialized << "/" << hf_.nTables << "), "
+           << materializedBytes()/1024 << " kB in 16 bit words vs "
+           << nestedBytes()/1024 << " kB for the nested uint32_t arrays of all phi bins";
+    return report.str();
+  }
+
+}
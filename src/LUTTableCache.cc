@@ -0,0 +1,95 @@
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTTableCache.h"
+
+#include <algorithm>
+
+#include "tbb/parallel_for.h"
+#include "tbb/task_arena.h"
+
+namespace calol1 {
+
+  const RenderedTable&
+  LUTTableCache::get(const LUTTableKey& key)
+  {
+    ++lookups_;
+    return table(key);
+  }
+
+  const RenderedTable&
+  LUTTableCache::table(const LUTTableKey& key)
+  {
+    auto it = tables_.find(key);
+    if ( it == tables_.end() ) {
+      auto rendered = std::make_unique<RenderedTable>();
+      renderer_(key, *rendered);
+      ++renders_;
+      it = tables_.emplace(key, std::move(rendered)).first;
+    }
+    return *(it->second);
+  }
+
+  const RenderedTable *
+  LUTTableCache::find(const LUTTableKey& key) const
+  {
+    auto it = tables_.find(key);
+    return it == tables_.end() ? nullptr : it->second.get();
+  }
+
+  void
+  LUTTableCache::prefetch(const std::vector<LUTTableKey>& keys, int numberOfThreads)
+  {
+    std::vector<LUTTableKey> missing;
+    for(const auto& key : keys) {
+      if ( tables_.count(key) == 0 && std::find(missing.begin(), missing.end(), key) == missing.end() ) {
+        missing.push_back(key);
+      }
+    }
+    // Nothing is touched once everything is cached, see SharedLUTs.h
+    if ( missing.empty() ) return;
+
+    // Render into private slots, the map is only touched from this thread
+    std::vector<std::unique_ptr<RenderedTable>> rendered(missing.size());
+    auto render = [&](size_t i) {
+      rendered[i] = std::make_unique<RenderedTable>();
+      renderer_(missing[i], *rendered[i]);
+    };
+    if ( numberOfThreads == 1 ) {
+      for(size_t i=0; i<missing.size(); ++i) render(i);
+    }
+    else {
+      tbb::task_arena arena(numberOfThreads > 0 ? numberOfThreads : static_cast<int>(tbb::task_arena::automatic));
+      arena.execute([&]() { tbb::parallel_for(size_t(0), missing.size(), render); });
+    }
+
+    for(size_t i=0; i<missing.size(); ++i) {
+      tables_.emplace(missing[i], std::move(rendered[i]));
+    }
+    renders_ += missing.size();
+  }
+
+  const std::string&
+  LUTTableCache::checksum(const std::vector<LUTTableKey>& keys, ChecksumAlgorithm algorithm)
+  {
+    ++checksumLookups_;
+    auto it = checksums_.find({algorithm, keys});
+    if ( it == checksums_.end() ) {
+      LUTChecksum digest(algorithm);
+      for(const auto& key : keys) {
+        const std::vector<unsigned char>& payload = table(key).payload;
+        digest.update(payload.data(), payload.size());
+      }
+      it = checksums_.emplace(std::make_pair(algorithm, keys), digest.digest()).first;
+    }
+    return it->second;
+  }
+
+  void
+  LUTTableCache::clear()
+  {
+    tables_.clear();
+    checksums_.clear();
+    lookups_ = 0;
+    renders_ = 0;
+    checksumLookups_ = 0;
+  }
+
+}
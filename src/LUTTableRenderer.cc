@@ -0,0 +1,151 @@
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTTableRenderer.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/SWATCHFormatter.h"
+
+#include <algorithm>
+#include <memory>
+
+namespace {
+  const char * calo_columns{"Input, 01, 02, 03, 04, 05, 06, 07, 08, 09, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28"};
+  const char * calo_types{"uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint"};
+  const char * hf_columns{"Input, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41"};
+  const char * hf_types{"uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint, uint"};
+  const char * hcalFB_columns{"01, 02, 03, 04, 05, 06, 07, 08, 09, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28"};
+  const char * hcalFB_types{"uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64, uint64"};
+}
+
+namespace calol1 {
+
+  void
+  renderCaloLUT(const CaloLUT& lut, int firmwareVersion, RenderedTable& table)
+  {
+    table.columns = calo_columns;
+    table.types = calo_types;
+    table.clear();
+    table.rows.reserve(2*256*29*8);
+    table.rowStarts.reserve(2*256);
+    table.payload.reserve(2*256*28*sizeof(uint32_t));
+
+    // Heap, rendering may run on a task thread
+    auto words = std::make_unique<CaloLUT>();
+    repackCaloLUT(lut, firmwareVersion, *words);
+
+    SWATCHFormatter formatter;
+    for(uint32_t fb = 0; fb < 2; fb++) {
+      for(uint32_t input = 0; input <= 0xFF; input++) {
+        std::array<uint32_t, 29> row;
+        uint32_t fullInput = (fb << 8) | input;
+        row[0] = fullInput;
+        for(int iEta=1; iEta<=28; ++iEta) {
+          row[iEta] = (*words)[iEta-1][fb][input];
+        }
+        table.addPayload(&row[1], (row.size()-1)*sizeof(uint32_t));
+        formatter.formatHex(row.data(), row.size(), 6);
+        table.addRow(formatter.str());
+      }
+    }
+  }
+
+  void
+  renderHFLUT(const HFLUT& lut, int firmwareVersion, RenderedTable& table)
+  {
+    table.columns = hf_columns;
+    table.types = hf_types;
+    table.clear();
+    table.rows.reserve(4*256*13*8);
+    table.rowStarts.reserve(4*256);
+    table.payload.reserve(4*256*12*sizeof(uint32_t));
+
+    auto words = std::make_unique<HFLUTWords>();
+    repackHFLUT(lut, firmwareVersion, *words);
+
+    SWATCHFormatter formatter;
+    for(uint32_t fb = 0; fb < 4; fb++) {
+      for(uint32_t hfInput = 0; hfInput <= 0xFF; hfInput++) {
+        std::array<uint32_t, 13> row;
+        uint32_t fullInput = (fb << 8) | hfInput;
+        row[0] = fullInput;
+        for(int hfEta=0; hfEta<12; ++hfEta) {
+          row[hfEta+1] = (*words)[fb][hfEta][hfInput];
+        }
+        table.addPayload(&row[1], (row.size()-1)*sizeof(uint32_t));
+        formatter.formatHex(row.data(), row.size(), 6);
+        table.addRow(formatter.str());
+      }
+    }
+  }
+
+  void
+  renderCaloWords(const uint16_t * words, RenderedTable& table)
+  {
+    renderCaloRows(words, 0, caloTableRows, table);
+  }
+
+  void
+  renderCaloRows(const uint16_t * words, uint32_t first, uint32_t last, RenderedTable& table)
+  {
+    table.columns = calo_columns;
+    table.types = calo_types;
+    table.clear();
+    table.rows.reserve((last-first)*29*8);
+    table.rowStarts.reserve(last-first);
+    table.payload.reserve((last-first)*28*sizeof(uint32_t));
+
+    SWATCHFormatter formatter;
+    std::array<uint32_t, 29> row;
+    words += first*28;
+    for(uint32_t fullInput = first; fullInput < last; fullInput++, words += 28) {
+      row[0] = fullInput;
+      std::copy(words, words+28, row.begin()+1);
+      table.addPayload(&row[1], (row.size()-1)*sizeof(uint32_t));
+      formatter.formatHex(row.data(), row.size(), 6);
+      table.addRow(formatter.str());
+    }
+  }
+
+  void
+  renderHFWords(const uint16_t * words, RenderedTable& table)
+  {
+    renderHFRows(words, 0, hfTableRows, table);
+  }
+
+  void
+  renderHFRows(const uint16_t * words, uint32_t first, uint32_t last, RenderedTable& table)
+  {
+    table.columns = hf_columns;
+    table.types = hf_types;
+    table.clear();
+    table.rows.reserve((last-first)*13*8);
+    table.rowStarts.reserve(last-first);
+    table.payload.reserve((last-first)*12*sizeof(uint32_t));
+
+    SWATCHFormatter formatter;
+    std::array<uint32_t, 13> row;
+    words += first*12;
+    for(uint32_t fullInput = first; fullInput < last; fullInput++, words += 12) {
+      row[0] = fullInput;
+      std::copy(words, words+12, row.begin()+1);
+      table.addPayload(&row[1], (row.size()-1)*sizeof(uint32_t));
+      formatter.formatHex(row.data(), row.size(), 6);
+      table.addRow(formatter.str());
+    }
+  }
+
+  void
+  renderHCALFBLUT(const std::vector<unsigned long long int>& lut, RenderedTable& table)
+  {
+    table.columns = hcalFB_columns;
+    table.types = hcalFB_types;
+    table.clear();
+
+    std::array<uint64_t, 28> row;
+    for(int iEta=0; iEta<28; ++iEta) {
+      row[iEta] = lut[iEta];
+    }
+    // NB the first eta bin has never been part of the checksum
+    table.addPayload(&row[1], (row.size()-1)*sizeof(uint64_t));
+    SWATCHFormatter formatter;
+    formatter.formatHex(row.data(), row.size(), 6);
+    table.addRow(formatter.str());
+  }
+
+}
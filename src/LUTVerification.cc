@@ -0,0 +1,299 @@
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTVerification.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTDocument.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <sstream>
+
+#include "tbb/parallel_for.h"
+#include "tbb/task_arena.h"
+
+namespace {
+
+  using namespace calol1;
+
+  // How a table param is laid out in the file
+  struct TableShape {
+    uint32_t rows;
+    uint32_t columns;
+    // Rows start with the Input column (fb << 8 | input)
+    bool inputColumn;
+    uint32_t firstEta;
+    // Checksum payload word size, and leading columns left out of it
+    size_t payloadWord;
+    uint32_t unhashedColumns;
+  };
+
+  constexpr TableShape caloShape{caloTableRows, 28, true, 1, sizeof(uint32_t), 0};
+  constexpr TableShape hfShape{hfTableRows, 12, true, 30, sizeof(uint32_t), 0};
+  // NB the first eta bin has never been part of the checksum
+  constexpr TableShape hcalFBShape{1, 28, false, 1, sizeof(uint64_t), 1};
+
+  // "0x0001, 0x0eaf, ..." as written by SWATCHFormatter
+  void parseList(const char * text, std::vector<uint64_t>& values)
+  {
+    char * end;
+    while ( true ) {
+      while ( *text == ' ' || *text == ',' || *text == '\n' ) ++text;
+      if ( *text == '\0' ) break;
+      values.push_back(std::strtoull(text, &end, 0));
+      if ( end == text ) break;
+      text = end;
+    }
+  }
+
+  uint64_t payloadWord(const std::vector<unsigned char>& payload, size_t i, size_t size)
+  {
+    if ( size == sizeof(uint32_t) ) {
+      uint32_t word;
+      std::memcpy(&word, payload.data() + i*size, size);
+      return word;
+    }
+    uint64_t word;
+    std::memcpy(&word, payload.data() + i*size, size);
+    return word;
+  }
+
+  // Expected words in row order, from a branch free repack of the whole
+  // table that runs along the contiguous input axis
+  void expectedCalo(const CaloLUT& lut, int firmwareVersion, std::vector<uint64_t>& expected)
+  {
+    // Heap, this runs on a task thread
+    auto words = std::make_unique<CaloLUT>();
+    repackCaloLUT(lut, firmwareVersion, *words);
+    expected.resize(caloTableRows*28);
+    uint64_t * out = expected.data();
+    for(uint32_t fb=0; fb<2; ++fb) {
+      for(uint32_t input=0; input<256; ++input) {
+        for(uint32_t iEta=0; iEta<28; ++iEta) *out++ = (*words)[iEta][fb][input];
+      }
+    }
+  }
+
+  void expectedHF(const HFLUT& lut, int firmwareVersion, std::vector<uint64_t>& expected)
+  {
+    auto words = std::make_unique<HFLUTWords>();
+    repackHFLUT(lut, firmwareVersion, *words);
+    expected.resize(hfTableRows*12);
+    uint64_t * out = expected.data();
+    for(uint32_t fb=0; fb<4; ++fb) {
+      for(uint32_t input=0; input<256; ++input) {
+        for(uint32_t hfEta=0; hfEta<12; ++hfEta) *out++ = (*words)[fb][hfEta][input];
+      }
+    }
+  }
+
+  std::string hex(uint64_t value)
+  {
+    std::ostringstream out;
+    out << "0x" << std::hex << value;
+    return out.str();
+  }
+
+  // The word and its fields in the layout of the firmware
+  std::string fields(LUTKind kind, uint64_t word, int firmwareVersion)
+  {
+    const FirmwareLayout layout = firmwareLayout(firmwareVersion);
+    std::ostringstream out;
+    out << hex(word);
+    if ( kind == LUTKind::ECAL || kind == LUTKind::HCAL ) {
+      // Firmware 1 words are as L1TCaloLayer1FetchLUTs packs them
+      const uint64_t etMask = layout.caloPassThrough ? 0x3ff : layout.etMask;
+      const uint32_t log2Shift = layout.caloPassThrough ? fetchlayout::log2Shift : layout.log2Shift;
+      const uint32_t zeroFlagShift = layout.caloPassThrough ? fetchlayout::zeroFlagShift : layout.zeroFlagShift;
+      const uint32_t fgShift = layout.caloPassThrough ? fetchlayout::fgShift : layout.fgShift;
+      out << " (ET " << hex(word & etMask) << " log2 " << ((word >> log2Shift) & fetchlayout::log2Mask)
+          << " zero " << ((word >> zeroFlagShift) & 1) << " FG " << ((word >> fgShift) & 1) << ")";
+    }
+    else if ( kind == LUTKind::HF ) {
+      out << " (ET " << hex(word & ((1u << layout.hfFeatureShift) - 1)) << " fb " << (word >> layout.hfFeatureShift) << ")";
+    }
+    return out.str();
+  }
+
+  void compare(const RenderedTable& table, const TableShape& shape, const std::vector<uint64_t>& expected,
+               size_t maxCells, LUTVerification::TableReport& report)
+  {
+    if ( table.nRows() != shape.rows ) {
+      report.problem = std::to_string(table.nRows()) + " rows instead of " + std::to_string(shape.rows);
+      return;
+    }
+    const size_t payloadCells = shape.rows*(shape.columns - shape.unhashedColumns);
+    if ( table.payload.size() != payloadCells*shape.payloadWord ) {
+      report.problem = "checksum payload of " + std::to_string(table.payload.size()) + " bytes instead of "
+        + std::to_string(payloadCells*shape.payloadWord);
+      return;
+    }
+
+    auto mismatch = [&](bool payload, uint32_t row, uint32_t column, uint64_t written) {
+      if ( report.first.size() < maxCells ) {
+        report.first.push_back({payload, row >> 8, row & 0xff, shape.firstEta + column,
+                                expected[row*shape.columns + column], written});
+      }
+    };
+
+    const uint32_t skip = shape.inputColumn ? 1 : 0;
+    std::vector<uint64_t> values;
+    values.reserve(shape.columns + skip);
+    for(uint32_t row=0; row<shape.rows; ++row) {
+      values.clear();
+      parseList(table.row(row), values);
+      if ( values.size() != shape.columns + skip ) {
+        report.problem = "row " + std::to_string(row) + " has " + std::to_string(values.size()) + " values instead of "
+          + std::to_string(shape.columns + skip);
+        return;
+      }
+      if ( shape.inputColumn && values[0] != row ) {
+        report.problem = "row " + std::to_string(row) + " has Input " + hex(values[0]);
+        return;
+      }
+      const uint64_t * want = expected.data() + row*shape.columns;
+      for(uint32_t column=0; column<shape.columns; ++column) {
+        if ( values[skip + column] != want[column] ) {
+          ++report.textMismatches;
+          mismatch(false, row, column, values[skip + column]);
+        }
+      }
+    }
+
+    size_t cell = 0;
+    for(uint32_t row=0; row<shape.rows; ++row) {
+      const uint64_t * want = expected.data() + row*shape.columns;
+      for(uint32_t column=shape.unhashedColumns; column<shape.columns; ++column, ++cell) {
+        const uint64_t word = payloadWord(table.payload, cell, shape.payloadWord);
+        if ( word != want[column] ) {
+          ++report.payloadMismatches;
+          mismatch(true, row, column, word);
+        }
+      }
+    }
+  }
+
+  // Returns the number of cells checked
+  uint64_t checkTable(const LUTArrays& luts, const LUTTableKey& key, const RenderedTable * table,
+                      size_t maxCells, LUTVerification::TableReport& report)
+  {
+    if ( table == nullptr ) {
+      report.problem = "not rendered";
+      return 0;
+    }
+    std::vector<uint64_t> expected;
+    const TableShape * shape{nullptr};
+    switch ( key.kind ) {
+      case LUTKind::ECAL:
+      case LUTKind::HCAL: {
+        const std::vector<CaloLUT>& lut = key.kind == LUTKind::ECAL ? luts.ecalLUT : luts.hcalLUT;
+        if ( key.index >= lut.size() ) {
+          report.problem = "phi bin " + std::to_string(key.index) + " not in the LUT arrays";
+          return 0;
+        }
+        expectedCalo(lut[key.index], key.firmwareVersion, expected);
+        shape = &caloShape;
+        break;
+      }
+      case LUTKind::HF:
+        if ( key.index >= luts.hfLUT.size() ) {
+          report.problem = "phi bin " + std::to_string(key.index) + " not in the LUT arrays";
+          return 0;
+        }
+        expectedHF(luts.hfLUT[key.index], key.firmwareVersion, expected);
+        shape = &hfShape;
+        break;
+      case LUTKind::HCALFB:
+        if ( luts.hcalFBLUT.size() < 28 ) {
+          report.problem = "only " + std::to_string(luts.hcalFBLUT.size()) + " HCAL FB LUT entries";
+          return 0;
+        }
+        expected.assign(luts.hcalFBLUT.begin(), luts.hcalFBLUT.begin() + 28);
+        shape = &hcalFBShape;
+        break;
+    }
+    compare(*table, *shape, expected, maxCells, report);
+    return uint64_t(shape->rows)*shape->columns;
+  }
+
+}
+
+namespace calol1 {
+
+  LUTVerification::LUTVerification(const LUTDocument& document, int numberOfThreads, size_t maxCells) :
+    firmwareVersion_(document.parameters().firmwareVersion)
+  {
+    // Tables missing from an unprepared document are reported as not rendered
+    const LUTTableCache& cache = document.cache();
+    const LUTArrays& luts = document.luts();
+
+    // Same params as the document writes, processors first
+    const int firmwareVersion = firmwareVersion_;
+    std::vector< std::pair<std::string, ContextParams> > contexts{{"processors", {
+      {"ECALLUTMinus", {LUTKind::ECAL, 0, firmwareVersion}},
+      {"ECALLUTPlus", {LUTKind::ECAL, 0, firmwareVersion}},
+      {"HCALLUTMinus", {LUTKind::HCAL, 0, firmwareVersion}},
+      {"HCALLUTPlus", {LUTKind::HCAL, 0, firmwareVersion}},
+      {"HFLUTMinus", {LUTKind::HF, 0, firmwareVersion}},
+      {"HFLUTPlus", {LUTKind::HF, 0, firmwareVersion}},
+      {"HCALFBLUTMinus", {LUTKind::HCALFB, 0, firmwareVersion}},
+      {"HCALFBLUTPlus", {LUTKind::HCALFB, 0, firmwareVersion}}
+    }}};
+    for(const auto& context : document.cardContexts()) contexts.push_back({context.id, context.params});
+
+    // Like the rendering, a table shared by several contexts is checked
+    // once, each check into its own slot
+    std::vector<LUTTableKey> keys;
+    for(const auto& context : contexts) {
+      for(const auto& param : context.second) {
+        if ( std::find(keys.begin(), keys.end(), param.second) == keys.end() ) keys.push_back(param.second);
+      }
+    }
+    std::vector<TableReport> reports(keys.size());
+    std::vector<uint64_t> cells(keys.size(), 0);
+    auto check = [&](size_t i) {
+      reports[i].kind = keys[i].kind;
+      cells[i] = checkTable(luts, keys[i], cache.find(keys[i]), maxCells, reports[i]);
+    };
+    if ( numberOfThreads == 1 ) {
+      for(size_t i=0; i<keys.size(); ++i) check(i);
+    }
+    else {
+      tbb::task_arena arena(numberOfThreads > 0 ? numberOfThreads : static_cast<int>(tbb::task_arena::automatic));
+      arena.execute([&]() { tbb::parallel_for(size_t(0), keys.size(), check); });
+    }
+
+    // Reported wherever the table is written
+    for(const auto& context : contexts) {
+      for(const auto& param : context.second) {
+        const size_t i = std::find(keys.begin(), keys.end(), param.second) - keys.begin();
+        ++tables_;
+        cells_ += cells[i];
+        const TableReport& report = reports[i];
+        if ( !report.problem.empty() || report.textMismatches > 0 || report.payloadMismatches > 0 ) {
+          failures_.push_back(report);
+          failures_.back().context = context.first;
+          failures_.back().id = param.first;
+        }
+      }
+    }
+  }
+
+  void
+  LUTVerification::print(std::ostream& out) const
+  {
+    for(const auto& table : failures_) {
+      out << table.context << " " << table.id << ": ";
+      if ( !table.problem.empty() ) {
+        out << table.problem << "\n";
+        continue;
+      }
+      out << table.textMismatches << " text and " << table.payloadMismatches << " checksum cells differ\n";
+      for(const auto& cell : table.first) {
+        out << "  " << (cell.payload ? "checksum" : "text") << " ";
+        if ( table.kind != LUTKind::HCALFB ) out << "fb " << cell.fb << " input " << hex(cell.input) << " ";
+        out << "iEta " << cell.iEta << ": written " << fields(table.kind, cell.written, firmwareVersion_)
+            << ", expected " << fields(table.kind, cell.expected, firmwareVersion_) << "\n";
+      }
+    }
+  }
+
+}
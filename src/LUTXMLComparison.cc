@@ -0,0 +1,226 @@
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTXMLComparison.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <libxml/xmlreader.h>
+
+namespace {
+
+  // The parts of a reader node that have to match
+  struct Node {
+    int type{0};
+    std::string name;
+    std::string value;
+    std::vector< std::pair<std::string, std::string> > attributes;
+  };
+
+  class Side {
+  public:
+    explicit Side(const std::string& fileName) :
+      reader_(xmlReaderForFile(fileName.c_str(), NULL, XML_PARSE_NONET | XML_PARSE_HUGE)) {}
+    ~Side() { if ( reader_ != NULL ) xmlFreeTextReader(reader_); }
+    Side(const Side&) = delete;
+    Side& operator=(const Side&) = delete;
+
+    bool opened() const { return reader_ != NULL; }
+
+    // 1 with node filled, 0 at the end of the document, -1 on a parse error
+    int next(Node& node) {
+      const int rc = xmlTextReaderRead(reader_);
+      if ( rc != 1 ) return rc;
+      node.type = xmlTextReaderNodeType(reader_);
+      const xmlChar * name = xmlTextReaderConstName(reader_);
+      node.name = name ? reinterpret_cast<const char *>(name) : "";
+      const xmlChar * value = xmlTextReaderConstValue(reader_);
+      node.value = value ? reinterpret_cast<const char *>(value) : "";
+      node.attributes.clear();
+      if ( node.type == XML_READER_TYPE_ELEMENT && xmlTextReaderHasAttributes(reader_) == 1 ) {
+        while ( xmlTextReaderMoveToNextAttribute(reader_) == 1 ) {
+          node.attributes.emplace_back(reinterpret_cast<const char *>(xmlTextReaderConstName(reader_)),
+                                       reinterpret_cast<const char *>(xmlTextReaderConstValue(reader_)));
+        }
+        xmlTextReaderMoveToElement(reader_);
+      }
+      return 1;
+    }
+
+  private:
+    xmlTextReaderPtr reader_;
+  };
+
+  std::string attribute(const Node& node, const char * name) {
+    for(const auto& attribute : node.attributes) {
+      if ( attribute.first == name ) return attribute.second;
+    }
+    return "";
+  }
+
+  // Comma separated field where two row texts first differ
+  long firstColumn(const std::string& expected, const std::string& actual) {
+    auto diff = std::mismatch(expected.begin(), expected.end(), actual.begin(), actual.end());
+    return std::count(expected.begin(), diff.first, ',');
+  }
+
+  // Whitespace differences have to be visible
+  std::string printable(const std::string& text) {
+    std::string out;
+    for(char c : text) {
+      if ( c == '\n' ) out += "\\n";
+      else if ( c == '\t' ) out += "\\t";
+      else out += c;
+    }
+    return "\"" + out + "\"";
+  }
+
+  const char * nodeKind(int type) {
+    switch ( type ) {
+      case XML_READER_TYPE_ELEMENT: return "element";
+      case XML_READER_TYPE_END_ELEMENT: return "end of element";
+      case XML_READER_TYPE_TEXT: return "text";
+      case XML_READER_TYPE_SIGNIFICANT_WHITESPACE: return "whitespace";
+      case XML_READER_TYPE_WHITESPACE: return "whitespace";
+      default: return "node";
+    }
+  }
+
+}
+
+namespace calol1 {
+
+  LUTXMLComparison::LUTXMLComparison(const std::string& expectedFile, const std::string& actualFile)
+  {
+    if ( sameBytes(expectedFile, actualFile) ) {
+      result_ = Result::SameBytes;
+      return;
+    }
+    if ( !error_.empty() ) return;
+    compareNodes(expectedFile, actualFile);
+  }
+
+  bool
+  LUTXMLComparison::sameBytes(const std::string& expectedFile, const std::string& actualFile)
+  {
+    std::unique_ptr<FILE, int(*)(FILE *)> expected(std::fopen(expectedFile.c_str(), "rb"), std::fclose);
+    std::unique_ptr<FILE, int(*)(FILE *)> actual(std::fopen(actualFile.c_str(), "rb"), std::fclose);
+    if ( !expected || !actual ) {
+      error_ = "cannot open " + (expected ? actualFile : expectedFile);
+      return false;
+    }
+    constexpr size_t blockSize = 1 << 20;
+    std::vector<char> a(blockSize), b(blockSize);
+    while ( true ) {
+      const size_t na = std::fread(a.data(), 1, blockSize, expected.get());
+      const size_t nb = std::fread(b.data(), 1, blockSize, actual.get());
+      if ( na != nb || std::memcmp(a.data(), b.data(), na) != 0 ) return false;
+      if ( na < blockSize ) return true;
+    }
+  }
+
+  void
+  LUTXMLComparison::compareNodes(const std::string& expectedFile, const std::string& actualFile)
+  {
+    Side expected(expectedFile), actual(actualFile);
+    if ( !expected.opened() || !actual.opened() ) {
+      error_ = "cannot open " + (expected.opened() ? actualFile : expectedFile);
+      result_ = Result::Error;
+      return;
+    }
+
+    Difference& where = difference_;
+    long rows{0};
+    bool inRow{false};
+    Node a, b;
+    while ( true ) {
+      const int ra = expected.next(a);
+      const int rb = actual.next(b);
+      if ( ra < 0 || rb < 0 ) {
+        error_ = "cannot parse " + (ra < 0 ? expectedFile : actualFile);
+        result_ = Result::Error;
+        return;
+      }
+      if ( ra == 0 || rb == 0 ) {
+        if ( ra == rb ) {
+          result_ = Result::SameContent;
+          return;
+        }
+        where.node = "end of document";
+        where.expected = ra == 0 ? "end of document" : std::string(nodeKind(a.type)) + " " + a.name;
+        where.actual = rb == 0 ? "end of document" : std::string(nodeKind(b.type)) + " " + b.name;
+        result_ = Result::Different;
+        return;
+      }
+
+      // Position, from the expected side
+      if ( a.type == XML_READER_TYPE_ELEMENT ) {
+        if ( a.name == "context" ) {
+          where.context = attribute(a, "id");
+          where.param.clear();
+        }
+        else if ( a.name == "param" ) {
+          where.param = attribute(a, "id");
+          rows = 0;
+        }
+        else if ( a.name == "row" ) {
+          where.row = rows++;
+          inRow = true;
+        }
+      }
+      else if ( a.type == XML_READER_TYPE_END_ELEMENT && a.name == "row" ) {
+        inRow = false;
+      }
+      if ( !inRow && !(a.type == XML_READER_TYPE_END_ELEMENT && a.name == "row") ) where.row = -1;
+
+      if ( a.type != b.type || a.name != b.name ) {
+        where.node = a.name;
+        where.expected = std::string(nodeKind(a.type)) + " " + a.name;
+        where.actual = std::string(nodeKind(b.type)) + " " + b.name;
+        result_ = Result::Different;
+        return;
+      }
+      if ( a.value != b.value ) {
+        where.node = a.name;
+        if ( inRow && a.type == XML_READER_TYPE_TEXT ) where.column = firstColumn(a.value, b.value);
+        where.expected = a.value;
+        where.actual = b.value;
+        result_ = Result::Different;
+        return;
+      }
+      if ( a.attributes != b.attributes ) {
+        const size_t n = std::min(a.attributes.size(), b.attributes.size());
+        size_t i = 0;
+        while ( i < n && a.attributes[i] == b.attributes[i] ) ++i;
+        where.node = a.name + "@" + (i < a.attributes.size() ? a.attributes[i].first : b.attributes[i].first);
+        where.expected = i < a.attributes.size() ? a.attributes[i].first + "=\"" + a.attributes[i].second + "\"" : "no attribute";
+        where.actual = i < b.attributes.size() ? b.attributes[i].first + "=\"" + b.attributes[i].second + "\"" : "no attribute";
+        result_ = Result::Different;
+        return;
+      }
+    }
+  }
+
+  void
+  LUTXMLComparison::print(std::ostream& out) const
+  {
+    switch ( result_ ) {
+      case Result::SameBytes: out << "identical\n"; return;
+      case Result::SameContent: out << "same content, different bytes (compression or XML declaration)\n"; return;
+      case Result::Error: out << "error: " << error_ << "\n"; return;
+      case Result::Different: break;
+    }
+    const Difference& d = difference_;
+    out << "first difference";
+    if ( !d.context.empty() ) out << " in context " << d.context;
+    if ( !d.param.empty() ) out << ", param " << d.param;
+    if ( d.row >= 0 ) out << ", row " << d.row;
+    if ( d.column >= 0 ) out << ", column " << d.column;
+    out << " (" << d.node << ")\n"
+        << "  expected: " << printable(d.expected) << "\n"
+        << "  actual:   " << printable(d.actual) << "\n";
+  }
+
+}
@@ -0,0 +1,374 @@
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTXMLLoader.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTChecksum.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <utility>
+
+#include <sys/stat.h>
+
+#include <libxml/xmlreader.h>
+
+namespace {
+
+  enum class Param { None, ECAL, HCAL, HF, HCALFB, SecondStageLUT, Checksum };
+
+  // What a param id is, side 0 for Minus and 1 for Plus
+  Param paramKind(const std::string& id, size_t& side)
+  {
+    static const struct { const char * prefix; Param param; } tables[] = {
+      {"ECALLUT", Param::ECAL}, {"HCALLUT", Param::HCAL}, {"HFLUT", Param::HF}, {"HCALFBLUT", Param::HCALFB}};
+    for(const auto& table : tables) {
+      const size_t n = std::strlen(table.prefix);
+      if ( id.compare(0, n, table.prefix) != 0 ) continue;
+      if ( id.compare(n, std::string::npos, "Minus") == 0 ) side = 0;
+      else if ( id.compare(n, std::string::npos, "Plus") == 0 ) side = 1;
+      else return Param::None;
+      return table.param;
+    }
+    if ( id == "layer1SecondStageLUT" ) return Param::SecondStageLUT;
+    if ( id.size() > 8 && id.compare(id.size()-8, 8, "checksum") == 0 ) return Param::Checksum;
+    return Param::None;
+  }
+
+  // Next field of a "0x0001, 0x0eaf, ..." list as SWATCHFormatter writes
+  // it (zero is written without 0x); false at the end of the text, or
+  // with p left on whatever is not a number
+  inline bool nextField(const char *& p, uint64_t& value)
+  {
+    while ( *p == ' ' || *p == ',' || *p == '\n' ) ++p;
+    value = 0;
+    const char * start = p;
+    if ( p[0] == '0' && (p[1] == 'x' || p[1] == 'X') ) {
+      start = p += 2;
+      while ( true ) {
+        const char c = *p | 0x20;
+        if ( c >= '0' && c <= '9' ) value = (value << 4) | (c - '0');
+        else if ( c >= 'a' && c <= 'f' ) value = (value << 4) | (c - 'a' + 10);
+        else break;
+        ++p;
+      }
+    }
+    else {
+      while ( *p >= '0' && *p <= '9' ) value = 10*value + (*p++ - '0');
+    }
+    return p != start && (*p == '\0' || *p == ',' || *p == ' ' || *p == '\n');
+  }
+
+  // Exactly n fields, false otherwise
+  bool parseRow(const char * p, uint64_t * fields, size_t n)
+  {
+    size_t i = 0;
+    uint64_t value;
+    while ( nextField(p, value) ) {
+      if ( i == n ) return false;
+      fields[i++] = value;
+    }
+    return i == n && *p == '\0';
+  }
+
+}
+
+namespace calol1 {
+
+  size_t
+  LUTXMLLoader::Context::nTables() const
+  {
+    size_t n = secondStageLUT.empty() ? 0 : 1;
+    for(size_t side=0; side<2; ++side) {
+      n += !ecal[side].empty() + !hcal[side].empty() + !hf[side].empty() + !hcalFB[side].empty();
+    }
+    return n;
+  }
+
+  bool
+  LUTXMLLoader::load(const std::string& fileName)
+  {
+    std::vector<Context> contexts;
+    const bool loaded = read(fileName, [&contexts](Context& context) {
+      contexts.push_back(std::move(context));
+      return true;
+    });
+    contexts_ = std::move(contexts);
+    return loaded;
+  }
+
+  bool
+  LUTXMLLoader::load(const std::string& fileName, const std::function<bool(const Context&)>& onContext)
+  {
+    return read(fileName, [&onContext](Context& context) { return onContext(context); });
+  }
+
+  const LUTXMLLoader::Context *
+  LUTXMLLoader::find(const std::string& id) const
+  {
+    for(const auto& context : contexts_) {
+      if ( context.id == id ) return &context;
+    }
+    return nullptr;
+  }
+
+  bool
+  LUTXMLLoader::read(const std::string& fileName, const std::function<bool(Context&)>& onContext)
+  {
+    contexts_.clear();
+    checked_ = 0;
+    mismatches_.clear();
+    bytes_ = 0;
+    fileBytes_ = 0;
+    seconds_ = 0.;
+    error_.clear();
+
+    const auto start = std::chrono::steady_clock::now();
+    struct stat info;
+    if ( stat(fileName.c_str(), &info) == 0 ) fileBytes_ = info.st_size;
+    // Indentation is of no interest, so no whitespace nodes
+    xmlTextReaderPtr reader = xmlReaderForFile(fileName.c_str(), NULL, XML_PARSE_NONET | XML_PARSE_HUGE | XML_PARSE_NOBLANKS);
+    if ( reader == NULL ) {
+      error_ = "cannot open " + fileName;
+      return false;
+    }
+
+    auto attribute = [reader](const char * name) {
+      xmlChar * value = xmlTextReaderGetAttribute(reader, BAD_CAST name);
+      std::string result = value ? reinterpret_cast<const char *>(value) : "";
+      xmlFree(value);
+      return result;
+    };
+
+    // Which text node comes next
+    enum class Text { None, Columns, Row, Value };
+    Text expect{Text::None};
+    Context context;
+    bool inContext{false};
+    // Tables of the processors context, which delta tables of the cards start from
+    Context base;
+    // Until the md5checksum param
+    std::unique_ptr<LUTChecksum> md5;
+    // What the context checksums cover, in document order
+    std::vector< std::pair<const void *, size_t> > payload;
+    // The param being read, for a table its shape and where it goes
+    std::string id;
+    Param param{Param::None};
+    size_t side{0};
+    uint32_t rows{0}, columns{0}, row{0};
+    bool inputColumn{false};
+    // type="table:delta": only the rows differing from base, by Input
+    bool delta{false};
+    uint32_t * words32{nullptr};
+    uint64_t * words64{nullptr};
+    std::array<uint64_t, 29> fields;
+
+    auto malformed = [&](const std::string& what) {
+      error_ = "malformed " + (id.empty() ? std::string("context") : id) + " in context " + context.id + " of " + fileName + ": " + what;
+    };
+    auto addPayload = [&](const void * data, size_t size) {
+      payload.emplace_back(data, size);
+      if ( md5 ) md5->update(data, size);
+    };
+    auto checkChecksum = [&](const char * written) {
+      std::string computed;
+      if ( id == "md5checksum" ) {
+        if ( !md5 ) return;
+        computed = md5->digest();
+        md5.reset();
+        context.md5checksum = written;
+      }
+      else {
+        ChecksumAlgorithm algorithm;
+        if ( !checksumAlgorithmFromName(id.substr(0, id.size()-8), algorithm) ) return;
+        LUTChecksum digest(algorithm);
+        for(const auto& piece : payload) digest.update(piece.first, piece.second);
+        computed = digest.digest();
+      }
+      ++checked_;
+      if ( computed != written ) mismatches_.push_back({context.id, id, written, computed});
+    };
+
+    bool ok{true}, stopped{false};
+    int rc;
+    while ( ok && !stopped && (rc = xmlTextReaderRead(reader)) == 1 ) {
+      const int type = xmlTextReaderNodeType(reader);
+      if ( type == XML_READER_TYPE_ELEMENT ) {
+        const char * name = reinterpret_cast<const char *>(xmlTextReaderConstLocalName(reader));
+        expect = Text::None;
+        if ( std::strcmp(name, "context") == 0 ) {
+          context = Context();
+          context.id = attribute("id");
+          inContext = true;
+          md5 = std::make_unique<LUTChecksum>(ChecksumAlgorithm::MD5);
+          payload.clear();
+          id.clear();
+          param = Param::None;
+        }
+        else if ( std::strcmp(name, "param") == 0 && inContext ) {
+          id = attribute("id");
+          param = paramKind(id, side);
+          row = 0;
+          words32 = nullptr;
+          words64 = nullptr;
+          delta = false;
+          std::vector<uint32_t> * table{nullptr};
+          const std::vector<uint32_t> * baseTable{nullptr};
+          if ( param == Param::ECAL ) {
+            table = &context.ecal[side];
+            baseTable = &base.ecal[side];
+          }
+          else if ( param == Param::HCAL ) {
+            table = &context.hcal[side];
+            baseTable = &base.hcal[side];
+          }
+          else if ( param == Param::HF ) {
+            table = &context.hf[side];
+            baseTable = &base.hf[side];
+          }
+          if ( table != nullptr ) {
+            rows = ( param == Param::HF ) ? 4*256 : 2*256;
+            columns = ( param == Param::HF ) ? 12 : 28;
+            delta = attribute("type") == "table:delta";
+            if ( delta && baseTable->size() != rows*columns ) {
+              malformed("delta table without one in context processors");
+              ok = false;
+            }
+            else if ( delta ) {
+              *table = *baseTable;
+            }
+            else {
+              table->assign(rows*columns, 0);
+            }
+            words32 = table->data();
+          }
+          else if ( param == Param::HCALFB ) {
+            rows = 1;
+            columns = 28;
+            context.hcalFB[side].assign(columns, 0);
+            words64 = context.hcalFB[side].data();
+          }
+          else if ( param == Param::SecondStageLUT || param == Param::Checksum ) {
+            expect = Text::Value;
+          }
+        }
+        else if ( words32 != nullptr || words64 != nullptr ) {
+          if ( std::strcmp(name, "columns") == 0 ) expect = Text::Columns;
+          else if ( std::strcmp(name, "row") == 0 ) expect = Text::Row;
+        }
+      }
+      else if ( type == XML_READER_TYPE_TEXT && expect != Text::None ) {
+        const char * text = reinterpret_cast<const char *>(xmlTextReaderConstValue(reader));
+        if ( expect == Text::Columns ) {
+          // "Input, 01, 02, ..." or "01, 02, ..."
+          inputColumn = std::strncmp(text, "Input", 5) == 0;
+          const size_t n = std::count(text, text + std::strlen(text), ',') + 1;
+          if ( n != columns + (inputColumn ? 1 : 0) ) {
+            malformed(std::to_string(n) + " columns");
+            ok = false;
+          }
+          else if ( delta && !inputColumn ) {
+            malformed("delta table without an Input column");
+            ok = false;
+          }
+        }
+        else if ( expect == Text::Row ) {
+          const size_t n = columns + (inputColumn ? 1 : 0);
+          if ( row == rows ) {
+            malformed("more than " + std::to_string(rows) + " rows");
+            ok = false;
+          }
+          else if ( !parseRow(text, fields.data(), n) ) {
+            malformed("row " + std::to_string(row) + " does not have " + std::to_string(n) + " numbers");
+            ok = false;
+          }
+          else if ( delta && (fields[0] < row || fields[0] >= rows) ) {
+            // Rows of a delta table in increasing Input order
+            malformed("row after Input " + std::to_string(row) + " has Input " + std::to_string(fields[0]));
+            ok = false;
+          }
+          else if ( inputColumn && !delta && fields[0] != row ) {
+            malformed("row " + std::to_string(row) + " has Input " + std::to_string(fields[0]));
+            ok = false;
+          }
+          else {
+            if ( delta ) row = fields[0];
+            const uint64_t * values = fields.data() + (inputColumn ? 1 : 0);
+            if ( words64 != nullptr ) {
+              std::copy(values, values + columns, words64 + row*columns);
+            }
+            else {
+              uint32_t * out = words32 + row*columns;
+              for(uint32_t column=0; column<columns; ++column) {
+                if ( values[column] > 0xffffffffull ) {
+                  malformed("row " + std::to_string(row) + " has a value above 32 bits");
+                  ok = false;
+                }
+                out[column] = values[column];
+              }
+            }
+            ++row;
+          }
+        }
+        else if ( param == Param::SecondStageLUT ) {
+          const char * p = text;
+          uint64_t value;
+          while ( nextField(p, value) ) context.secondStageLUT.push_back(value);
+          if ( *p != '\0' ) {
+            malformed("not a list of numbers");
+            ok = false;
+          }
+        }
+        else if ( param == Param::Checksum ) {
+          checkChecksum(text);
+        }
+        expect = Text::None;
+      }
+      else if ( type == XML_READER_TYPE_END_ELEMENT ) {
+        const char * name = reinterpret_cast<const char *>(xmlTextReaderConstLocalName(reader));
+        expect = Text::None;
+        if ( std::strcmp(name, "param") == 0 && param != Param::None ) {
+          if ( words32 != nullptr || words64 != nullptr ) {
+            if ( row != rows && !delta ) {
+              malformed(std::to_string(row) + " rows instead of " + std::to_string(rows));
+              ok = false;
+            }
+            // The checksum payload of a table: its words, without the
+            // first eta bin of the HCAL FB LUT
+            if ( words64 != nullptr ) addPayload(words64 + 1, (columns-1)*sizeof(uint64_t));
+            else addPayload(words32, rows*columns*sizeof(uint32_t));
+          }
+          else if ( param == Param::SecondStageLUT ) {
+            addPayload(context.secondStageLUT.data(), context.secondStageLUT.size()*sizeof(uint32_t));
+          }
+          param = Param::None;
+          words32 = nullptr;
+          words64 = nullptr;
+          id.clear();
+        }
+        else if ( std::strcmp(name, "context") == 0 && inContext ) {
+          if ( md5 && context.nTables() > 0 ) {
+            ++checked_;
+            mismatches_.push_back({context.id, "md5checksum", "", md5->digest()});
+          }
+          md5.reset();
+          inContext = false;
+          if ( context.id == "processors" ) {
+            base.ecal = context.ecal;
+            base.hcal = context.hcal;
+            base.hf = context.hf;
+          }
+          if ( !onContext(context) ) stopped = true;
+        }
+      }
+    }
+    bytes_ = xmlTextReaderByteConsumed(reader);
+    xmlFreeTextReader(reader);
+    seconds_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if ( !ok ) return false;
+    if ( !stopped && rc != 0 ) {
+      error_ = "cannot parse " + fileName;
+      return false;
+    }
+    return true;
+  }
+
+}
@@ -0,0 +1,78 @@
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/SWATCHFormatter.h"
+
+#include <charconv>
+#include <cstdio>
+
+namespace calol1 {
+
+  void
+  SWATCHFormatter::appendDecimal(long long int value)
+  {
+    char tmp[24];
+    auto result = std::to_chars(tmp, tmp+sizeof(tmp), value);
+    buffer_.append(tmp, result.ptr-tmp);
+  }
+
+  void
+  SWATCHFormatter::appendDecimal(unsigned long long int value)
+  {
+    char tmp[24];
+    auto result = std::to_chars(tmp, tmp+sizeof(tmp), value);
+    buffer_.append(tmp, result.ptr-tmp);
+  }
+
+  void
+  SWATCHFormatter::appendFloat(float value)
+  {
+    // operator<<(float) with default stream flags is printf("%g")
+    char tmp[32];
+    int n = std::snprintf(tmp, sizeof(tmp), "%g", static_cast<double>(value));
+    buffer_.append(tmp, n);
+  }
+
+  const char *
+  SWATCHFormatter::formatList(const std::vector<int>& vect)
+  {
+    clear();
+    for(auto it=vect.begin(); it!=vect.end(); ++it) {
+      if ( it != vect.begin() ) appendSeparator();
+      appendDecimal(static_cast<long long int>(*it));
+    }
+    return c_str();
+  }
+
+  const char *
+  SWATCHFormatter::formatList(const std::vector<unsigned int>& vect)
+  {
+    clear();
+    for(auto it=vect.begin(); it!=vect.end(); ++it) {
+      if ( it != vect.begin() ) appendSeparator();
+      appendDecimal(static_cast<unsigned long long int>(*it));
+    }
+    return c_str();
+  }
+
+  const char *
+  SWATCHFormatter::formatList(const std::vector<double>& vect)
+  {
+    clear();
+    for(auto it=vect.begin(); it!=vect.end(); ++it) {
+      if ( it != vect.begin() ) appendSeparator();
+      appendFloat((float) *it);
+    }
+    return c_str();
+  }
+
+  const char *
+  SWATCHFormatter::formatList(const std::vector<unsigned long long int>& vect)
+  {
+    // Yes, these were always written as float
+    clear();
+    for(auto it=vect.begin(); it!=vect.end(); ++it) {
+      if ( it != vect.begin() ) appendSeparator();
+      appendFloat((float) *it);
+    }
+    return c_str();
+  }
+
+}
@@ -0,0 +1,141 @@
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/SWATCHXMLEmitter.h"
+
+namespace calol1 {
+
+  SWATCHXMLEmitter::SWATCHXMLEmitter(xmlOutputBufferPtr out, size_t flushSize) :
+    out_(out),
+    flushSize_(flushSize)
+  {
+    buffer_.reserve(flushSize_ + 4096);
+  }
+
+  SWATCHXMLEmitter::~SWATCHXMLEmitter()
+  {
+    close();
+  }
+
+  int
+  SWATCHXMLEmitter::startAlgo(const char * id)
+  {
+    buffer_.append("<?xml version=\"1.0\"?>\n<algo id=\"");
+    appendEscaped(id, true);
+    buffer_.append("\">\n");
+    return flush(false);
+  }
+
+  int
+  SWATCHXMLEmitter::startContext(const char * id)
+  {
+    buffer_.append("  <context id=\"");
+    appendEscaped(id, true);
+    buffer_.append("\">\n");
+    return flush(false);
+  }
+
+  int
+  SWATCHXMLEmitter::param(const char * id, const char * type, const char * body)
+  {
+    buffer_.append("    <param id=\"");
+    appendEscaped(id, true);
+    buffer_.append("\" type=\"");
+    appendEscaped(type, true);
+    buffer_.append("\">");
+    appendEscaped(body, false);
+    buffer_.append("</param>\n");
+    return flush(false);
+  }
+
+  int
+  SWATCHXMLEmitter::startTable(const char * id, const char * columns, const char * types, const char * type)
+  {
+    buffer_.append("    <param id=\"");
+    appendEscaped(id, true);
+    buffer_.append("\" type=\"");
+    appendEscaped(type, true);
+    buffer_.append("\">\n      <columns>");
+    buffer_.append(columns);
+    buffer_.append("</columns>\n      <types>");
+    buffer_.append(types);
+    buffer_.append("</types>\n      <rows>\n");
+    return flush(false);
+  }
+
+  int
+  SWATCHXMLEmitter::row(const char * text)
+  {
+    buffer_.append("        <row>");
+    buffer_.append(text);
+    buffer_.append("</row>\n");
+    return flush(false);
+  }
+
+  int
+  SWATCHXMLEmitter::endTable()
+  {
+    buffer_.append("      </rows>\n    </param>\n");
+    return flush(false);
+  }
+
+  int
+  SWATCHXMLEmitter::endContext()
+  {
+    buffer_.append("  </context>\n");
+    return flush(false);
+  }
+
+  int
+  SWATCHXMLEmitter::endAlgo()
+  {
+    buffer_.append("</algo>\n");
+    return flush(true);
+  }
+
+  int
+  SWATCHXMLEmitter::close()
+  {
+    if ( out_ == nullptr ) return failed_ ? -1 : 0;
+    int rc = flush(true);
+    if ( xmlOutputBufferClose(out_) < 0 ) rc = -1;
+    out_ = nullptr;
+    if ( rc < 0 ) failed_ = true;
+    return rc;
+  }
+
+  int
+  SWATCHXMLEmitter::flush(bool force)
+  {
+    if ( failed_ || out_ == nullptr ) return -1;
+    if ( buffer_.empty() || (!force && buffer_.size() < flushSize_) ) return 0;
+    if ( xmlOutputBufferWrite(out_, buffer_.size(), buffer_.data()) < 0 ) {
+      failed_ = true;
+      return -1;
+    }
+    buffer_.clear();
+    return 0;
+  }
+
+  void
+  SWATCHXMLEmitter::appendEscaped(const char * text, bool attribute)
+  {
+    // Same entities as xmlTextWriterWriteAttribute / xmlTextWriterWriteString
+    for(const char * p = text; *p != '\0'; ++p) {
+      switch ( *p ) {
+        case '<': buffer_.append("&lt;"); break;
+        case '>': buffer_.append("&gt;"); break;
+        case '&': buffer_.append("&amp;"); break;
+        case '"': buffer_.append("&quot;"); break;
+        case '\r': buffer_.append("&#13;"); break;
+        case '\n':
+          if ( attribute ) buffer_.append("&#10;");
+          else buffer_.push_back('\n');
+          break;
+        case '\t':
+          if ( attribute ) buffer_.append("&#9;");
+          else buffer_.push_back('\t');
+          break;
+        default: buffer_.push_back(*p);
+      }
+    }
+  }
+
+}
@@ -0,0 +1,21 @@
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/SharedLUTs.h"
+
+#include <utility>
+
+namespace calol1 {
+
+  SharedLUTs::SharedLUTs(LUTParameters parameters, LUTArrays luts, HcalScaleTable hcalScale, const std::vector<ChecksumAlgorithm>& extraChecksums,
+                         bool deltaContexts, std::string fingerprint, int numberOfThreads) :
+    parameters_(std::move(parameters)),
+    luts_(std::move(luts)),
+    hcalScale_(std::move(hcalScale)),
+    extraChecksums_(extraChecksums),
+    fingerprint_(std::move(fingerprint)),
+    document_(std::make_unique<LUTDocument>(parameters_, luts_))
+  {
+    document_->setExtraChecksums(extraChecksums_);
+    document_->setDeltaContexts(deltaContexts);
+    document_->prepare(numberOfThreads);
+  }
+
+}
@@ -0,0 +1,2 @@
+#include "DataFormats/Common/interface/Wrapper.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTProduct.h"
@@ -0,0 +1,112 @@
+// -*- C++ -*-
+//
+// Package:    L1Trigger/L1TCaloLayer1LUTWriter
+// Program:    testFirmwareLayout
+//
+// caloLUTWord, hfLUTWord and the whole table repacks of FirmwareLayout.h
+// against the runtime packing they replaced, for firmware versions -1 to
+// 5: every 16 bit ECAL/HCAL word (L1TCaloLayer1FetchLUTs fills 15), each
+// bit above, and every 16 bit HF output with each of the 4 feature bit
+// combinations.  Prints the first mismatches and exits with 1 if
+// anything differs.
+//
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/FirmwareLayout.h"
+
+using namespace calol1;
+
+namespace {
+
+  // The ECAL/HCAL packing of L1TCaloLayer1LUTWriter before FirmwareLayout
+  uint32_t oldCaloLUTWord(uint32_t oldValue, int firmwareVersion) {
+    if ( firmwareVersion <= 1 ) return oldValue;
+    uint32_t value{0};
+    value |= 0xff & oldValue;
+    value |= ((oldValue>>12) & 0b111)<<9;
+    value |= ((oldValue>>11) & 0b1)<<12;
+    value |= (0b00)<<13;
+    value |= ((oldValue>>10) & 0b1)<<15;
+    return value;
+  }
+
+  uint32_t oldHFLUTWord(uint32_t output, uint32_t fb, int firmwareVersion) {
+    if ( firmwareVersion > 2 ) {
+      return output | (fb << 9);
+    }
+    return output | (fb << 8);
+  }
+
+  unsigned int nFailures{0};
+
+  void check(uint32_t expected, uint32_t actual, const std::string& what) {
+    if ( actual == expected ) return;
+    if ( ++nFailures <= 10 ) {
+      std::cerr << what << ": expected 0x" << std::hex << expected << ", got 0x" << actual << std::dec << std::endl;
+    }
+  }
+
+}
+
+int main() {
+  constexpr uint32_t nValues = 1u << 16;
+  auto caloLUT = std::make_unique<CaloLUT>();
+  auto caloWords = std::make_unique<CaloLUT>();
+  auto hfLUT = std::make_unique<HFLUT>();
+  auto hfWords = std::make_unique<HFLUTWords>();
+
+  for(int firmwareVersion=-1; firmwareVersion<=5; ++firmwareVersion) {
+    const std::string version = "firmwareVersion " + std::to_string(firmwareVersion);
+
+    // Single words
+    for(uint32_t value=0; value<nValues; ++value) {
+      check(oldCaloLUTWord(value, firmwareVersion), caloLUTWord(value, firmwareVersion), version + " caloLUTWord");
+      for(uint32_t fb=0; fb<4; ++fb) {
+        check(oldHFLUTWord(value, fb, firmwareVersion), hfLUTWord(value, fb, firmwareVersion), version + " hfLUTWord");
+      }
+    }
+    for(uint32_t bit=16; bit<32; ++bit) {
+      for(uint32_t low : {0u, 0x7abcu, 0xffffu}) {
+        const uint32_t value = low | (1u << bit);
+        check(oldCaloLUTWord(value, firmwareVersion), caloLUTWord(value, firmwareVersion), version + " caloLUTWord");
+      }
+    }
+
+    // Whole tables, the 16 bit range spread over as many as it takes
+    for(uint32_t start=0; start<nValues; start+=caloLUTSize) {
+      uint32_t * in = (*caloLUT)[0][0].data();
+      for(size_t i=0; i<caloLUTSize; ++i) in[i] = (start + i) % nValues;
+      repackCaloLUT(*caloLUT, firmwareVersion, *caloWords);
+      for(size_t iEta=0; iEta<caloLUT->size(); ++iEta) {
+        for(size_t fb=0; fb<(*caloLUT)[iEta].size(); ++fb) {
+          for(size_t input=0; input<(*caloLUT)[iEta][fb].size(); ++input) {
+            check(oldCaloLUTWord((*caloLUT)[iEta][fb][input], firmwareVersion), (*caloWords)[iEta][fb][input], version + " repackCaloLUT");
+          }
+        }
+      }
+    }
+    for(uint32_t start=0; start<nValues; start+=hfLUTSize) {
+      uint32_t * in = (*hfLUT)[0].data();
+      for(size_t i=0; i<hfLUTSize; ++i) in[i] = (start + i) % nValues;
+      repackHFLUT(*hfLUT, firmwareVersion, *hfWords);
+      for(uint32_t fb=0; fb<hfWords->size(); ++fb) {
+        for(size_t hfEta=0; hfEta<hfLUT->size(); ++hfEta) {
+          for(size_t input=0; input<(*hfLUT)[hfEta].size(); ++input) {
+            check(oldHFLUTWord((*hfLUT)[hfEta][input], fb, firmwareVersion), (*hfWords)[fb][hfEta][input], version + " repackHFLUT");
+          }
+        }
+      }
+    }
+  }
+
+  if ( nFailures > 0 ) {
+    std::cerr << nFailures << " words differ from the runtime packing" << std::endl;
+    return 1;
+  }
+  std::cout << "FirmwareLayout: same words as the runtime packing for firmware versions -1 to 5" << std::endl;
+  return 0;
+}
@@ -8,8 +8,27 @@ process = cms.Process("L1TCaloLayer1LUTWriter",eras.Run2_2018)
 options = VarParsing()
 options.register('caloParams', '', VarParsing.multiplicity.singleton, VarParsing.varType.string, 'Input CaloParams location')
 options.register('runNumber', 1, VarParsing.multiplicity.singleton, VarParsing.varType.int, 'Run to analyze')
+options.register('runList', [], VarParsing.multiplicity.list, VarParsing.varType.int, 'Runs to sweep, one LUT file per distinct IOV (overrides runNumber)')
 options.register('outputFile', 'luts.xml', VarParsing.multiplicity.singleton, VarParsing.varType.string, 'Output XML File')
+options.register('compression', 'none', VarParsing.multiplicity.singleton, VarParsing.varType.string, 'Compress the output XML File: none, gzip or zstd')
+options.register('binaryFile', '', VarParsing.multiplicity.singleton, VarParsing.varType.string, 'Output binary LUT File (not written if empty)')
+options.register('snapshotFile', '', VarParsing.multiplicity.singleton, VarParsing.varType.string, 'Also write the LUT inputs for calol1LUTFromSnapshot (not written if empty)')
+options.register('extraChecksums', [], VarParsing.multiplicity.list, VarParsing.varType.string, 'Digests written next to each md5checksum: sha256, xxh64')
+options.register('deltaContexts', False, VarParsing.multiplicity.singleton, VarParsing.varType.bool, 'Write the CTP7 context tables as the rows differing from the processors ones')
 options.register('saveHcalScaleFile', False, VarParsing.multiplicity.singleton, VarParsing.varType.bool, 'Output HCAL Compression Scale File')
+options.register('hcalScaleFile', 'hcalScale.txt', VarParsing.multiplicity.singleton, VarParsing.varType.string, 'HCAL Compression Scale File name')
+options.register('hcalScaleBinaryFile', '', VarParsing.multiplicity.singleton, VarParsing.varType.string, 'Binary HCAL Compression Scale File (not written if empty)')
+options.register('force', False, VarParsing.multiplicity.singleton, VarParsing.varType.bool, 'Regenerate the LUTs even if their inputs did not change')
+options.register('numberOfThreads', 1, VarParsing.multiplicity.singleton, VarParsing.varType.int, 'Threads used to render the CTP7 contexts')
+options.register('pipelineChunkRows', 0, VarParsing.multiplicity.singleton, VarParsing.varType.int, 'Stream the XML in chunks of this many table rows (0 = render all tables first)')
+options.register('xmlWriter', 'libxml2', VarParsing.multiplicity.singleton, VarParsing.varType.string, 'XML writer: libxml2 or direct (same output, faster)')
+options.register('splitOutput', False, VarParsing.multiplicity.singleton, VarParsing.varType.bool, 'One file per context plus an index instead of outputFile')
+options.register('diffReference', '', VarParsing.multiplicity.singleton, VarParsing.varType.string, 'Earlier luts.xml or luts.bin to report changed LUT cells against')
+options.register('diffFile', '', VarParsing.multiplicity.singleton, VarParsing.varType.string, 'Also write the LUT changes as JSON')
+options.register('verify', False, VarParsing.multiplicity.singleton, VarParsing.varType.bool, 'Check every written LUT cell against L1TCaloLayer1FetchLUTs, failing the job on a mismatch')
+options.register('reportMetrics', False, VarParsing.multiplicity.singleton, VarParsing.varType.bool, 'Log the time of each LUT generation stage and the row/context/cache counters at the end')
+options.register('metricsFile', '', VarParsing.multiplicity.singleton, VarParsing.varType.string, 'Also write those metrics as JSON')
+options.register('sharedLUTs', False, VarParsing.multiplicity.singleton, VarParsing.varType.bool, 'Make the LUTs once per IOV in L1TCaloLayer1LUTProducer and write them from its Run product')
 options.parseArguments()
 
 # import of standard configurations
@@ -25,18 +44,58 @@ process.source = cms.Source('EmptySource',
 # Writes LUT for the only event to be processed - ignores data itself.
 process.maxEvents = cms.untracked.PSet( input = cms.untracked.int32(1) )
 
+# Sweep: one event (and lumi) per run in the list
+if options.runList:
+    process.source.firstRun = cms.untracked.uint32(options.runList[0])
+    process.source.numberEventsInLuminosityBlock = cms.untracked.uint32(1)
+    process.source.firstLuminosityBlockForEachRun = cms.untracked.VLuminosityBlockID(
+        *[cms.LuminosityBlockID(run, i+1) for i, run in enumerate(options.runList)])
+    process.maxEvents.input = len(options.runList)
+process.options.numberOfThreads = options.numberOfThreads
+
 process.load('L1Trigger.L1TCaloLayer1LUTWriter.l1tCaloLayer1LUTWriter_cfi')
 process.l1tCaloLayer1LUTWriter.fileName = options.outputFile
+process.l1tCaloLayer1LUTWriter.binaryFileName = options.binaryFile
+process.l1tCaloLayer1LUTWriter.snapshotFileName = options.snapshotFile
+process.l1tCaloLayer1LUTWriter.compression = options.compression
+process.l1tCaloLayer1LUTWriter.extraChecksums = options.extraChecksums
+process.l1tCaloLayer1LUTWriter.deltaContexts = options.deltaContexts
 process.l1tCaloLayer1LUTWriter.saveHcalScaleFile = options.saveHcalScaleFile
+process.l1tCaloLayer1LUTWriter.hcalScaleFileName = options.hcalScaleFile
+process.l1tCaloLayer1LUTWriter.hcalScaleBinaryFileName = options.hcalScaleBinaryFile
+process.l1tCaloLayer1LUTWriter.numberOfThreads = options.numberOfThreads
+process.l1tCaloLayer1LUTWriter.pipelineChunkRows = options.pipelineChunkRows
+process.l1tCaloLayer1LUTWriter.xmlWriter = options.xmlWriter
+process.l1tCaloLayer1LUTWriter.splitOutput = options.splitOutput
+process.l1tCaloLayer1LUTWriter.diffReference = options.diffReference
+process.l1tCaloLayer1LUTWriter.diffFileName = options.diffFile
+process.l1tCaloLayer1LUTWriter.verify = options.verify
+process.l1tCaloLayer1LUTWriter.reportMetrics = options.reportMetrics
+process.l1tCaloLayer1LUTWriter.metricsFileName = options.metricsFile
+process.l1tCaloLayer1LUTWriter.sweep = len(options.runList) > 0
+process.l1tCaloLayer1LUTWriter.force = options.force
 process.p = cms.Path(process.l1tCaloLayer1LUTWriter)
 process.schedule = cms.Schedule(process.p)
 
+if options.sharedLUTs:
+    process.load('L1Trigger.L1TCaloLayer1LUTWriter.l1tCaloLayer1LUTProducer_cfi')
+    process.l1tCaloLayer1LUTProducer.numberOfThreads = options.numberOfThreads
+    process.l1tCaloLayer1LUTProducer.extraChecksums = options.extraChecksums
+    process.l1tCaloLayer1LUTProducer.deltaContexts = options.deltaContexts
+    process.l1tCaloLayer1LUTProducer.decodeHcalScale = options.saveHcalScaleFile or len(options.snapshotFile) > 0
+    process.l1tCaloLayer1LUTWriter.extraChecksums = []
+    process.l1tCaloLayer1LUTWriter.deltaContexts = False
+    process.l1tCaloLayer1LUTWriter.lutProduct = 'l1tCaloLayer1LUTProducer'
+    process.p.insert(0, process.l1tCaloLayer1LUTProducer)
+
 #
 # Things that actually matter start here
 #
 
 # See  "L1Trigger/L1TCaloLayer1/src/UCTLayer1.hh" for explanation
 process.l1tCaloLayer1LUTWriter.firmwareVersion = 3
+if options.sharedLUTs:
+    process.l1tCaloLayer1LUTProducer.firmwareVersion = process.l1tCaloLayer1LUTWriter.firmwareVersion
 
 # Will affect the HCAL LUTs, and CaloParams if they are ever in GT...
 process.GlobalTag = GlobalTag(process.GlobalTag, '123X_mcRun3_2021_realistic_v13', '')
@@ -0,0 +1,118 @@
+// -*- C++ -*-
+//
+// Package:    L1Trigger/L1TCaloLayer1LUTWriter
+// Program:    testLUTDocumentThreads
+//
+// The CTP7_Phi contexts rendered on one thread against several: the
+// synthetic inputs of calol1LUTRegression (SyntheticLUTs.h) for every
+// firmware version and a few phi bin patterns, written with
+// numberOfThreads 1 and NTHREADS (default 8) through xmlTextWriter and
+// SWATCHXMLEmitter, whole and streamed, with and without deltaContexts,
+// must give the same bytes:
+//   testLUTDocumentThreads [NTHREADS]
+// The files are written to the current directory and kept if they
+// differ.  Exits with 0 if all are identical, 1 if not, 2 on error.
+//
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <libxml/xmlwriter.h>
+
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/CompressedXMLOutput.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/LUTDocument.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/SWATCHXMLEmitter.h"
+#include "L1Trigger/L1TCaloLayer1LUTWriter/bin/SyntheticLUTs.h"
+
+using namespace calol1;
+
+namespace {
+
+  // A fresh document to the closed file, as L1TCaloLayer1LUTWriter does
+  bool writeFile(const LUTParameters& parameters, const LUTArrays& luts, const std::string& fileName,
+                 bool direct, bool stream, bool delta, int numberOfThreads) {
+    LUTDocument document(parameters, luts);
+    document.setDeltaContexts(delta);
+    if ( !stream ) document.prepare(numberOfThreads);
+    if ( direct ) {
+      xmlOutputBufferPtr out = newXMLOutputBuffer(fileName, "none", 0);
+      if ( out == nullptr ) return false;
+      SWATCHXMLEmitter emitter(out);
+      bool written = stream ? document.writeXML(emitter, numberOfThreads, 64, 16) : document.writeXML(emitter);
+      return emitter.close() >= 0 && written;
+    }
+    xmlTextWriterPtr writer = newXMLTextWriter(fileName, "none", 0);
+    if ( writer == nullptr ) return false;
+    xmlTextWriterSetIndent(writer, 1);
+    xmlTextWriterSetIndentString(writer, BAD_CAST "  ");
+    bool written = stream ? document.writeXML(writer, numberOfThreads, 64, 16) : document.writeXML(writer);
+    xmlFreeTextWriter(writer);
+    return written;
+  }
+
+  std::string readFile(const std::string& fileName) {
+    std::ifstream in(fileName, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  }
+
+}
+
+int main(int argc, char ** argv) {
+  const int numberOfThreads = argc > 1 ? std::atoi(argv[1]) : 8;
+  if ( numberOfThreads < 2 ) {
+    std::cerr << "Usage: testLUTDocumentThreads [NTHREADS], NTHREADS at least 2 (default 8)" << std::endl;
+    return 2;
+  }
+
+  // No phi dependence, one bin per card, and cards sharing bins and the
+  // phi independent table
+  std::vector<unsigned int> distinct, mixed;
+  for(unsigned int card=0; card<36; ++card) {
+    distinct.push_back(1 + card);
+    mixed.push_back(card % 4 == 0 ? 0 : 1 + card % 5);
+  }
+  const std::vector< std::vector<unsigned int> > patterns = {{}, distinct, mixed};
+
+  const std::string serialName = "testLUTDocumentThreads_1.xml";
+  const std::string parallelName = "testLUTDocumentThreads_" + std::to_string(numberOfThreads) + ".xml";
+  unsigned int nCompared{0};
+  for(int firmwareVersion=1; firmwareVersion<=3; ++firmwareVersion) {
+    for(size_t pattern=0; pattern<patterns.size(); ++pattern) {
+      LUTParameters parameters;
+      LUTArrays luts;
+      synthetic::synthesize(firmwareVersion, patterns[pattern], patterns[pattern], patterns[pattern], parameters, luts);
+      for(bool delta : {false, true}) {
+        for(bool direct : {false, true}) {
+          for(bool stream : {false, true}) {
+            const std::string what = "firmwareVersion " + std::to_string(firmwareVersion) + ", phi bin pattern " + std::to_string(pattern)
+              + (direct ? ", direct" : ", libxml2") + (stream ? ", stream" : ", whole") + (delta ? ", delta" : "");
+            if ( !writeFile(parameters, luts, serialName, direct, stream, delta, 1)
+                 || !writeFile(parameters, luts, parallelName, direct, stream, delta, numberOfThreads) ) {
+              std::cerr << "Failed to write " << serialName << " or " << parallelName << " (" << what << ")" << std::endl;
+              return 2;
+            }
+            const std::string serial = readFile(serialName);
+            const std::string parallel = readFile(parallelName);
+            if ( serial.empty() || parallel != serial ) {
+              auto diff = std::mismatch(serial.begin(), serial.end(), parallel.begin(), parallel.end());
+              std::cerr << numberOfThreads << " threads write different bytes than 1 (" << what << ") from byte "
+                        << (diff.first - serial.begin()) << ", see " << serialName << " and " << parallelName << std::endl;
+              return 1;
+            }
+            ++nCompared;
+          }
+        }
+      }
+    }
+  }
+  std::remove(serialName.c_str());
+  std::remove(parallelName.c_str());
+  std::cout << nCompared << " outputs identical with 1 and " << numberOfThreads << " threads" << std::endl;
+  return 0;
+}
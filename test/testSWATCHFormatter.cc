@@ -0,0 +1,127 @@
+// -*- C++ -*-
+//
+// Package:    L1Trigger/L1TCaloLayer1LUTWriter
+// Program:    testSWATCHFormatter
+//
+// SWATCHFormatter against the std::stringstream formatting it replaced:
+// hex rows at every width (zero, which showbase writes without 0x,
+// included) and the four writeSWATCHVector list types.  Prints the first
+// mismatches and exits with 1 if anything differs.
+//
+
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "L1Trigger/L1TCaloLayer1LUTWriter/interface/SWATCHFormatter.h"
+
+using namespace calol1;
+
+namespace {
+
+  // The row formatting of L1TCaloLayer1LUTWriter before SWATCHFormatter
+  template<typename T>
+  std::string streamHex(const std::vector<T>& values, unsigned int width) {
+    std::stringstream output;
+    for(auto it=values.begin(); it!=values.end(); ++it) {
+      if ( it != values.begin() ) output << ", ";
+      output << std::showbase << std::internal << std::setfill('0') << std::setw(width) << std::hex << *it;
+    }
+    return output.str();
+  }
+
+  // writeSWATCHVector before SWATCHFormatter: int and unsigned int as is,
+  // double and unsigned long long through float
+  template<typename T>
+  std::string streamList(const std::vector<T>& vect) {
+    std::stringstream output;
+    for(auto it=vect.begin(); it!=vect.end(); ++it) {
+      if ( it != vect.begin() ) output << ", ";
+      if ( std::is_integral<T>::value && sizeof(T) <= sizeof(int) ) output << *it;
+      else output << (float) *it;
+    }
+    return output.str();
+  }
+
+  unsigned int nFailures{0};
+
+  void check(const std::string& expected, const std::string& actual, const std::string& what) {
+    if ( actual == expected ) return;
+    if ( ++nFailures <= 10 ) {
+      std::cerr << what << ": expected \"" << expected << "\", got \"" << actual << "\"" << std::endl;
+    }
+  }
+
+  template<typename T>
+  void checkHex(SWATCHFormatter& formatter, const std::vector<T>& values, unsigned int width, const std::string& what) {
+    formatter.formatHex(values.data(), values.size(), width);
+    check(streamHex(values, width), formatter.str(), what + " width " + std::to_string(width));
+  }
+
+  template<typename T>
+  void checkList(SWATCHFormatter& formatter, const std::vector<T>& vect, const std::string& what) {
+    check(streamList(vect), formatter.formatList(vect), what);
+  }
+
+}
+
+int main() {
+  SWATCHFormatter formatter;
+
+  // Single values, each on its own and every width up to past 64 bits
+  const std::vector<uint64_t> edges = {0, 1, 0xf, 0x10, 0xff, 0x100, 0xfff, 0xffff, 0x10000, 0xfffff, 0xffffff,
+                                       0xffffffff, 0x100000000ull, std::numeric_limits<uint64_t>::max()};
+  for(uint64_t value : edges) {
+    for(unsigned int width=0; width<=20; ++width) {
+      checkHex(formatter, std::vector<uint64_t>{value}, width, "value " + std::to_string(value));
+      if ( value <= std::numeric_limits<uint32_t>::max() ) {
+        checkHex(formatter, std::vector<uint32_t>{static_cast<uint32_t>(value)}, width, "uint32 value " + std::to_string(value));
+      }
+    }
+  }
+
+  // Rows as written: 28 (ECAL, HCAL) or 12 (HF) words at width 6, zeros
+  // among them, and layer1SecondStageLUT at width 10
+  std::mt19937 random(12345);
+  for(int row=0; row<1000; ++row) {
+    std::vector<uint32_t> words(row % 2 ? 28 : 12);
+    for(auto& word : words) {
+      const unsigned int bits = random() % 33;
+      word = ( bits == 0 ) ? 0 : static_cast<uint32_t>(random() >> (32-bits));
+    }
+    for(unsigned int width : {6, 10}) checkHex(formatter, words, width, "row " + std::to_string(row));
+  }
+  checkHex(formatter, std::vector<uint32_t>(), 6, "empty row");
+
+  // Vector params of each type writeSWATCHVector takes
+  checkList(formatter, std::vector<int>{}, "empty vector:int");
+  checkList(formatter, std::vector<int>{0}, "vector:int zero");
+  checkList(formatter, std::vector<int>{0, -1, 1, 42, -128, std::numeric_limits<int>::min(), std::numeric_limits<int>::max()}, "vector:int");
+  checkList(formatter, std::vector<unsigned int>{0, 1, 255, 65535, std::numeric_limits<unsigned int>::max()}, "vector:uint");
+  checkList(formatter, std::vector<double>{0., -0., 1., -1., 0.5, 0.1, 1./3., 1e-7, 1.5e-45, 123456.7, 1234567., 1e10, -2.5e-3,
+                                           3.4e38, std::numeric_limits<double>::infinity()}, "vector:float");
+  checkList(formatter, std::vector<unsigned long long int>{0, 1, 999999, 1000000, 1234567, 0xffffffffull,
+                                                           std::numeric_limits<unsigned long long int>::max()}, "vector:uint64");
+  std::vector<double> doubles;
+  std::vector<int> ints;
+  for(int i=0; i<1000; ++i) {
+    doubles.push_back(std::ldexp(static_cast<double>(random())/random.max() - 0.5, static_cast<int>(random() % 80) - 40));
+    ints.push_back(static_cast<int>(random()));
+  }
+  checkList(formatter, doubles, "random vector:float");
+  checkList(formatter, ints, "random vector:int");
+
+  if ( nFailures > 0 ) {
+    std::cerr << nFailures << " formatting differences from std::stringstream" << std::endl;
+    return 1;
+  }
+  std::cout << "SWATCHFormatter: same text as std::stringstream" << std::endl;
+  return 0;
+}